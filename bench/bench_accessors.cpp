@@ -0,0 +1,459 @@
+#include <berry/detail/system.hpp>
+
+// System:
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <unistd.h>
+
+// C++ Standard Library:
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Boost Library:
+#include <boost/filesystem.hpp>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/spawn.hpp>
+#include <berry/detail/pidfd.hpp>
+
+// Measures the latency of the process accessors on live child processes,
+// together with the number of system calls each call makes. The calls are
+// counted by interposing the libc wrappers Berry uses, the executable's
+// definitions win over libc's for libberry as well. Calls libc makes
+// internally (opendir opening the directory, for one) bypass the wrappers,
+// so the counts are lower bounds.
+//
+// Usage: bench_accessors [--samples N] [--children N] [--drop-caches]
+//    [--json]
+
+namespace
+{
+   enum call_kind
+   {
+      call_open,
+      call_read,
+      call_close,
+      call_readlink,
+      call_stat,
+      call_other,
+      call_kinds
+   };
+
+   char const* const call_names[call_kinds] = {
+      "open", "read", "close", "readlink", "stat", "other" };
+
+   std::size_t g_calls[call_kinds];
+
+   template<typename Function>
+   Function next_symbol(char const* name)
+   {
+      return reinterpret_cast<Function>(::dlsym(RTLD_NEXT, name));
+   }
+
+   // The mode argument only exists for flags creating a file.
+   bool takes_mode(int flags)
+   {
+#ifdef O_TMPFILE
+      return (flags & (O_CREAT | O_TMPFILE)) != 0;
+#else
+      return (flags & O_CREAT) != 0;
+#endif
+   }
+}
+
+extern "C"
+{
+   int open(char const* path, int flags, ...)
+   {
+      static auto const real = next_symbol<int (*)(char const*, int, ...)>(
+         "open");
+      ++g_calls[call_open];
+      if(!takes_mode(flags))
+         return real(path, flags);
+      va_list args;
+      va_start(args, flags);
+      ::mode_t const mode = va_arg(args, ::mode_t);
+      va_end(args);
+      return real(path, flags, mode);
+   }
+
+   int openat(int dirfd, char const* path, int flags, ...)
+   {
+      static auto const real =
+         next_symbol<int (*)(int, char const*, int, ...)>("openat");
+      ++g_calls[call_open];
+      if(!takes_mode(flags))
+         return real(dirfd, path, flags);
+      va_list args;
+      va_start(args, flags);
+      ::mode_t const mode = va_arg(args, ::mode_t);
+      va_end(args);
+      return real(dirfd, path, flags, mode);
+   }
+
+   ::ssize_t read(int fd, void* buffer, std::size_t size)
+   {
+      static auto const real =
+         next_symbol< ::ssize_t (*)(int, void*, std::size_t)>("read");
+      ++g_calls[call_read];
+      return real(fd, buffer, size);
+   }
+
+   ::ssize_t pread(int fd, void* buffer, std::size_t size, ::off_t offset)
+   {
+      static auto const real = next_symbol<
+         ::ssize_t (*)(int, void*, std::size_t, ::off_t)>("pread");
+      ++g_calls[call_read];
+      return real(fd, buffer, size, offset);
+   }
+
+   int close(int fd)
+   {
+      static auto const real = next_symbol<int (*)(int)>("close");
+      ++g_calls[call_close];
+      return real(fd);
+   }
+
+   ::ssize_t readlink(char const* path, char* buffer, std::size_t size)
+      throw()
+   {
+      static auto const real = next_symbol<
+         ::ssize_t (*)(char const*, char*, std::size_t)>("readlink");
+      ++g_calls[call_readlink];
+      return real(path, buffer, size);
+   }
+
+   ::ssize_t readlinkat(int dirfd, char const* path, char* buffer,
+      std::size_t size) throw()
+   {
+      static auto const real = next_symbol<
+         ::ssize_t (*)(int, char const*, char*, std::size_t)>("readlinkat");
+      ++g_calls[call_readlink];
+      return real(dirfd, path, buffer, size);
+   }
+
+   int stat(char const* path, struct ::stat* info) throw()
+   {
+      static auto const real = next_symbol<
+         int (*)(char const*, struct ::stat*)>("stat");
+      ++g_calls[call_stat];
+      return real(path, info);
+   }
+
+   int fstatat(int dirfd, char const* path, struct ::stat* info, int flags)
+      throw()
+   {
+      static auto const real = next_symbol<
+         int (*)(int, char const*, struct ::stat*, int)>("fstatat");
+      ++g_calls[call_stat];
+      return real(dirfd, path, info, flags);
+   }
+
+   int faccessat(int dirfd, char const* path, int mode, int flags) throw()
+   {
+      static auto const real = next_symbol<
+         int (*)(int, char const*, int, int)>("faccessat");
+      ++g_calls[call_stat];
+      return real(dirfd, path, mode, flags);
+   }
+
+   int kill(::pid_t pid, int sig) throw()
+   {
+      static auto const real = next_symbol<int (*)(::pid_t, int)>("kill");
+      ++g_calls[call_other];
+      return real(pid, sig);
+   }
+}
+
+// pidfd_open and pidfd_send_signal go through syscall(2), whose argument
+// count can't be told from its arguments. Berry's own wrappers are
+// interposed instead, libberry calls them through its PLT as well.
+int berry::detail::pidfd::open(berry::detail::process::pid_type pid)
+{
+   static auto const real = next_symbol<int (*)(int)>(
+      "_ZN5berry6detail5pidfd4openEi");
+   ++g_calls[call_other];
+   return real(pid);
+}
+
+int berry::detail::pidfd::send_signal(int fd, int sig)
+{
+   static auto const real = next_symbol<int (*)(int, int)>(
+      "_ZN5berry6detail5pidfd11send_signalEii");
+   ++g_calls[call_other];
+   return real(fd, sig);
+}
+
+namespace
+{
+   struct options
+   {
+      options()
+         : samples(2000), children(8), drop_caches(false), json(false)
+      { }
+
+      int samples;
+      int children;
+      bool drop_caches;
+      bool json;
+   };
+
+   struct result
+   {
+      std::string accessor;
+      std::string variant;
+      std::vector<double> microseconds;
+      std::size_t calls[call_kinds];
+   };
+
+   std::size_t g_sink = 0;
+
+   // Asks the kernel to forget dentries and inodes, which needs root.
+   bool drop_caches()
+   {
+      std::ofstream file("/proc/sys/vm/drop_caches");
+      file << "2\n";
+      return static_cast<bool>(file.flush());
+   }
+
+   // Samples fn(i) and the calls it makes. Setup isn't timed.
+   template<typename Setup, typename Function>
+   result measure(options const& opts, char const* accessor,
+      char const* variant, bool cold, Setup setup, Function fn)
+   {
+      result current;
+      current.accessor = accessor;
+      current.variant = variant;
+      std::fill(current.calls, current.calls + call_kinds, 0);
+      for(int i = 0; i < opts.samples; ++i)
+      {
+         if(cold && opts.drop_caches)
+            drop_caches();
+         setup(i);
+
+         std::size_t before[call_kinds];
+         std::copy(g_calls, g_calls + call_kinds, before);
+         auto const start = std::chrono::steady_clock::now();
+         fn(i);
+         std::chrono::duration<double, std::micro> const elapsed =
+            std::chrono::steady_clock::now() - start;
+         for(int kind = 0; kind < call_kinds; ++kind)
+            current.calls[kind] += g_calls[kind] - before[kind];
+         current.microseconds.push_back(elapsed.count());
+      }
+      std::sort(current.microseconds.begin(), current.microseconds.end());
+      return current;
+   }
+
+   double percentile(std::vector<double> const& sorted, double p)
+   {
+      std::size_t const index = static_cast<std::size_t>(
+         p * (sorted.size() - 1) + 0.5);
+      return sorted[index];
+   }
+
+   double calls_per_sample(result const& r, int samples)
+   {
+      std::size_t total = 0;
+      for(int kind = 0; kind < call_kinds; ++kind)
+         total += r.calls[kind];
+      return static_cast<double>(total) / samples;
+   }
+
+   void print_text(options const& opts, std::vector<result> const& results)
+   {
+      std::cout << opts.samples << " samples over " << opts.children
+         << " children" << (opts.drop_caches ? ", dropping caches" : "")
+         << "\n\n" << std::left << std::setw(24) << "accessor"
+         << std::setw(6) << "cache" << std::right << std::setw(10)
+         << "p50 us" << std::setw(10) << "p90 us" << std::setw(10)
+         << "p99 us" << std::setw(10) << "max us" << std::setw(10)
+         << "calls" << '\n';
+      for(std::size_t i = 0; i < results.size(); ++i)
+      {
+         result const& r = results[i];
+         std::cout << std::left << std::setw(24) << r.accessor
+            << std::setw(6) << r.variant << std::right << std::fixed
+            << std::setprecision(2) << std::setw(10)
+            << percentile(r.microseconds, 0.5) << std::setw(10)
+            << percentile(r.microseconds, 0.9) << std::setw(10)
+            << percentile(r.microseconds, 0.99) << std::setw(10)
+            << r.microseconds.back() << std::setw(10)
+            << calls_per_sample(r, opts.samples) << '\n';
+      }
+      std::cout << "\ncalls are lower bounds, calls made inside libc aren't "
+         << "seen\n";
+   }
+
+   void print_json(options const& opts, std::vector<result> const& results)
+   {
+      std::cout << "{\"samples\": " << opts.samples << ", \"children\": "
+         << opts.children << ", \"drop_caches\": "
+         << (opts.drop_caches ? "true" : "false")
+         << ", \"calls_are_lower_bounds\": true, \"results\": [";
+      for(std::size_t i = 0; i < results.size(); ++i)
+      {
+         result const& r = results[i];
+         std::cout << (i ? ", " : "") << "{\"accessor\": \"" << r.accessor
+            << "\", \"cache\": \"" << r.variant << "\""
+            << std::setprecision(6) << ", \"p50_us\": "
+            << percentile(r.microseconds, 0.5) << ", \"p90_us\": "
+            << percentile(r.microseconds, 0.9) << ", \"p99_us\": "
+            << percentile(r.microseconds, 0.99) << ", \"max_us\": "
+            << r.microseconds.back() << ", \"calls_per_sample\": {";
+         for(int kind = 0; kind < call_kinds; ++kind)
+         {
+            std::cout << (kind ? ", " : "") << '"' << call_names[kind]
+               << "\": " << static_cast<double>(r.calls[kind]) /
+                  opts.samples;
+         }
+         std::cout << "}}";
+      }
+      std::cout << "]}\n";
+   }
+
+   bool parse_arguments(int argc, char** argv, options& opts)
+   {
+      for(int i = 1; i < argc; ++i)
+      {
+         std::string const arg = argv[i];
+         bool const has_value = i + 1 < argc;
+         if(arg == "--samples" && has_value)
+            opts.samples = std::atoi(argv[++i]);
+         else if(arg == "--children" && has_value)
+            opts.children = std::atoi(argv[++i]);
+         else if(arg == "--drop-caches")
+            opts.drop_caches = true;
+         else if(arg == "--json")
+            opts.json = true;
+         else
+            return false;
+      }
+      return opts.samples > 0 && opts.children > 0;
+   }
+}
+
+int main(int argc, char** argv)
+{
+   options opts;
+   if(!parse_arguments(argc, argv, opts))
+   {
+      std::cerr << "Usage: bench_accessors [--samples N] [--children N] "
+         "[--drop-caches] [--json]\n";
+      return 1;
+   }
+   if(opts.drop_caches && !drop_caches())
+   {
+      std::cerr << "Can't write /proc/sys/vm/drop_caches\n";
+      return 1;
+   }
+
+   berry::unix_like::spawn_options spawn;
+   spawn.arguments.push_back("sleep");
+   spawn.arguments.push_back("3600");
+   spawn.stdin_mode = berry::unix_like::stdio_null;
+   spawn.stdout_mode = berry::unix_like::stdio_null;
+   std::vector<berry::unix_like::spawned_process> children;
+   std::vector<berry::pid_type> pids;
+   for(int i = 0; i < opts.children; ++i)
+   {
+      children.push_back(berry::unix_like::spawn("/bin/sleep", spawn));
+      pids.push_back(children.back().proc.pid());
+   }
+
+   // Cold samples construct a new process object on a rotating child, so
+   // nothing opened by a previous sample is reused. Warm samples reuse
+   // one object per child.
+   std::vector<berry::process> warm;
+   for(std::size_t i = 0; i < pids.size(); ++i)
+      warm.push_back(berry::process(pids[i]));
+   std::size_t const count = pids.size();
+   berry::process cold;
+   auto const cold_setup = [&](int) { cold = berry::process(); };
+   auto const no_setup = [](int) { };
+   auto const child = [&](int i) -> berry::process const&
+      {
+         return warm[i % count];
+      };
+
+   std::vector<result> results;
+   results.push_back(measure(opts, "process(pid)", "cold", true,
+      cold_setup, [&](int i) { cold = berry::process(pids[i % count]); }));
+
+   results.push_back(measure(opts, "name", "cold", true, cold_setup,
+      [&](int i)
+      {
+         cold = berry::process(pids[i % count]);
+         g_sink += cold.name().size();
+      }));
+   results.push_back(measure(opts, "name", "warm", false, no_setup,
+      [&](int i) { g_sink += child(i).name().size(); }));
+
+   results.push_back(measure(opts, "executable_path", "cold", true,
+      cold_setup, [&](int i)
+      {
+         cold = berry::process(pids[i % count]);
+         g_sink += cold.executable_path().native().size();
+      }));
+   results.push_back(measure(opts, "executable_path", "warm", false,
+      no_setup, [&](int i)
+      {
+         g_sink += child(i).executable_path().native().size();
+      }));
+
+   results.push_back(measure(opts, "bitness", "cold", true, cold_setup,
+      [&](int i)
+      {
+         cold = berry::process(pids[i % count]);
+         g_sink += cold.bitness();
+      }));
+   results.push_back(measure(opts, "bitness", "warm", false, no_setup,
+      [&](int i) { g_sink += child(i).bitness(); }));
+
+   results.push_back(measure(opts, "still_exists", "cold", true,
+      cold_setup, [&](int i)
+      {
+         cold = berry::process(pids[i % count]);
+         g_sink += cold.still_exists();
+      }));
+   results.push_back(measure(opts, "still_exists", "warm", false, no_setup,
+      [&](int i) { g_sink += child(i).still_exists(); }));
+
+   results.push_back(measure(opts, "get_current_process", "cold", true,
+      cold_setup, [&](int)
+      {
+         cold = berry::process(::getpid());
+         g_sink += cold.pid();
+      }));
+   results.push_back(measure(opts, "get_current_process", "warm", false,
+      no_setup, [&](int)
+      {
+         g_sink += berry::get_current_process().pid();
+      }));
+
+   for(std::size_t i = 0; i < children.size(); ++i)
+   {
+      children[i].proc.terminate(true);
+      berry::unix_like::wait_for_exit(children[i].proc);
+   }
+
+   if(opts.json)
+      print_json(opts, results);
+   else
+   {
+      print_text(opts, results);
+      std::cout << "\nchecksum " << g_sink << '\n';
+   }
+}
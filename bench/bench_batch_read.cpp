@@ -0,0 +1,167 @@
+#include <berry/detail/system.hpp>
+
+// C++ Standard Library:
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Boost Library:
+#include <boost/filesystem.hpp>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/process_entry.hpp>
+#include <berry/procfs_context.hpp>
+#include <berry/detail/batch_read.hpp>
+#include <berry/detail/parallel.hpp>
+#include <berry/detail/procfs.hpp>
+
+// Reads the stat file of every process three ways: one open/read/close per
+// file, the same spread over worker threads, and batched through io_uring
+// (or its fallback, if the kernel lacks support).
+//
+// Usage: bench_batch_read [processes] [directory]
+//    Without arguments the real ProcFS is read.
+
+namespace
+{
+   void create_tree(boost::filesystem::path const& base, int processes)
+   {
+      for(int i = 0; i < processes; ++i)
+      {
+         int const pid = i + 100;
+         boost::filesystem::path const dir = base / std::to_string(pid);
+         boost::filesystem::create_directories(dir);
+         std::ofstream stat((dir / "stat").c_str());
+         stat << pid << " (daemon-" << i % 64 << ") S 1";
+         for(int field = 5; field <= 52; ++field)
+            stat << " 0";
+         stat << '\n';
+      }
+   }
+
+   std::size_t synchronous()
+   {
+      std::size_t count = 0;
+      berry::process_snapshot snap(berry::create_process_snapshot());
+      while(berry::extract_next_process(snap))
+         ++count;
+      return count;
+   }
+
+   std::size_t batched()
+   {
+      std::size_t count = 0;
+      berry::process_snapshot snap(berry::create_process_snapshot(
+         berry::snapshot_batched));
+      while(berry::extract_next_process(snap))
+         ++count;
+      return count;
+   }
+
+   std::size_t parallel(unsigned workers)
+   {
+      namespace procfs = berry::detail::procfs;
+      std::shared_ptr<berry::unix_like::procfs_context const> const
+         context = berry::unix_like::get_default_procfs_context();
+      std::vector<berry::pid_type> pids;
+      context->list_processes(pids);
+
+      workers = berry::detail::worker_count(workers, pids.size());
+      std::vector<std::size_t> counts(workers);
+      berry::detail::parallel_for(pids.size(), workers,
+         [&](unsigned worker, std::size_t i)
+         {
+            char path[64];
+            std::snprintf(path, sizeof(path), "%d/stat", pids[i]);
+            char buffer[1024];
+            long const size = procfs::read_small_file(context->fd(), path,
+               buffer, sizeof(buffer));
+            procfs::stat_line line;
+            if(size > 0 && procfs::parse_stat(buffer, buffer + size, line))
+               ++counts[worker];
+         });
+
+      std::size_t count = 0;
+      for(std::size_t i = 0; i < counts.size(); ++i)
+         count += counts[i];
+      return count;
+   }
+
+   template<typename Function>
+   double best_of(int runs, Function fn, std::size_t& count)
+   {
+      double best = 0;
+      for(int i = 0; i < runs; ++i)
+      {
+         auto const start = std::chrono::steady_clock::now();
+         count = fn();
+         std::chrono::duration<double, std::milli> const elapsed =
+            std::chrono::steady_clock::now() - start;
+         if(i == 0 || elapsed.count() < best)
+            best = elapsed.count();
+      }
+      return best;
+   }
+
+   void print(char const* name, double milliseconds, std::size_t count)
+   {
+      std::cout << std::left << std::setw(20) << name << std::right
+         << std::fixed << std::setprecision(2) << std::setw(12)
+         << milliseconds << " ms" << std::setw(12)
+         << milliseconds * 1000 / std::max<std::size_t>(count, 1)
+         << " us/process  " << count << " processes\n";
+   }
+}
+
+int main(int argc, char** argv)
+{
+   int const processes = argc > 1 ? std::atoi(argv[1]) : 0;
+   if(argc > 1 && processes <= 0)
+   {
+      std::cerr << "Usage: bench_batch_read [processes] [directory]\n";
+      return 1;
+   }
+
+   boost::filesystem::path base;
+   if(processes > 0)
+   {
+      base = argc > 2 ? argv[2] :
+         boost::filesystem::temp_directory_path() /
+         boost::filesystem::unique_path("berry-batch-%%%%-%%%%");
+      std::cout << "Creating " << processes << " processes in " << base
+         << '\n';
+      create_tree(base, processes);
+      berry::unix_like::set_procfs_base(base);
+   }
+
+   berry::detail::procfs::batch_reader const probe(1, 1024);
+   std::cout << "io_uring: " << (probe.batched() ? "available" :
+      "unavailable, batches fall back to synchronous reads") << "\n\n";
+
+   std::size_t count = 0;
+   double const sync = best_of(5, synchronous, count);
+   print("synchronous", sync, count);
+
+   unsigned const cores = std::max(1u, std::thread::hardware_concurrency());
+   for(unsigned workers = 2; workers <= std::max(4u, cores); workers *= 2)
+   {
+      double const threaded = best_of(5, [&]() { return parallel(workers); },
+         count);
+      std::string const name = "parallel x" + std::to_string(workers);
+      print(name.c_str(), threaded, count);
+   }
+
+   double const batch = best_of(5, batched, count);
+   print("batched", batch, count);
+
+   if(processes > 0 && argc <= 2)
+      boost::filesystem::remove_all(base);
+}
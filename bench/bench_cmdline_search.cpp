@@ -0,0 +1,144 @@
+#include <berry/detail/system.hpp>
+
+// C++ Standard Library:
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Boost Library:
+#include <boost/filesystem.hpp>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/cmdline_search.hpp>
+
+// Searches the command lines of a synthetic ProcFS tree, once the way it
+// is done by hand (ifstream, std::string, regex on everything) and once
+// with search_cmdlines and an increasing number of workers.
+//
+// Usage: bench_cmdline_search [processes] [directory]
+
+namespace
+{
+   char const* const pattern = "java .*-Dservice=foo( |$)";
+
+   void create_tree(boost::filesystem::path const& base, int processes)
+   {
+      char const* const commands[] = {
+         "/usr/sbin/nginx\0-g\0daemon off;\0",
+         "/usr/bin/python3\0-m\0http.server\0" "8080\0",
+         "/lib/systemd/systemd-journald\0",
+         "/usr/bin/bash\0--login\0" };
+
+      for(int i = 0; i < processes; ++i)
+      {
+         boost::filesystem::path const dir =
+            base / std::to_string(i + 100);
+         boost::filesystem::create_directories(dir);
+         std::ofstream file((dir / "cmdline").c_str(), std::ios::binary);
+
+         // Every 8th process is a java service, every 1000th of those the
+         // one searched for.
+         if(i % 8 == 0)
+         {
+            file << "/usr/lib/jvm/bin/java" << '\0' << "-Xmx2g" << '\0'
+               << "-Dservice=" << (i % 8000 == 0 ? "foo" : "bar")
+               << '\0' << "-jar" << '\0' << "/opt/app.jar" << '\0';
+         }
+         else
+         {
+            std::size_t const which = i % 4;
+            char const* command = commands[which];
+            std::size_t size = 0;
+            while(command[size] || command[size + 1])
+               ++size;
+            file.write(command, size + 1);
+         }
+      }
+   }
+
+   std::size_t by_hand(boost::filesystem::path const& base)
+   {
+      std::regex const regex(pattern);
+      std::size_t matches = 0;
+      for(boost::filesystem::directory_iterator it(base), end;
+         it != end; ++it)
+      {
+         std::ifstream file((it->path() / "cmdline").c_str());
+         std::string line((std::istreambuf_iterator<char>(file)),
+            std::istreambuf_iterator<char>());
+         std::replace(line.begin(), line.end(), '\0', ' ');
+         if(std::regex_search(line, regex))
+            ++matches;
+      }
+      return matches;
+   }
+
+   template<typename Function>
+   double best_of(int runs, Function fn, std::size_t& matches)
+   {
+      double best = 0;
+      for(int i = 0; i < runs; ++i)
+      {
+         auto const start = std::chrono::steady_clock::now();
+         matches = fn();
+         std::chrono::duration<double, std::milli> const elapsed =
+            std::chrono::steady_clock::now() - start;
+         if(i == 0 || elapsed.count() < best)
+            best = elapsed.count();
+      }
+      return best;
+   }
+}
+
+int main(int argc, char** argv)
+{
+   int const processes = argc > 1 ? std::atoi(argv[1]) : 50000;
+   boost::filesystem::path const base = argc > 2 ? argv[2] :
+      boost::filesystem::temp_directory_path() /
+      boost::filesystem::unique_path("berry-bench-%%%%-%%%%");
+   if(processes <= 0)
+   {
+      std::cerr << "Usage: bench_cmdline_search [processes] [directory]\n";
+      return 1;
+   }
+
+   std::cout << "Creating " << processes << " processes in " << base
+      << '\n';
+   create_tree(base, processes);
+   berry::unix_like::set_procfs_base(base);
+
+   berry::cmdline_pattern const compiled(pattern);
+   std::cout << "Pattern: " << pattern << ", prefilter literal: \""
+      << compiled.literal() << "\"\n\n";
+
+   std::size_t matches = 0;
+   double const manual = best_of(3, [&]() { return by_hand(base); },
+      matches);
+   std::cout << std::setw(24) << "ifstream + regex" << std::fixed
+      << std::setprecision(1) << std::setw(12) << manual << " ms  "
+      << matches << " matches\n";
+
+   unsigned const cores = std::max(1u, std::thread::hardware_concurrency());
+   for(unsigned workers = 1; workers <= std::max(4u, cores); workers *= 2)
+   {
+      double const searched = best_of(3, [&]()
+         {
+            return berry::search_cmdlines(compiled, workers).size();
+         }, matches);
+      std::cout << std::setw(16) << "search_cmdlines x" << std::setw(2)
+         << workers << std::setw(12) << searched << " ms  " << matches
+         << " matches\n";
+   }
+
+   if(argc <= 2)
+      boost::filesystem::remove_all(base);
+}
@@ -0,0 +1,328 @@
+#include <berry/detail/system.hpp>
+
+// C++ Standard Library:
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Boost Library:
+#include <boost/filesystem.hpp>
+#include <boost/optional.hpp>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/process_entry.hpp>
+#include <berry/process_iterator.hpp>
+#include <berry/process_query.hpp>
+#include <berry/process_table.hpp>
+#include <berry/process_tree.hpp>
+#include <berry/procfs_context.hpp>
+
+// Runs the enumeration hot paths against a generated ProcFS tree of any
+// size, so they can be measured at the scale of a busy host instead of
+// against the handful of processes of a build machine.
+//
+// Usage: bench_scale [--processes N] [--depth N] [--names uniform|zipf|
+//    unique] [--pathological] [--runs N] [--json] [--directory PATH]
+
+namespace
+{
+   struct options
+   {
+      options()
+         : processes(10000), depth(8), names("zipf"), pathological(false),
+           runs(5), json(false), directory()
+      { }
+
+      int processes;
+      int depth;
+      std::string names;
+      bool pathological;
+      int runs;
+      bool json;
+      boost::filesystem::path directory;
+   };
+
+   struct result
+   {
+      std::string name;
+      std::size_t operations;
+      std::vector<double> milliseconds;
+   };
+
+   berry::pid_type const first_pid = 100;
+
+   // Names the kernel allows but careless parsers choke on: the stat name
+   // is delimited by the last ')', not by spaces.
+   char const* const pathological_names[] = {
+      ") S 1 (", "a b) R 99 (c", "((((((((", "))))))))", "tab\there",
+      "new\nline", " ", "%s%n%d" };
+
+   std::string make_name(options const& opts, std::mt19937& random,
+      std::discrete_distribution<int>& zipf, int index)
+   {
+      if(opts.pathological && index % 10 == 5)
+         return pathological_names[index / 10 % 8];
+
+      char name[32];
+      if(opts.names == "unique")
+         std::snprintf(name, sizeof(name), "proc-%d", index);
+      else if(opts.names == "uniform")
+         std::snprintf(name, sizeof(name), "daemon-%02d", index % 64);
+      else
+         std::snprintf(name, sizeof(name), "daemon-%02d", zipf(random));
+
+      // Like the kernel, keep at most 15 characters.
+      return std::string(name).substr(0, 15);
+   }
+
+   void write_stat(boost::filesystem::path const& dir, berry::pid_type pid,
+      std::string const& name, berry::pid_type parent)
+   {
+      std::ofstream stat((dir / "stat").c_str());
+      stat << pid << " (" << name << ") S " << parent << ' ' << pid << ' '
+         << pid << " 0 -1 4194560";
+      for(int field = 10; field <= 52; ++field)
+      {
+         if(field == 20)
+            stat << " 1";
+         else if(field == 22)
+            stat << ' ' << pid * 10;
+         else
+            stat << " 0";
+      }
+      stat << '\n';
+   }
+
+   // Returns the names in pid order.
+   std::vector<std::string> create_tree(options const& opts)
+   {
+      std::mt19937 random(42);
+      std::vector<double> weights;
+      for(int rank = 1; rank <= 64; ++rank)
+         weights.push_back(1.0 / rank);
+      std::discrete_distribution<int> zipf(weights.begin(), weights.end());
+
+      std::vector<std::string> names;
+      std::vector<int> parents;
+      std::vector<int> depths;
+      for(int i = 0; i < opts.processes; ++i)
+      {
+         // Attach to a recent process, walking up until the depth fits.
+         int parent = -1;
+         if(i > 0)
+         {
+            int const window = std::min(i, 1000);
+            parent = i - 1 - static_cast<int>(random() % window);
+            while(depths[parent] >= opts.depth)
+               parent = parents[parent];
+         }
+         parents.push_back(parent);
+         depths.push_back(parent == -1 ? 1 : depths[parent] + 1);
+         names.push_back(make_name(opts, random, zipf, i));
+
+         berry::pid_type const pid = first_pid + i;
+         boost::filesystem::path const dir =
+            opts.directory / std::to_string(pid);
+         boost::filesystem::create_directories(dir);
+         write_stat(dir, pid, names.back(),
+            parent == -1 ? 0 : first_pid + parent);
+         std::ofstream((dir / "comm").c_str()) << names.back() << '\n';
+         std::ofstream cmdline((dir / "cmdline").c_str(), std::ios::binary);
+         cmdline << "/usr/bin/" << names.back() << '\0' << "--id=" << i
+            << '\0';
+      }
+      return names;
+   }
+
+   template<typename Function>
+   result measure(char const* name, std::size_t operations, int runs,
+      Function fn)
+   {
+      result current;
+      current.name = name;
+      current.operations = operations;
+      for(int i = 0; i < runs; ++i)
+      {
+         auto const start = std::chrono::steady_clock::now();
+         fn();
+         std::chrono::duration<double, std::milli> const elapsed =
+            std::chrono::steady_clock::now() - start;
+         current.milliseconds.push_back(elapsed.count());
+      }
+      std::sort(current.milliseconds.begin(), current.milliseconds.end());
+      return current;
+   }
+
+   double median(std::vector<double> const& sorted)
+   {
+      std::size_t const middle = sorted.size() / 2;
+      return sorted.size() % 2 ? sorted[middle] :
+         (sorted[middle - 1] + sorted[middle]) / 2;
+   }
+
+   void print_text(options const& opts, std::vector<result> const& results)
+   {
+      std::cout << opts.processes << " processes, depth " << opts.depth
+         << ", " << opts.names << " names"
+         << (opts.pathological ? ", pathological" : "") << "\n\n";
+      std::cout << std::left << std::setw(28) << "benchmark" << std::right
+         << std::setw(12) << "min ms" << std::setw(12) << "median ms"
+         << std::setw(14) << "us/op" << '\n';
+      for(std::size_t i = 0; i < results.size(); ++i)
+      {
+         result const& r = results[i];
+         std::cout << std::left << std::setw(28) << r.name << std::right
+            << std::fixed << std::setprecision(2) << std::setw(12)
+            << r.milliseconds.front() << std::setw(12)
+            << median(r.milliseconds) << std::setw(14)
+            << median(r.milliseconds) * 1000 / r.operations << '\n';
+      }
+   }
+
+   void print_json(options const& opts, std::vector<result> const& results)
+   {
+      std::cout << "{\"processes\": " << opts.processes << ", \"depth\": "
+         << opts.depth << ", \"names\": \"" << opts.names
+         << "\", \"pathological\": "
+         << (opts.pathological ? "true" : "false") << ", \"runs\": "
+         << opts.runs << ", \"results\": [";
+      for(std::size_t i = 0; i < results.size(); ++i)
+      {
+         result const& r = results[i];
+         std::cout << (i ? ", " : "") << "{\"name\": \"" << r.name
+            << "\", \"operations\": " << r.operations << ", \"min_ms\": "
+            << std::setprecision(6) << r.milliseconds.front()
+            << ", \"median_ms\": " << median(r.milliseconds)
+            << ", \"max_ms\": " << r.milliseconds.back() << '}';
+      }
+      std::cout << "]}\n";
+   }
+
+   bool parse_arguments(int argc, char** argv, options& opts)
+   {
+      for(int i = 1; i < argc; ++i)
+      {
+         std::string const arg = argv[i];
+         bool const has_value = i + 1 < argc;
+         if(arg == "--processes" && has_value)
+            opts.processes = std::atoi(argv[++i]);
+         else if(arg == "--depth" && has_value)
+            opts.depth = std::atoi(argv[++i]);
+         else if(arg == "--names" && has_value)
+            opts.names = argv[++i];
+         else if(arg == "--runs" && has_value)
+            opts.runs = std::atoi(argv[++i]);
+         else if(arg == "--directory" && has_value)
+            opts.directory = argv[++i];
+         else if(arg == "--pathological")
+            opts.pathological = true;
+         else if(arg == "--json")
+            opts.json = true;
+         else
+            return false;
+      }
+      return opts.processes > 0 && opts.depth > 0 && opts.runs > 0 &&
+         (opts.names == "uniform" || opts.names == "zipf" ||
+            opts.names == "unique");
+   }
+}
+
+int main(int argc, char** argv)
+{
+   options opts;
+   if(!parse_arguments(argc, argv, opts))
+   {
+      std::cerr << "Usage: bench_scale [--processes N] [--depth N] "
+         "[--names uniform|zipf|unique] [--pathological] [--runs N] "
+         "[--json] [--directory PATH]\n";
+      return 1;
+   }
+
+   bool const keep = !opts.directory.empty();
+   if(!keep)
+   {
+      opts.directory = boost::filesystem::temp_directory_path() /
+         boost::filesystem::unique_path("berry-scale-%%%%-%%%%");
+   }
+   std::vector<std::string> const names = create_tree(opts);
+   berry::unix_like::set_procfs_base(opts.directory);
+
+   std::size_t const count = names.size();
+   berry::pid_type const last = first_pid + static_cast<int>(count) - 1;
+   std::string const& last_name = names.back();
+   std::size_t checksum = 0;
+   std::vector<result> results;
+
+   results.push_back(measure("snapshot", count, opts.runs, [&]()
+      {
+         berry::process_snapshot snap = berry::create_process_snapshot();
+         while(berry::extract_next_process(snap))
+            ++checksum;
+      }));
+
+   results.push_back(measure("iteration", count, opts.runs, [&]()
+      {
+         berry::process_list list;
+         for(berry::process_iterator it = list.begin(); it != list.end();
+            ++it)
+         {
+            checksum += it->name.size();
+         }
+      }));
+
+   results.push_back(measure("tree_build", count, opts.runs, [&]()
+      {
+         berry::process_tree tree;
+         checksum += tree.subtree(first_pid).size();
+      }));
+
+   results.push_back(measure("table_build", count, opts.runs, [&]()
+      {
+         berry::process_table table;
+         checksum += table.size();
+      }));
+
+   // The last pid is the worst case for anything scanning in pid order.
+   results.push_back(measure("lookup_by_pid", 1, opts.runs, [&]()
+      {
+         checksum += berry::get_entry_by_pid(last) ? 1 : 0;
+      }));
+
+   berry::process_table const table;
+   results.push_back(measure("lookup_by_pid_table", 1000, opts.runs, [&]()
+      {
+         for(int i = 0; i < 1000; ++i)
+            checksum += table.find(last - i % 997) ? 1 : 0;
+      }));
+
+   results.push_back(measure("lookup_by_name", 1, opts.runs, [&]()
+      {
+         checksum += berry::get_entry_by_name(last_name) ? 1 : 0;
+      }));
+
+   results.push_back(measure("lookup_by_name_missing", 1, opts.runs, [&]()
+      {
+         checksum += berry::process_query().with_name("not-running")
+            .find_first() ? 1 : 0;
+      }));
+
+   if(opts.json)
+      print_json(opts, results);
+   else
+   {
+      print_text(opts, results);
+      std::cout << "\nchecksum " << checksum << '\n';
+   }
+
+   if(!keep)
+      boost::filesystem::remove_all(opts.directory);
+}
@@ -0,0 +1,104 @@
+#include <berry/detail/system.hpp>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// C++ Standard Library:
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+
+// Berry:
+#include <berry/spawn.hpp>
+
+// Starts /bin/true repeatedly with fork+exec and with berry's spawn while
+// the parent holds an increasing amount of touched memory. fork has to
+// copy the page tables of the whole parent, posix_spawn doesn't.
+//
+// Usage: bench_spawn [iterations] [max MiB]
+
+namespace
+{
+   char const* const executable = "/bin/true";
+
+   double fork_exec(int iterations)
+   {
+      auto const start = std::chrono::steady_clock::now();
+      for(int i = 0; i < iterations; ++i)
+      {
+         ::pid_t const pid = ::fork();
+         if(pid == 0)
+         {
+            ::execl(executable, executable, static_cast<char*>(0));
+            ::_exit(127);
+         }
+         int status;
+         ::waitpid(pid, &status, 0);
+      }
+      std::chrono::duration<double, std::micro> const elapsed =
+         std::chrono::steady_clock::now() - start;
+      return elapsed.count() / iterations;
+   }
+
+   double berry_spawn(int iterations)
+   {
+      auto const start = std::chrono::steady_clock::now();
+      for(int i = 0; i < iterations; ++i)
+      {
+         berry::unix_like::spawned_process child =
+            berry::unix_like::spawn(executable);
+         berry::unix_like::wait_for_exit(child.proc);
+      }
+      std::chrono::duration<double, std::micro> const elapsed =
+         std::chrono::steady_clock::now() - start;
+      return elapsed.count() / iterations;
+   }
+}
+
+int main(int argc, char** argv)
+{
+   int const iterations = argc > 1 ? std::atoi(argv[1]) : 200;
+   std::size_t const max_mib = argc > 2 ? std::atoi(argv[2]) : 1024;
+   if(iterations <= 0)
+   {
+      std::cerr << "Usage: bench_spawn [iterations] [max MiB]\n";
+      return 1;
+   }
+
+   std::cout << std::setw(10) << "RSS MiB" << std::setw(16) << "fork+exec us"
+      << std::setw(16) << "spawn us" << '\n';
+
+   std::size_t const sizes[] = { 0, 64, 256, 1024, 4096 };
+   for(std::size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+   {
+      if(sizes[i] > max_mib)
+         break;
+
+      // Touch every page so it is really resident.
+      std::size_t const bytes = sizes[i] << 20;
+      void* memory = 0;
+      if(bytes)
+      {
+         memory = ::mmap(0, bytes, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+         if(memory == MAP_FAILED)
+         {
+            std::cerr << "Can't allocate " << sizes[i] << " MiB\n";
+            break;
+         }
+         std::memset(memory, 1, bytes);
+      }
+
+      double const forked = ::fork_exec(iterations);
+      double const spawned = ::berry_spawn(iterations);
+      std::cout << std::setw(10) << sizes[i] << std::fixed
+         << std::setprecision(1) << std::setw(16) << forked
+         << std::setw(16) << spawned << '\n';
+
+      if(memory)
+         ::munmap(memory, bytes);
+   }
+}
@@ -0,0 +1,153 @@
+/**
+ * @file build_id.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Public API to read the GNU build-id of executables and modules.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_BUILDID_HPP__
+#define __BERRY_BUILDID_HPP__ 1
+
+// C++ Standard Library:
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Boost Library:
+#include <boost/filesystem/path.hpp>
+#include <boost/optional.hpp>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/module.hpp>
+
+#ifdef BERRY_LINUX
+namespace berry
+{
+    /**
+     * @brief The raw bytes of a GNU build-id, usually 20 of them.
+     **/
+    typedef std::vector<unsigned char> build_id;
+
+    /**
+     * @brief Formats a build-id as lower case hex string.
+     *
+     * @param id The build-id.
+     * @return :string The hex string, as used by debuginfod and symbol stores.
+     **/
+    std::string to_hex(build_id const& id);
+
+    /**
+     * @brief Reads the build-id of an ELF file.
+     * Only the ELF header, the program headers and the note segments are
+     * read, the rest of the file is never touched.
+     *
+     * @param path The file to read.
+     * @return :optional< berry::build_id > Nothing if the file isn't readable,
+     * isn't an ELF file or has no build-id note.
+     **/
+    boost::optional<build_id> read_build_id(
+        boost::filesystem::path const& path);
+
+    /**
+     * @brief Caches build-ids by device, inode and modification time.
+     * A cache hit costs opening and stat'ing the file. Thread safe.
+     **/
+    class build_id_cache
+    {
+    private:
+        typedef std::tuple<std::uint64_t, std::uint64_t, std::int64_t,
+            std::int64_t> key_type;
+
+        mutable std::mutex m_mutex;
+        std::map<key_type, boost::optional<build_id> > m_entries;
+
+    public:
+        /**
+         * @brief Returns the build-id of a file.
+         *
+         * @param path The file to read.
+         * @return :optional< berry::build_id > The build-id.
+         * @see read_build_id
+         **/
+        boost::optional<build_id> get(boost::filesystem::path const& path);
+
+        /**
+         * @brief Returns the build-id of an opened file.
+         *
+         * @param fd A readable descriptor of the file, it isn't closed.
+         * @return :optional< berry::build_id > The build-id.
+         * @see read_build_id
+         **/
+        boost::optional<build_id> get(int fd);
+
+        /**
+         * @brief Returns the number of cached files.
+         *
+         * @return :size_t The number of files.
+         **/
+        std::size_t size() const;
+
+        /**
+         * @brief Drops all cached build-ids.
+         **/
+        void clear();
+    };
+
+    /**
+     * @brief Returns the process wide default build-id cache.
+     *
+     * @return :build_id_cache& The cache.
+     **/
+    build_id_cache& default_build_id_cache();
+
+    /**
+     * @brief Returns the build-id of a process' executable.
+     * The file is opened through /proc/<pid>/exe, so it is found even if it
+     * was deleted or lives inside of a container.
+     *
+     * @param proc The process.
+     * @param cache The cache to use.
+     * @return :optional< berry::build_id > The build-id.
+     **/
+    boost::optional<build_id> get_executable_build_id(process const& proc,
+        build_id_cache& cache = default_build_id_cache());
+
+    /**
+     * @brief Returns the build-ids of all executable modules of a process.
+     * Files are looked up in the root of the process. A file of the same
+     * path outside of it is only used if device and inode match the mapping.
+     *
+     * @param proc The process.
+     * @param cache The cache to use.
+     * @return :vector< pair< berry::module, optional< berry::build_id > > >
+     * The executable modules with their build-ids.
+     **/
+    std::vector<std::pair<module, boost::optional<build_id> > >
+        get_module_build_ids(process const& proc,
+            build_id_cache& cache = default_build_id_cache());
+}
+#endif // BERRY_LINUX
+
+#endif // __BERRY_BUILDID_HPP__
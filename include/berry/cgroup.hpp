@@ -0,0 +1,148 @@
+/**
+ * @file cgroup.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Public API to enumerate the processes of control groups.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_CGROUP_HPP__
+#define __BERRY_CGROUP_HPP__ 1
+
+// C++ Standard Library:
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Boost Library:
+#include <boost/filesystem/path.hpp>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/process_entry.hpp>
+
+#ifdef BERRY_LINUX
+namespace berry
+{
+    /**
+     * @brief Sets the mount point of the cgroup v2 hierarchy.
+     * By default /sys/fs/cgroup is used, or /sys/fs/cgroup/unified on
+     * hosts with the hybrid layout.
+     *
+     * @param root The new mount point, an empty path restores the default.
+     **/
+    void set_cgroup_root(boost::filesystem::path const& root);
+
+    /**
+     * @brief Returns the mount point of the cgroup v2 hierarchy.
+     * Safe to call while another thread sets it, functions reading cgroups
+     * use the root they started with.
+     *
+     * @return :filesystem3::path The mount point.
+     **/
+    boost::filesystem::path get_cgroup_root();
+
+    /**
+     * @brief Lists the processes of a cgroup by reading cgroup.procs.
+     * The cost depends on the size of the cgroup, not of the host.
+     *
+     * @param cgroup The cgroup as in /proc/<pid>/cgroup, e.g.
+     * "/system.slice/foo.service".
+     * @param recursive Whether to include the processes of child cgroups.
+     * @return :vector< pid_type > The pids in the order the kernel lists
+     * them, child cgroups after their parent.
+     **/
+    std::vector<pid_type> get_cgroup_processes(std::string const& cgroup,
+        bool recursive = false);
+
+    /**
+     * @brief Lists the threads of a cgroup by reading cgroup.threads.
+     *
+     * @param cgroup The cgroup as in /proc/<pid>/cgroup.
+     * @param recursive Whether to include the threads of child cgroups.
+     * @return :vector< pid_type > The tids.
+     **/
+    std::vector<pid_type> get_cgroup_threads(std::string const& cgroup,
+        bool recursive = false);
+
+    /**
+     * @brief Creates a snapshot of the processes of a cgroup.
+     * The snapshot works with extract_first_process, extract_next_process
+     * and process_tree like one of the whole system.
+     *
+     * @param cgroup The cgroup as in /proc/<pid>/cgroup.
+     * @param recursive Whether to include the processes of child cgroups.
+     * @param fields The snapshot_field values to record.
+     * @return :process_snapshot The created snapshot.
+     **/
+    process_snapshot create_cgroup_snapshot(std::string const& cgroup,
+        bool recursive = false, unsigned fields = 0);
+
+    /**
+     * @brief Maps every process to its cgroup.
+     * Built by walking the cgroup hierarchy once and reading every
+     * cgroup.procs, which takes one read per cgroup instead of one per
+     * process. Cgroup names are stored once.
+     **/
+    class cgroup_index
+    {
+    private:
+        std::vector<std::string> m_cgroups;
+        std::vector<std::pair<pid_type, std::size_t> > m_processes;
+
+    public:
+        /**
+         * @brief Builds the index for the whole hierarchy.
+         **/
+        cgroup_index();
+
+        /**
+         * @brief Builds the index for a subtree of the hierarchy.
+         *
+         * @param cgroup The root of the subtree.
+         **/
+        explicit cgroup_index(std::string const& cgroup);
+
+        /**
+         * @brief Looks up the cgroup of a process.
+         *
+         * @param pid The process' pid.
+         * @return :string const* The cgroup or null if the process wasn't
+         * part of the indexed hierarchy.
+         **/
+        std::string const* find(pid_type pid) const;
+
+        /**
+         * @brief Returns all indexed cgroups, parents before children.
+         *
+         * @return :vector< string > const& The cgroups.
+         **/
+        std::vector<std::string> const& cgroups() const;
+
+        /**
+         * @brief Returns the number of indexed processes.
+         *
+         * @return :size_t The number of processes.
+         **/
+        std::size_t size() const;
+    };
+}
+#endif // BERRY_LINUX
+
+#endif // __BERRY_CGROUP_HPP__
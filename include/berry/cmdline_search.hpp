@@ -0,0 +1,112 @@
+/**
+ * @file cmdline_search.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Public API to search the command lines of all processes.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_CMDLINESEARCH_HPP__
+#define __BERRY_CMDLINESEARCH_HPP__ 1
+
+// C++ Standard Library:
+#include <memory>
+#include <regex>
+#include <string>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/process_strings.hpp>
+
+#ifdef BERRY_HAS_PROCFS
+namespace berry
+{
+    /**
+     * @brief The syntax of a command line pattern.
+     **/
+    enum pattern_syntax
+    {
+        /**
+         * @brief An ECMAScript regular expression, matching anywhere.
+         **/
+        pattern_regex,
+
+        /**
+         * @brief A shell glob (*, ?, [...]) matching the whole command line.
+         **/
+        pattern_glob
+    };
+
+    /**
+     * @brief A precompiled command line pattern.
+     * Command lines are matched with their arguments joined by single
+     * spaces. The longest literal every match has to contain is extracted
+     * on construction, command lines lacking it are rejected by a substring
+     * search without running the pattern.
+     **/
+    class cmdline_pattern
+    {
+    private:
+        pattern_syntax m_syntax;
+        std::string m_pattern;
+        std::shared_ptr<std::regex const> m_regex;
+        std::string m_literal;
+
+    public:
+        /**
+         * @brief Compiles a pattern.
+         *
+         * @param pattern The pattern.
+         * @param syntax The pattern's syntax.
+         * @throw std::regex_error If a regular expression is invalid.
+         **/
+        explicit cmdline_pattern(std::string const& pattern,
+            pattern_syntax syntax = pattern_regex);
+
+        /**
+         * @brief Matches a joined command line.
+         *
+         * @param begin Start of the command line.
+         * @param end End of the command line.
+         * @return bool True on a match.
+         **/
+        bool matches(char const* begin, char const* end) const;
+
+        /**
+         * @brief Returns the literal used to prefilter command lines.
+         *
+         * @return :string const& The literal, empty if there is none.
+         **/
+        std::string const& literal() const;
+    };
+
+    /**
+     * @brief Searches the command lines of all processes.
+     * The processes are split between a pool of worker threads.
+     *
+     * @param pattern The pattern to match.
+     * @param workers The number of worker threads, 0 means one per core.
+     * @return :cmdline_column The matching processes with their command
+     * lines, sorted by pid.
+     **/
+    cmdline_column search_cmdlines(cmdline_pattern const& pattern,
+        unsigned workers = 0);
+}
+#endif // BERRY_HAS_PROCFS
+
+#endif // __BERRY_CMDLINESEARCH_HPP__
@@ -0,0 +1,118 @@
+/**
+ * @file batch_read.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Non-public batched reads of many small ProcFS files.
+ * 
+ * This file is part of Berry.
+ * 
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __BERRY_DETAIL_BATCH_READ_HPP__
+#define __BERRY_DETAIL_BATCH_READ_HPP__ 1
+
+// C++ Standard Library:
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Berry:
+#include <berry/detail/system.hpp>
+#include <berry/detail/process_detail.hpp>
+
+#ifdef BERRY_HAS_PROCFS
+namespace berry
+{
+    namespace detail
+    {
+        namespace procfs
+        {
+            /**
+             * @brief Reads the same small file of many processes at once.
+             * Where the kernel supports it, every file is read by a linked
+             * openat, read and close on an io_uring, so a whole batch costs
+             * a single system call. Otherwise the files are read one by one.
+             **/
+            class batch_reader
+            {
+            public:
+                // The io_uring, defined by the implementation.
+                struct ring;
+
+            private:
+                std::unique_ptr<ring> m_ring;
+                std::size_t m_capacity;
+                std::size_t m_slot_size;
+                std::vector<char> m_buffer;
+                std::vector<long> m_sizes;
+                std::vector<char> m_paths;
+                std::vector<char> m_finished;
+                std::uint32_t m_generation;
+
+                bool read_ring(int dirfd, std::size_t count);
+
+            public:
+                /**
+                 * @brief Creates a reader, setting up the io_uring if the
+                 * kernel supports it.
+                 * @param capacity The maximum number of files per batch.
+                 * @param slot_size The buffer size per file, longer files
+                 * are truncated.
+                 **/
+                batch_reader(std::size_t capacity, std::size_t slot_size);
+                ~batch_reader();
+
+                batch_reader(batch_reader const&) = delete;
+                batch_reader& operator=(batch_reader const&) = delete;
+
+                /**
+                 * @brief Returns whether batches go through io_uring.
+                 * @return bool False if the synchronous fallback is used.
+                 **/
+                bool batched() const;
+
+                /**
+                 * @brief Reads <pid>/<file> for a batch of pids.
+                 * @param dirfd Directory to resolve the paths against.
+                 * @param pids The pids.
+                 * @param count The number of pids, at most the capacity.
+                 * @param file The file in each pid directory.
+                 **/
+                void read(int dirfd, process::pid_type const* pids,
+                    std::size_t count, char const* file);
+
+                /**
+                 * @brief Returns the content read for the index'th pid.
+                 * @return char const* The content, valid until the next
+                 * batch.
+                 **/
+                char const* data(std::size_t index) const;
+
+                /**
+                 * @brief Returns the size read for the index'th pid.
+                 * @return long The number of bytes or -1 if the file
+                 * couldn't be read.
+                 **/
+                long size(std::size_t index) const;
+            };
+        }
+    }
+}
+#endif // BERRY_HAS_PROCFS
+
+#endif // __BERRY_DETAIL_BATCH_READ_HPP__
@@ -0,0 +1,149 @@
+/**
+ * @file instrumentation.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Recording of instrumentation counters.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_DETAIL_INSTRUMENTATION_HPP__
+#define __BERRY_DETAIL_INSTRUMENTATION_HPP__ 1
+
+// Berry:
+#include <berry/instrumentation.hpp>
+
+#ifdef BERRY_INSTRUMENTATION
+
+// C++ Standard Library:
+#include <chrono>
+#include <cstdint>
+
+namespace berry
+{
+    namespace detail
+    {
+        namespace instrumentation
+        {
+            /**
+             * @brief Attributes the work of the current thread to an API
+             * until destroyed. Nested scopes of the same API are ignored.
+             **/
+            class api_scope
+            {
+            private:
+                instrumented_api m_previous;
+                bool m_active;
+                std::chrono::steady_clock::time_point m_start;
+
+            public:
+                explicit api_scope(instrumented_api api);
+                ~api_scope();
+
+                api_scope(api_scope const&) = delete;
+                api_scope& operator=(api_scope const&) = delete;
+            };
+
+            /**
+             * @brief Counts system calls of the current API.
+             * @param count The number of calls.
+             **/
+            void count_syscalls(std::uint64_t count);
+
+            /**
+             * @brief Counts an open of the current API, one system call.
+             **/
+            void count_open();
+
+            /**
+             * @brief Counts a read of the current API, one system call.
+             * @param bytes The result of the read, failures add no bytes.
+             **/
+            void count_read(long long bytes);
+
+            /**
+             * @brief Counts a file read through io_uring, one open and its
+             * bytes. The system calls of the ring are counted separately.
+             * @param bytes The result of the read, failures add no bytes.
+             **/
+            void count_batched_read(long long bytes);
+
+            /**
+             * @brief Records the latency of a ProcFS operation which isn't
+             * scoped, e.g. one file of a batch.
+             * @param path The path, relative to the ProcFS root or absolute.
+             * @param directory Whether the path is listed, not read.
+             * @param elapsed The latency of the operation.
+             **/
+            void record_procfs(char const* path, bool directory,
+                std::chrono::nanoseconds elapsed);
+
+            /**
+             * @brief Records the latency of a ProcFS operation until
+             * destroyed.
+             **/
+            class procfs_timer
+            {
+            private:
+                char const* m_path;
+                bool m_directory;
+                std::chrono::steady_clock::time_point m_start;
+
+            public:
+                /**
+                 * @param path The path, relative to the ProcFS root or
+                 * absolute. Must outlive the timer.
+                 * @param directory Whether the path is listed, not read.
+                 **/
+                procfs_timer(char const* path, bool directory);
+                ~procfs_timer();
+
+                procfs_timer(procfs_timer const&) = delete;
+                procfs_timer& operator=(procfs_timer const&) = delete;
+            };
+        }
+    }
+}
+
+#   define BERRY_INSTRUMENT_API(api) \
+        ::berry::detail::instrumentation::api_scope berry_api_scope_(api)
+#   define BERRY_COUNT_SYSCALLS(count) \
+        ::berry::detail::instrumentation::count_syscalls(count)
+#   define BERRY_COUNT_OPEN() \
+        ::berry::detail::instrumentation::count_open()
+#   define BERRY_COUNT_READ(bytes) \
+        ::berry::detail::instrumentation::count_read(bytes)
+#   define BERRY_TIME_PROCFS(path, directory) \
+        ::berry::detail::instrumentation::procfs_timer berry_timer_(path, \
+            directory)
+#   define BERRY_COUNT_BATCHED_READ(bytes) \
+        ::berry::detail::instrumentation::count_batched_read(bytes)
+#   define BERRY_RECORD_PROCFS(path, directory, elapsed) \
+        ::berry::detail::instrumentation::record_procfs(path, directory, \
+            elapsed)
+#else
+#   define BERRY_INSTRUMENT_API(api) ((void)0)
+#   define BERRY_COUNT_SYSCALLS(count) ((void)0)
+#   define BERRY_COUNT_OPEN() ((void)0)
+#   define BERRY_COUNT_READ(bytes) ((void)0)
+#   define BERRY_TIME_PROCFS(path, directory) ((void)0)
+#   define BERRY_COUNT_BATCHED_READ(bytes) ((void)0)
+#   define BERRY_RECORD_PROCFS(path, directory, elapsed) \
+        ((void)sizeof(elapsed))
+#endif // BERRY_INSTRUMENTATION
+
+#endif // __BERRY_DETAIL_INSTRUMENTATION_HPP__
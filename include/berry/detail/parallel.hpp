@@ -0,0 +1,128 @@
+/**
+ * @file parallel.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Non-public helper to spread enumeration work over threads.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_DETAIL_PARALLEL_HPP__
+#define __BERRY_DETAIL_PARALLEL_HPP__ 1
+
+// C++ Standard Library:
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace berry
+{
+    namespace detail
+    {
+        /**
+         * @brief Returns the number of workers to use for a request.
+         * @param requested The requested number, 0 means one per core.
+         * @param items The number of items to process.
+         * @return unsigned The number of workers, at least one.
+         **/
+        inline unsigned worker_count(unsigned requested, std::size_t items)
+        {
+            unsigned workers = requested;
+            if(workers == 0)
+                workers = std::thread::hardware_concurrency();
+            if(workers == 0)
+                workers = 1;
+
+            // Spawning threads for a handful of items costs more than it
+            // saves.
+            std::size_t const min_items_per_worker = 64;
+            std::size_t const useful = items / min_items_per_worker + 1;
+            return static_cast<unsigned>(
+                std::min<std::size_t>(workers, useful));
+        }
+
+        /**
+         * @brief Calls fn(worker, item) for every item in [0, count).
+         * Items are handed out in small chunks from a shared counter, so
+         * slow items (e.g. processes with huge maps) don't stall a worker's
+         * whole share. The calling thread acts as worker 0. The first
+         * exception thrown by fn is rethrown after all workers finished.
+         * @param count The number of items.
+         * @param workers The number of workers as returned by worker_count.
+         * @param fn The function to call.
+         **/
+        template<typename Function>
+        void parallel_for(std::size_t count, unsigned workers, Function fn)
+        {
+            std::size_t const chunk = 16;
+            std::atomic<std::size_t> next(0);
+            std::exception_ptr error;
+            std::mutex error_mutex;
+
+            auto work = [&](unsigned worker)
+            {
+                try
+                {
+                    for(;;)
+                    {
+                        std::size_t const begin = next.fetch_add(chunk);
+                        if(begin >= count)
+                            break;
+
+                        std::size_t const end = std::min(begin + chunk, count);
+                        for(std::size_t i = begin; i < end; ++i)
+                            fn(worker, i);
+                    }
+                }
+                catch(...)
+                {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if(!error)
+                        error = std::current_exception();
+                    next = count;
+                }
+            };
+
+            // If the system refuses more threads, the ones we got do the work.
+            std::vector<std::thread> threads;
+            for(unsigned i = 1; i < workers; ++i)
+            {
+                try
+                {
+                    threads.push_back(std::thread(work, i));
+                }
+                catch(std::system_error const&)
+                {
+                    break;
+                }
+            }
+            work(0);
+            for(std::size_t i = 0; i < threads.size(); ++i)
+                threads[i].join();
+
+            if(error)
+                std::rethrow_exception(error);
+        }
+    }
+}
+
+#endif // __BERRY_DETAIL_PARALLEL_HPP__
@@ -0,0 +1,71 @@
+/**
+ * @file pidfd.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Non-public wrappers around Linux process file descriptors.
+ * 
+ * This file is part of Berry.
+ * 
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_DETAIL_PIDFD_HPP__
+#define __BERRY_DETAIL_PIDFD_HPP__ 1
+
+// Berry:
+#include <berry/detail/system.hpp>
+#include <berry/detail/process_detail.hpp>
+
+#ifdef BERRY_LINUX
+namespace berry
+{
+    namespace detail
+    {
+        namespace pidfd
+        {
+            /**
+             * @brief Opens a pidfd for a process.
+             * Older kernels lack pidfds, callers fall back to the pid then.
+             * @param pid The process' id.
+             * @return int The pidfd or -1 with errno set.
+             **/
+            int open(process::pid_type pid);
+            
+            /**
+             * @brief Sends a signal through a pidfd.
+             * @param fd The pidfd.
+             * @param sig The signal, 0 only checks whether the process exists.
+             * @return int 0 on success, -1 with errno set otherwise.
+             **/
+            int send_signal(int fd, int sig);
+            
+            /**
+             * @brief Duplicates a file descriptor, keeping -1 as -1.
+             * @param fd The descriptor to duplicate.
+             * @return int The new descriptor or -1.
+             **/
+            int duplicate(int fd);
+            
+            /**
+             * @brief Closes a file descriptor if valid and resets it to -1.
+             * @param fd The descriptor to close.
+             **/
+            void close(int& fd);
+        }
+    }
+}
+#endif // BERRY_LINUX
+
+#endif // __BERRY_DETAIL_PIDFD_HPP__
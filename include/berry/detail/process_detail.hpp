@@ -39,14 +39,21 @@ namespace berry
             
             struct process_data
             {
-                explicit inline process_data(pid_type pid = 0)
-                    : pid(pid)
+                explicit inline process_data(pid_type pid = 0,
+                    int pidfd = -1, int dirfd = -1)
+                    : pid(pid), pidfd(pidfd), dirfd(dirfd)
                 { }
                 
                 pid_type pid;
+                
+                // Refers to the process itself, immune to pid reuse.
+                int pidfd;
+                
+                // The process' open ProcFS directory.
+                int dirfd;
             };
 
-#           define BERRY_PROCESS_AS_PARAM process
+#           define BERRY_PROCESS_AS_PARAM process const&
 #endif
         
 #ifdef BERRY_WINDOWS
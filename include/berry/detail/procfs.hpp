@@ -0,0 +1,256 @@
+/**
+ * @file procfs.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Non-public helpers to read and parse ProcFS files.
+ * 
+ * This file is part of Berry.
+ * 
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_DETAIL_PROCFS_HPP__
+#define __BERRY_DETAIL_PROCFS_HPP__ 1
+
+// C++ Standard Library:
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Boost Library:
+#include <boost/filesystem/path.hpp>
+
+// Berry:
+#include <berry/detail/system.hpp>
+#include <berry/detail/process_detail.hpp>
+#include <berry/procfs_context.hpp>
+
+#ifdef BERRY_HAS_PROCFS
+namespace berry
+{
+    namespace detail
+    {
+        namespace procfs
+        {
+            /**
+             * @brief The fields of a stat file Berry cares about.
+             * The name points into the parsed buffer and isn't terminated.
+             **/
+            struct stat_line
+            {
+                process::pid_type pid;
+                char const* name;
+                std::size_t name_size;
+                char state;
+                process::pid_type parent_pid;
+                std::uint64_t user_time;
+                std::uint64_t system_time;
+                std::uint64_t thread_count;
+                std::uint64_t start_time;
+                int processor;
+            };
+
+            /**
+             * @brief The fields of a maps line.
+             * The permissions and the path point into the parsed buffer,
+             * the path isn't terminated and empty for anonymous memory.
+             **/
+            struct maps_line
+            {
+                std::uint64_t begin;
+                std::uint64_t end;
+                char const* permissions;
+                std::uint64_t offset;
+                std::uint64_t device;
+                std::uint64_t inode;
+                char const* path;
+                std::size_t path_size;
+            };
+
+            /**
+             * @brief Returns the default ProcFS context.
+             * Callers keep the returned pointer for the whole operation, so
+             * a concurrent change of the default doesn't affect them.
+             * @param caller Prefix of the error message.
+             * @return :shared_ptr< berry::unix_like::procfs_context const >
+             * The default context.
+             * @throw std::runtime_error If there is no default context.
+             **/
+            std::shared_ptr<unix_like::procfs_context const> context(
+                char const* caller);
+
+            /**
+             * @brief Opens a file of a process' ProcFS directory for reading.
+             * @param dirfd The process' directory, -1 to resolve the pid in
+             * the default context instead.
+             * @param pid The process' id.
+             * @param file The file, relative to the process' directory.
+             * @return int The descriptor or -1 with errno set.
+             **/
+            int open_process_file(int dirfd, process::pid_type pid,
+                std::string const& file);
+
+            /**
+             * @brief Reads a small file with a single read.
+             * @param dirfd Directory to resolve path against, -1 for none.
+             * @param path The file to read.
+             * @param buffer The buffer to read into.
+             * @param size The size of the buffer.
+             * @return long The number of bytes read or -1.
+             **/
+            long read_small_file(int dirfd, char const* path, char* buffer,
+                std::size_t size);
+
+            /**
+             * @brief Lists the numeric entries of a directory.
+             * Used for the pid directories of /proc and the tid directories
+             * of /proc/<pid>/task.
+             * @param dirfd Directory to resolve path against, -1 for none.
+             * @param path The directory to list.
+             * @param out Receives the numbers, previous content is kept.
+             * @return bool False if the directory couldn't be opened.
+             **/
+            bool list_numeric_entries(int dirfd, char const* path,
+                std::vector<process::pid_type>& out);
+
+            /**
+             * @brief Creates a process snapshot over a given list of pids.
+             * Lets other enumeration sources (e.g. cgroups) feed the same
+             * extraction functions as the /proc walk.
+             * @param pids The pids, entries of exited processes are skipped
+             * on extraction.
+             * @param fields The snapshot_field values to record.
+             * @return :shared_ptr< void > The snapshot.
+             **/
+            std::shared_ptr<void> make_process_snapshot(
+                std::vector<process::pid_type> pids, unsigned fields = 0);
+
+            /**
+             * @brief Parses the content of a stat file without allocating.
+             * The name is delimited by the last ')' in the line, so names
+             * containing spaces or parentheses are handled.
+             * @param begin Start of the content.
+             * @param end End of the content.
+             * @param out Receives the parsed fields.
+             * @return bool False if the content is malformed.
+             **/
+            bool parse_stat(char const* begin, char const* end,
+                stat_line& out);
+
+            /**
+             * @brief Parses one line of a maps file without allocating.
+             * begin-end perms offset major:minor inode [path]
+             * @param begin Start of the line.
+             * @param end End of the line, without the newline.
+             * @param out Receives the parsed fields.
+             * @return bool False if the line is malformed.
+             **/
+            bool parse_maps_line(char const* begin, char const* end,
+                maps_line& out);
+
+            /**
+             * @brief Returns the number of clock ticks per second.
+             * @return :uint64_t The clock tick rate used by stat files.
+             **/
+            std::uint64_t clock_ticks();
+
+            /**
+             * @brief Reads a whole file into the buffer.
+             * ProcFS files report a size of zero, so the file is read in
+             * chunks until EOF, reusing the buffer's capacity.
+             * @param dirfd Directory to resolve path against, -1 for none.
+             * @param path The file to read.
+             * @param buffer Receives the content.
+             * @return bool False if the file couldn't be opened or read,
+             * which usually means the process vanished.
+             **/
+            bool read_file(int dirfd, char const* path,
+                std::vector<char>& buffer);
+
+            /**
+             * @brief Appends a whole file to the buffer.
+             * Reads straight into the buffer's spare capacity, so a reused
+             * buffer usually needs a single read. A short read is taken as
+             * end of file, which holds for the generated ProcFS files it is
+             * used for (cmdline, environ).
+             * @param dirfd Directory to resolve path against, -1 for none.
+             * @param path The file to read.
+             * @param buffer Receives the content behind the existing one.
+             * @return long The number of bytes appended or -1.
+             **/
+            long append_file(int dirfd, char const* path,
+                std::vector<char>& buffer);
+
+            /**
+             * @brief Outcome of read_file_bounded.
+             **/
+            enum bounded_result
+            {
+                bounded_read_ok,
+                bounded_read_failed,
+                bounded_read_timed_out
+            };
+
+            /**
+             * @brief Reads a whole file on a helper thread, giving up after
+             * a deadline.
+             * Files like cmdline, environ and maps take the target's mm lock
+             * and block for as long as the target sleeps uninterruptibly
+             * while holding it. Such a read can't be cancelled, so the
+             * helper thread is left behind and replaced by a new one. Once
+             * the pool is full of such helpers, reads time out at once.
+             * @param context The context path is resolved against, kept
+             * alive until the read returned.
+             * @param path The file to read.
+             * @param buffer Receives the content, empty unless the read
+             * succeeded.
+             * @param timeout The time to wait for the read.
+             * @return bounded_result Whether the read succeeded, failed or
+             * timed out.
+             **/
+            bounded_result read_file_bounded(
+                std::shared_ptr<unix_like::procfs_context const> const&
+                    context,
+                char const* path, std::vector<char>& buffer,
+                std::chrono::steady_clock::duration timeout);
+
+            /**
+             * @brief Parses a hexadecimal number without prefix.
+             * @return char const* Pointer past the last consumed character.
+             **/
+            char const* parse_hex(char const* it, char const* end,
+                std::uint64_t& out);
+
+            /**
+             * @brief Parses an unsigned decimal number.
+             * @return char const* Pointer past the last consumed character.
+             **/
+            char const* parse_decimal(char const* it, char const* end,
+                std::uint64_t& out);
+
+            /**
+             * @brief Skips spaces and tabs.
+             * @return char const* Pointer to the first other character.
+             **/
+            char const* skip_blanks(char const* it, char const* end);
+        }
+    }
+}
+#endif // BERRY_HAS_PROCFS
+
+#endif // __BERRY_DETAIL_PROCFS_HPP__
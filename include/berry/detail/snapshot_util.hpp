@@ -0,0 +1,80 @@
+/**
+ * @file snapshot_util.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Non-public helpers shared by the snapshot based process views.
+ * 
+ * This file is part of Berry.
+ * 
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_DETAIL_SNAPSHOT_UTIL_HPP__
+#define __BERRY_DETAIL_SNAPSHOT_UTIL_HPP__ 1
+
+// C++ Standard Library:
+#include <vector>
+
+// Berry:
+#include <berry/detail/system.hpp>
+#include <berry/process_entry.hpp>
+
+namespace berry
+{
+    namespace detail
+    {
+        namespace snapshot_util
+        {
+            /**
+             * @brief Orders process entries by pid.
+             **/
+            bool pid_less(process_entry const& lhs,
+                process_entry const& rhs);
+            
+            /**
+             * @brief Compares an entry to a pid, for lower_bound on entries
+             * sorted by pid_less.
+             **/
+            bool entry_before(process_entry const& entry,
+                process::pid_type pid);
+            
+            /**
+             * @brief Extracts the remaining entries of a snapshot.
+             * @param snap The snapshot to extract from.
+             * @return vector The entries in snapshot order.
+             **/
+            std::vector<process_entry> drain(process_snapshot& snap);
+            
+            /**
+             * @brief Extracts all entries of a new snapshot.
+             * @return vector The entries in snapshot order.
+             **/
+            std::vector<process_entry> drain_new();
+            
+#ifdef BERRY_LINUX
+            /**
+             * @brief Extracts all entries of a new snapshot recording
+             * optional fields.
+             * @param fields The snapshot_field values to record.
+             * @return vector The entries in snapshot order, empty if the
+             * snapshot has none.
+             **/
+            std::vector<process_entry> drain_new(unsigned fields);
+#endif
+        }
+    }
+}
+
+#endif // __BERRY_DETAIL_SNAPSHOT_UTIL_HPP__
@@ -0,0 +1,289 @@
+/**
+ * @file instrumentation.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Public API to read Berry's instrumentation counters.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_INSTRUMENTATION_HPP__
+#define __BERRY_INSTRUMENTATION_HPP__ 1
+
+// C++ Standard Library:
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Berry:
+#include <berry/process.hpp>
+
+namespace berry
+{
+    /**
+     * @brief The public functions counters are kept for.
+     * Work done outside of them is counted as api_other.
+     **/
+    enum instrumented_api
+    {
+        api_create_snapshot,
+        api_extract_process,
+        api_process_name,
+        api_executable_path,
+        api_bitness,
+        api_still_exists,
+        api_read_memory,
+        api_other,
+        api_count
+    };
+
+    /**
+     * @brief The counters of one API.
+     **/
+    struct api_stats
+    {
+        api_stats();
+
+        /**
+         * @brief Number of calls. Calls the API makes to itself aren't
+         * counted again.
+         **/
+        std::uint64_t calls;
+
+        /**
+         * @brief Number of system calls, including opens and reads.
+         **/
+        std::uint64_t syscalls;
+
+        /**
+         * @brief Number of opened files and directories.
+         **/
+        std::uint64_t opens;
+
+        /**
+         * @brief Number of bytes read from files or remote memory.
+         **/
+        std::uint64_t bytes_read;
+
+        /**
+         * @brief Wall time spent in the API, including other APIs it calls.
+         **/
+        std::uint64_t nanoseconds;
+    };
+
+    /**
+     * @brief The counters of all APIs, summed over all threads.
+     **/
+    struct instrumentation_stats
+    {
+        api_stats apis[api_count];
+    };
+
+    /**
+     * @brief Returns whether Berry was built with instrumentation.
+     * It's enabled with the ENABLE_INSTRUMENTATION CMake option. Without
+     * it, no counting code is compiled in and all counters stay 0.
+     *
+     * @return bool True if counters are recorded.
+     **/
+    bool instrumentation_enabled();
+
+    /**
+     * @brief Sums the counters of all threads, including exited ones.
+     * Counters are never reset, subtract an earlier result to get the work
+     * done in between.
+     *
+     * @return :instrumentation_stats The counters.
+     **/
+    instrumentation_stats get_instrumentation_stats();
+
+    /**
+     * @brief Returns the name of an API, e.g. "process::name".
+     *
+     * @param api The API.
+     * @return char const* The name.
+     **/
+    char const* get_api_name(instrumented_api api);
+
+    /**
+     * @brief Subtracts two results of get_instrumentation_stats.
+     *
+     * @param later The later result.
+     * @param earlier The earlier result.
+     * @return :instrumentation_stats The counts in between.
+     **/
+    instrumentation_stats operator-(instrumentation_stats const& later,
+        instrumentation_stats const& earlier);
+
+    /**
+     * @brief The kinds of ProcFS operations latencies are recorded for.
+     * Reads are told apart by the name of the file.
+     **/
+    enum procfs_operation
+    {
+        procfs_list_directory,
+        procfs_read_stat,
+        procfs_read_status,
+        procfs_read_comm,
+        procfs_read_cmdline,
+        procfs_read_environ,
+        procfs_read_maps,
+        procfs_read_other,
+        procfs_operation_count
+    };
+
+    /**
+     * @brief A copy of a latency histogram.
+     * Buckets grow logarithmically with 16 linear sub-buckets per power of
+     * two, so every recorded value is known within 1/16 of itself, from
+     * nanoseconds to hours.
+     **/
+    class latency_histogram
+    {
+    private:
+        std::vector<std::uint64_t> m_counts;
+        std::uint64_t m_total;
+
+    public:
+        /**
+         * @brief The number of buckets.
+         **/
+        static std::size_t const bucket_count = 976;
+
+        /**
+         * @brief Creates an empty histogram.
+         **/
+        latency_histogram();
+
+        /**
+         * @brief Creates a histogram from bucket counts.
+         *
+         * @param counts bucket_count counts.
+         **/
+        explicit latency_histogram(std::vector<std::uint64_t> counts);
+
+        /**
+         * @brief Returns the number of recorded operations.
+         *
+         * @return :uint64_t The number of operations.
+         **/
+        std::uint64_t count() const;
+
+        /**
+         * @brief Returns the latency at or below which a share of the
+         * operations completed.
+         *
+         * @param percentile The share in percent, e.g. 99.9.
+         * @return :nanoseconds The upper bound of the bucket holding the
+         * percentile, 0 if the histogram is empty.
+         **/
+        std::chrono::nanoseconds value_at_percentile(double percentile) const;
+
+        /**
+         * @brief Returns the counts of all buckets.
+         *
+         * @return :vector< uint64_t > const& The counts.
+         **/
+        std::vector<std::uint64_t> const& counts() const;
+
+        /**
+         * @brief Returns the smallest latency of a bucket.
+         *
+         * @param bucket The bucket's index.
+         * @return :nanoseconds The lower bound.
+         **/
+        static std::chrono::nanoseconds lower_bound(std::size_t bucket);
+
+        /**
+         * @brief Returns the largest latency of a bucket.
+         *
+         * @param bucket The bucket's index.
+         * @return :nanoseconds The upper bound.
+         **/
+        static std::chrono::nanoseconds upper_bound(std::size_t bucket);
+    };
+
+    /**
+     * @brief A ProcFS operation which took longer than the threshold.
+     **/
+    struct slow_operation
+    {
+        slow_operation();
+
+        /**
+         * @brief The process the file belongs to, 0 if unknown.
+         **/
+        pid_type pid;
+
+        /**
+         * @brief The kind of operation.
+         **/
+        procfs_operation operation;
+
+        /**
+         * @brief The path as passed to the operation, truncated to 31
+         * characters. Paths are usually relative to the ProcFS root.
+         **/
+        char file[32];
+
+        /**
+         * @brief How long the operation took.
+         **/
+        std::chrono::nanoseconds duration;
+
+        /**
+         * @brief When the operation ended.
+         **/
+        std::chrono::system_clock::time_point time;
+    };
+
+    /**
+     * @brief Returns the name of a ProcFS operation, e.g. "read stat".
+     *
+     * @param operation The operation.
+     * @return char const* The name.
+     **/
+    char const* get_procfs_operation_name(procfs_operation operation);
+
+    /**
+     * @brief Copies the latency histogram of a ProcFS operation.
+     * Histograms are only recorded if instrumentation is enabled.
+     *
+     * @param operation The operation.
+     * @return :latency_histogram The histogram since the start.
+     **/
+    latency_histogram get_procfs_latency(procfs_operation operation);
+
+    /**
+     * @brief Sets the duration above which operations are recorded as
+     * slow operations. The default is 10 milliseconds.
+     *
+     * @param threshold The new threshold.
+     **/
+    void set_slow_operation_threshold(std::chrono::nanoseconds threshold);
+
+    /**
+     * @brief Returns the most recent slow operations.
+     * They are kept in a ring of 128 entries, older ones are overwritten.
+     *
+     * @return :vector< berry::slow_operation > The operations, oldest
+     * first.
+     **/
+    std::vector<slow_operation> get_slow_operations();
+}
+
+#endif // __BERRY_INSTRUMENTATION_HPP__
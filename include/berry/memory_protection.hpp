@@ -20,7 +20,10 @@
  * You should have received a copy of the GNU General Public License
  * along with Berry. If not, see <http://www.gnu.org/licenses/>.
  */
- 
+
+#ifndef __BERRY_MEMORYPROTECTION_HPP__
+#define __BERRY_MEMORYPROTECTION_HPP__ 1
+
 // C++ Standard Library:
 #include <string>
 
@@ -114,3 +117,5 @@ namespace berry
         bool is_private() const;
     };
 }
+
+#endif // __BERRY_MEMORYPROTECTION_HPP__
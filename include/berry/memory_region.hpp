@@ -0,0 +1,100 @@
+/**
+ * @file memory_region.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Public API to list the mapped memory regions of a process.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_MEMORYREGION_HPP__
+#define __BERRY_MEMORYREGION_HPP__ 1
+
+// C++ Standard Library:
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/memory_protection.hpp>
+#include <berry/remote_memory.hpp>
+
+namespace berry
+{
+    /**
+     * @brief Describes one mapped range of memory inside a process.
+     **/
+    struct memory_region
+    {
+        memory_region();
+
+        /**
+         * @brief Returns whether the address lies inside of the region.
+         *
+         * @param address The address to check.
+         * @return bool True if begin <= address < end.
+         **/
+        bool contains(remote_address address) const;
+
+        /**
+         * @brief Returns the size of the region in bytes.
+         *
+         * @return :uint64_t The size.
+         **/
+        std::uint64_t size() const;
+
+        remote_address begin;
+        remote_address end;
+        memory_protection protection;
+        std::uint64_t offset;
+        std::uint64_t device;
+        std::uint64_t inode;
+        std::string path;
+    };
+
+    /**
+     * @brief Lists all memory regions of a process, sorted by address.
+     * On Linux this parses /proc/<pid>/maps. The path is the backing file,
+     * a pseudo name like [heap] or empty for anonymous memory.
+     *
+     * @param proc The process to inspect.
+     * @return :vector< berry::memory_region > The regions.
+     **/
+    std::vector<memory_region> get_memory_regions(process const& proc);
+
+#ifdef BERRY_LINUX
+    /**
+     * @brief Lists all memory regions of a process, reading maps with a
+     * deadline.
+     * Reading maps blocks while the process sleeps uninterruptibly with
+     * its memory map locked. The read runs on a helper thread which is
+     * left behind if it misses the deadline.
+     *
+     * @param proc The process to inspect.
+     * @param read_timeout The time the read may take.
+     * @return :vector< berry::memory_region > The regions.
+     * @throws std::system_error with std::errc::timed_out if the read
+     * didn't finish in time.
+     **/
+    std::vector<memory_region> get_memory_regions(process const& proc,
+        std::chrono::milliseconds read_timeout);
+#endif
+}
+
+#endif // __BERRY_MEMORYREGION_HPP__
@@ -0,0 +1,132 @@
+/**
+ * @file memory_usage.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Public API for per-process memory accounting.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_MEMORYUSAGE_HPP__
+#define __BERRY_MEMORYUSAGE_HPP__ 1
+
+// C++ Standard Library:
+#include <cstdint>
+#include <vector>
+
+// Boost Library:
+#include <boost/optional.hpp>
+
+// Berry:
+#include <berry/process.hpp>
+
+#ifdef BERRY_LINUX
+namespace berry
+{
+    /**
+     * @brief The memory a process uses, in bytes.
+     * PSS splits shared pages evenly between the processes mapping them, so
+     * unlike RSS it can be summed over processes.
+     **/
+    struct memory_usage
+    {
+        memory_usage();
+
+        /**
+         * @brief Adds the values of another process, except for the pid.
+         *
+         * @param other The usage to add.
+         * @return :memory_usage& This usage.
+         **/
+        memory_usage& operator+=(memory_usage const& other);
+
+        pid_type pid;
+
+        /**
+         * @brief Resident set size.
+         **/
+        std::uint64_t rss;
+
+        /**
+         * @brief Proportional set size.
+         **/
+        std::uint64_t pss;
+
+        /**
+         * @brief Split of the PSS into anonymous, file backed and shared
+         * memory. Only filled from smaps_rollup (Linux 5.7 and later).
+         **/
+        std::uint64_t pss_anon;
+        std::uint64_t pss_file;
+        std::uint64_t pss_shmem;
+
+        /**
+         * @brief Unique set size, the private clean and dirty pages.
+         **/
+        std::uint64_t uss;
+
+        /**
+         * @brief Resident pages shared with other processes.
+         **/
+        std::uint64_t shared;
+
+        /**
+         * @brief Anonymous resident pages.
+         **/
+        std::uint64_t anonymous;
+
+        /**
+         * @brief Swapped out pages and their proportional share.
+         **/
+        std::uint64_t swap;
+        std::uint64_t swap_pss;
+    };
+
+    /**
+     * @brief Reads the memory usage of a process.
+     * Parses /proc/<pid>/smaps_rollup, or sums up /proc/<pid>/smaps where
+     * the kernel lacks it (before Linux 4.14).
+     *
+     * @param pid The process' pid.
+     * @return :optional< berry::memory_usage > The usage, nothing if the
+     * process has no memory (kernel threads), exited or isn't accessible.
+     **/
+    boost::optional<memory_usage> get_memory_usage(pid_type pid);
+
+    /**
+     * @brief Reads the memory usage of all processes.
+     * Processes without memory or which aren't accessible are left out.
+     *
+     * @param workers The number of worker threads, 0 means one per core.
+     * @return :vector< berry::memory_usage > The usages, sorted by pid.
+     **/
+    std::vector<memory_usage> get_all_memory_usage(unsigned workers = 0);
+
+    /**
+     * @brief Sums up the usage of a set of processes, e.g. a subtree from
+     * process_tree::subtree or a cgroup from get_cgroup_processes.
+     *
+     * @param usages The usages as returned by get_all_memory_usage.
+     * @param pids The pids to sum up, pids without usage are skipped.
+     * @return :memory_usage The sum, with a pid of 0.
+     **/
+    memory_usage sum_memory_usage(std::vector<memory_usage> const& usages,
+        std::vector<pid_type> const& pids);
+}
+#endif // BERRY_LINUX
+
+#endif // __BERRY_MEMORYUSAGE_HPP__
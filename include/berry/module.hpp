@@ -0,0 +1,104 @@
+/**
+ * @file module.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Public API to list the modules loaded into a process.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_MODULE_HPP__
+#define __BERRY_MODULE_HPP__ 1
+
+// C++ Standard Library:
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/memory_region.hpp>
+#include <berry/remote_memory.hpp>
+
+namespace berry
+{
+    /**
+     * @brief Describes a file mapped into a process.
+     **/
+    struct module
+    {
+        module();
+
+        /**
+         * @brief Returns whether the address lies inside of the module.
+         *
+         * @param address The address to check.
+         * @return bool True if begin <= address < end.
+         **/
+        bool contains(remote_address address) const;
+
+        /**
+         * @brief Returns the file name of the module without directories.
+         *
+         * @return :string The file name.
+         **/
+        std::string name() const;
+
+        /**
+         * @brief Address the start of the file (offset 0) is mapped at.
+         **/
+        remote_address base;
+
+        /**
+         * @brief Start of the lowest mapping of the file.
+         **/
+        remote_address begin;
+
+        /**
+         * @brief End of the highest mapping of the file.
+         **/
+        remote_address end;
+
+        /**
+         * @brief True if at least one mapping of the file is executable.
+         **/
+        bool executable;
+
+        std::uint64_t device;
+        std::uint64_t inode;
+        std::string path;
+    };
+
+    /**
+     * @brief Groups memory regions by their backing file.
+     * Anonymous regions and pseudo files like [stack] are skipped.
+     *
+     * @param regions The regions of a process.
+     * @return :vector< berry::module > The modules, sorted by address.
+     **/
+    std::vector<module> get_modules(std::vector<memory_region> const& regions);
+
+    /**
+     * @brief Lists all modules loaded into a process.
+     *
+     * @param proc The process to inspect.
+     * @return :vector< berry::module > The modules, sorted by address.
+     **/
+    std::vector<module> get_modules(process const& proc);
+}
+
+#endif // __BERRY_MODULE_HPP__
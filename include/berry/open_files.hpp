@@ -0,0 +1,140 @@
+/**
+ * @file open_files.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Public API to enumerate open file descriptors.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_OPENFILES_HPP__
+#define __BERRY_OPENFILES_HPP__ 1
+
+// C++ Standard Library:
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Berry:
+#include <berry/process.hpp>
+
+#ifdef BERRY_LINUX
+namespace berry
+{
+    /**
+     * @brief Describes one open file descriptor of a process.
+     **/
+    struct open_file
+    {
+        open_file();
+
+        int fd;
+
+        /**
+         * @brief Device and inode of the open file, 0 if the descriptor
+         * couldn't be inspected.
+         **/
+        std::uint64_t device;
+        std::uint64_t inode;
+
+        /**
+         * @brief The link target as in /proc/<pid>/fd, e.g. a path,
+         * "socket:[1234]" or "pipe:[5678]".
+         **/
+        std::string target;
+    };
+
+    /**
+     * @brief Lists the open file descriptors of a process, sorted by fd.
+     * Needs ptrace access to the process.
+     *
+     * @param pid The process' pid.
+     * @return :vector< berry::open_file > The descriptors, empty if the
+     * process exited or isn't accessible.
+     **/
+    std::vector<open_file> get_open_files(pid_type pid);
+
+    /**
+     * @brief A descriptor holding a file.
+     **/
+    struct file_holder
+    {
+        pid_type pid;
+        int fd;
+    };
+
+    /**
+     * @brief Maps files, sockets and pipes to the descriptors holding them.
+     * Built in one pass over /proc/<pid>/fd of all processes, so that
+     * "who holds this" becomes a lookup. Processes the caller may not
+     * ptrace are left out.
+     **/
+    class open_file_index
+    {
+    private:
+        struct record
+        {
+            std::uint64_t device;
+            std::uint64_t inode;
+            file_holder holder;
+        };
+
+        std::vector<record> m_records;
+        std::uint64_t m_socket_device;
+
+        static bool record_less(record const& lhs, record const& rhs);
+
+    public:
+        /**
+         * @brief Indexes the descriptors of all processes.
+         *
+         * @param workers The number of worker threads, 0 means one per
+         * core.
+         **/
+        explicit open_file_index(unsigned workers = 0);
+
+        /**
+         * @brief Looks up the holders of a file.
+         *
+         * @param device The file's device, as st_dev of stat.
+         * @param inode The file's inode.
+         * @return :vector< berry::file_holder > The holders by pid and fd.
+         **/
+        std::vector<file_holder> find(std::uint64_t device,
+            std::uint64_t inode) const;
+
+        /**
+         * @brief Looks up the holders of a socket, e.g. by the inode listed
+         * in /proc/net/tcp.
+         *
+         * @param inode The socket's inode.
+         * @return :vector< berry::file_holder > The holders by pid and fd.
+         **/
+        std::vector<file_holder> find_socket(std::uint64_t inode) const;
+
+        /**
+         * @brief Returns the number of indexed descriptors.
+         *
+         * @return :size_t The number of descriptors.
+         **/
+        std::size_t size() const;
+    };
+}
+#endif // BERRY_LINUX
+
+#endif // __BERRY_OPENFILES_HPP__
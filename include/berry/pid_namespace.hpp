@@ -0,0 +1,127 @@
+/**
+ * @file pid_namespace.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Public API to translate pids between pid namespaces.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_PIDNAMESPACE_HPP__
+#define __BERRY_PIDNAMESPACE_HPP__ 1
+
+// C++ Standard Library:
+#include <cstdint>
+#include <vector>
+
+// Boost Library:
+#include <boost/optional.hpp>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/process_entry.hpp>
+
+#ifdef BERRY_LINUX
+namespace berry
+{
+    /**
+     * @brief A process as seen from the caller and from its own namespace.
+     **/
+    struct namespaced_pid
+    {
+        /**
+         * @brief Inode of the process' pid namespace.
+         **/
+        std::uint64_t pid_namespace;
+
+        /**
+         * @brief The pid inside of that namespace.
+         **/
+        pid_type local_pid;
+
+        /**
+         * @brief The pid as seen by the caller.
+         **/
+        pid_type pid;
+    };
+
+    /**
+     * @brief Translates pids between the caller's and the processes' own
+     * pid namespaces and groups processes by namespace, i.e. by container.
+     * Processes are indexed under their innermost namespace. Entries
+     * without namespace information are left out.
+     **/
+    class pid_namespace_index
+    {
+    private:
+        std::vector<namespaced_pid> m_by_namespace;
+        std::vector<namespaced_pid> m_by_pid;
+
+    public:
+        /**
+         * @brief Builds the index from a new snapshot.
+         **/
+        pid_namespace_index();
+
+        /**
+         * @brief Builds the index from entries of a snapshot created with
+         * snapshot_namespaces.
+         *
+         * @param entries The entries.
+         **/
+        explicit pid_namespace_index(
+            std::vector<process_entry> const& entries);
+
+        /**
+         * @brief Looks up the namespace and local pid of a process.
+         *
+         * @param pid The pid as seen by the caller.
+         * @return :namespaced_pid const* The record or null.
+         **/
+        namespaced_pid const* find(pid_type pid) const;
+
+        /**
+         * @brief Translates a namespace local pid to the caller's view.
+         *
+         * @param pid_namespace The namespace's inode.
+         * @param local_pid The pid inside of the namespace.
+         * @return :optional< pid_type > The pid as seen by the caller.
+         **/
+        boost::optional<pid_type> translate(std::uint64_t pid_namespace,
+            pid_type local_pid) const;
+
+        /**
+         * @brief Returns all indexed namespaces.
+         *
+         * @return :vector< uint64_t > The inodes in ascending order.
+         **/
+        std::vector<std::uint64_t> namespaces() const;
+
+        /**
+         * @brief Returns the processes of one namespace.
+         *
+         * @param pid_namespace The namespace's inode.
+         * @return :vector< berry::namespaced_pid > The processes, sorted by
+         * local pid.
+         **/
+        std::vector<namespaced_pid> members(
+            std::uint64_t pid_namespace) const;
+    };
+}
+#endif // BERRY_LINUX
+
+#endif // __BERRY_PIDNAMESPACE_HPP__
@@ -39,6 +39,16 @@ namespace berry
      * @brief Defines a type used to store arbitrary process identifiers.
      **/
     typedef detail::process::pid_type pid_type;
+    
+    class process;
+    
+#ifdef BERRY_LINUX
+    namespace unix_like
+    {
+        int get_pidfd(process const& proc);
+        int get_procfs_dirfd(process const& proc);
+    }
+#endif // BERRY_LINUX
         
     /**
      * @brief Represents a process on the system.
@@ -48,6 +58,12 @@ namespace berry
     private:
         detail::process::process_data m_data;
         
+        #ifdef BERRY_LINUX
+        
+        friend int unix_like::get_pidfd(process const& proc);
+        friend int unix_like::get_procfs_dirfd(process const& proc);
+        #endif // BERRY_LINUX
+        
         #ifdef BERRY_WINDOWS
         
         friend detail::process::handle_type _detail_get_shared_handle(
@@ -62,6 +78,9 @@ namespace berry
 
         /**
          * @brief Constructs a process object from a process id.
+         * On Linux the object holds a pidfd and the open ProcFS directory
+         * of the process, so it keeps referring to the same process even if
+         * the pid gets reused.
          * 
          * @param pid The process' id.
          **/
@@ -84,6 +103,7 @@ namespace berry
 
         /**
          * @brief Constructs a process object from moving another process.
+         * The other process is left as not_a_process.
          * 
          * @param other Another process to move.
          **/
@@ -207,8 +227,10 @@ namespace berry
          * @brief Sets the ProcFS base directory.
          * Per default the ProcFS base directory is set to the most common
          * path on the system (e.g. /proc on Linux). Call this function if
-         * the ProcFS is mounted somewhere else.
+         * the ProcFS is mounted somewhere else. Opens a procfs_context on
+         * the directory and makes it the default context.
          * @param base_dir The base of the ProcFS.
+         * @throw std::system_error If the directory can't be opened.
          **/
         void set_procfs_base(boost::filesystem::path const& base_dir);
         
@@ -219,10 +241,35 @@ namespace berry
          * @param proc The target process.
          * @return :filesystem3::path The path to the ProcFS directory.
          **/
-        boost::filesystem::path get_procfs_dir(process proc);
+        boost::filesystem::path get_procfs_dir(process const& proc);
     }
 #endif // BERRY_HAS_PROCFS
 
+#ifdef BERRY_LINUX
+    namespace unix_like
+    {
+        /**
+         * @brief Returns the pidfd hold by the process object.
+         * 
+         * @param proc The target process.
+         * @return int The pidfd or -1 if the kernel doesn't support pidfds
+         * or the process didn't exist when the object was created. As this
+         * is no copy, you may NOT close it.
+         **/
+        int get_pidfd(process const& proc);
+        
+        /**
+         * @brief Returns the descriptor of the process' ProcFS directory.
+         * Use it with openat and friends to read files of the process.
+         * 
+         * @param proc The target process.
+         * @return int The descriptor or -1. As this is no copy, you may NOT
+         * close it.
+         **/
+        int get_procfs_dirfd(process const& proc);
+    }
+#endif // BERRY_LINUX
+
 #ifdef BERRY_WINDOWS
 	namespace win
 	{
@@ -0,0 +1,184 @@
+/**
+ * @file process_activity.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Public API for I/O and scheduler rates between two samples.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_PROCESSACTIVITY_HPP__
+#define __BERRY_PROCESSACTIVITY_HPP__ 1
+
+// C++ Standard Library:
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/process_entry.hpp>
+#include <berry/process_table.hpp>
+
+#ifdef BERRY_LINUX
+namespace berry
+{
+    /**
+     * @brief What to rank processes by in top_activity.
+     **/
+    enum activity_order
+    {
+        order_by_io_rate,
+        order_by_syscall_rate,
+        order_by_run_delay,
+        order_by_cpu_usage
+    };
+
+    /**
+     * @brief What a process did between two samples, per second.
+     **/
+    struct process_activity
+    {
+        process_activity();
+
+        pid_type pid;
+        std::string name;
+
+        /**
+         * @brief Bytes per second fetched from and sent to storage.
+         **/
+        double read_rate;
+        double write_rate;
+
+        /**
+         * @brief Read and write like system calls per second.
+         **/
+        double syscall_rate;
+
+        /**
+         * @brief Seconds spent waiting on a run queue per second.
+         **/
+        double run_delay;
+
+        /**
+         * @brief Seconds spent on a CPU per second.
+         **/
+        double cpu_usage;
+    };
+
+    /**
+     * @brief Computes the activity between two tables created with
+     * snapshot_io and snapshot_schedstat.
+     * Processes missing in one of the tables are left out, as are those
+     * whose start time changed because their pid got reused. Rates whose
+     * counters weren't read in both samples or went down are zero.
+     *
+     * @param before The earlier sample.
+     * @param after The later sample.
+     * @param interval The time between the samples.
+     * @return :vector< berry::process_activity > The activity, by pid.
+     **/
+    std::vector<process_activity> compute_activity(
+        process_table const& before, process_table const& after,
+        std::chrono::steady_clock::duration interval);
+
+    /**
+     * @brief Computes the activity between two tables, using the time
+     * between their creation as interval.
+     *
+     * @param before The earlier sample.
+     * @param after The later sample.
+     * @return :vector< berry::process_activity > The activity, by pid.
+     **/
+    std::vector<process_activity> compute_activity(
+        process_table const& before, process_table const& after);
+
+    /**
+     * @brief Returns the most active processes.
+     * Only the returned ones are sorted, which costs O(n log count)
+     * instead of sorting the whole list.
+     *
+     * @param activity The activity of all processes.
+     * @param count The number of processes to return.
+     * @param order What to rank by.
+     * @return :vector< berry::process_activity > Up to count processes,
+     * most active first.
+     **/
+    std::vector<process_activity> top_activity(
+        std::vector<process_activity> const& activity, std::size_t count,
+        activity_order order);
+
+    /**
+     * @brief Takes samples of all processes and computes the activity
+     * since the previous one.
+     **/
+    class activity_sampler
+    {
+    private:
+        unsigned m_fields;
+        std::shared_ptr<process_table const> m_previous;
+        std::vector<process_activity> m_activity;
+
+    public:
+        /**
+         * @brief Takes the first sample.
+         *
+         * @param fields The snapshot_field values to record, at least
+         * snapshot_io and snapshot_schedstat are always recorded.
+         **/
+        explicit activity_sampler(unsigned fields = 0);
+
+        /**
+         * @brief Takes the next sample.
+         *
+         * @return :vector< berry::process_activity > const& The activity
+         * since the previous sample.
+         **/
+        std::vector<process_activity> const& sample();
+
+        /**
+         * @brief Returns the activity computed by the last sample.
+         *
+         * @return :vector< berry::process_activity > const& The activity,
+         * empty before the second sample.
+         **/
+        std::vector<process_activity> const& activity() const;
+
+        /**
+         * @brief Returns the most active processes of the last sample.
+         *
+         * @param count The number of processes to return.
+         * @param order What to rank by.
+         * @return :vector< berry::process_activity > Up to count
+         * processes, most active first.
+         **/
+        std::vector<process_activity> top(std::size_t count,
+            activity_order order) const;
+
+        /**
+         * @brief Returns the latest sample.
+         *
+         * @return :shared_ptr< berry::process_table const > The table.
+         **/
+        std::shared_ptr<process_table const> latest() const;
+    };
+}
+#endif // BERRY_LINUX
+
+#endif // __BERRY_PROCESSACTIVITY_HPP__
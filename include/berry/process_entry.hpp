@@ -25,8 +25,11 @@
 #define __BERRY_PROCESSENTRY_HPP__ 1
 
 // C++ Standard Library:
+#include <chrono>
+#include <cstdint>
 #include <string>
 #include <memory>
+#include <vector>
 
 // Boost Library:
 #include <boost/optional.hpp>
@@ -36,6 +39,55 @@
 
 namespace berry
 {
+#ifdef BERRY_LINUX
+    /**
+     * @brief The I/O counters of /proc/<pid>/io.
+     **/
+    struct io_counters
+    {
+        io_counters();
+        
+        /**
+         * @brief Bytes passed to read and write like calls, including
+         * pipes, sockets and the page cache.
+         **/
+        std::uint64_t read_chars;
+        std::uint64_t write_chars;
+        
+        std::uint64_t read_syscalls;
+        std::uint64_t write_syscalls;
+        
+        /**
+         * @brief Bytes fetched from and sent to the storage layer.
+         **/
+        std::uint64_t read_bytes;
+        std::uint64_t write_bytes;
+    };
+    
+    /**
+     * @brief The scheduler counters of /proc/<pid>/schedstat.
+     **/
+    struct scheduler_counters
+    {
+        scheduler_counters();
+        
+        /**
+         * @brief Nanoseconds spent on a CPU.
+         **/
+        std::uint64_t run_time;
+        
+        /**
+         * @brief Nanoseconds spent runnable, waiting on a run queue.
+         **/
+        std::uint64_t wait_time;
+        
+        /**
+         * @brief The number of time slices run.
+         **/
+        std::uint64_t timeslices;
+    };
+#endif
+
     /**
      * @brief Class representing a process entry on the system.
      **/
@@ -46,6 +98,61 @@ namespace berry
         detail::process::pid_type pid;
         detail::process::pid_type parent_pid;
         std::string name;
+#ifdef BERRY_LINUX
+        
+        /**
+         * @brief Inode of the process' pid namespace, 0 if not recorded.
+         * Only filled by snapshots created with snapshot_namespaces.
+         **/
+        std::uint64_t pid_namespace;
+        
+        /**
+         * @brief The process' pid in each nested pid namespace, starting
+         * with the caller's, as listed by NSpid in /proc/<pid>/status.
+         * Only filled by snapshots created with snapshot_namespaces.
+         **/
+        std::vector<detail::process::pid_type> namespace_pids;
+        
+        /**
+         * @brief The command line, arguments separated by '\0' as in
+         * /proc/<pid>/cmdline. Only filled by snapshots created with
+         * snapshot_cmdline.
+         **/
+        std::string cmdline;
+        
+        /**
+         * @brief False if a read of the process' files ran into the
+         * snapshot's read timeout, the fields read from them are empty.
+         * Usually means the process hangs in uninterruptible sleep.
+         **/
+        bool available;
+        
+        /**
+         * @brief The snapshot_io and snapshot_schedstat values whose files
+         * could be read. The counters of a field missing here are zero, not
+         * a sample.
+         **/
+        unsigned counters_read;
+        
+        /**
+         * @brief Only filled by snapshots created with snapshot_io. Stays
+         * zero for processes the caller may not ptrace.
+         **/
+        io_counters io;
+        
+        /**
+         * @brief Only filled by snapshots created with snapshot_schedstat.
+         * Stays zero on kernels without schedstats.
+         **/
+        scheduler_counters scheduler;
+        
+        /**
+         * @brief Start time in clock ticks after boot, field 22 of
+         * /proc/<pid>/stat. Tells a reused pid from the process seen
+         * before.
+         **/
+        std::uint64_t start_time;
+#endif
     };
   
     /**
@@ -59,6 +166,66 @@ namespace berry
      * @return process_snapshot_type The created snapshot.
      **/
     process_snapshot create_process_snapshot();
+    
+#ifdef BERRY_LINUX
+    /**
+     * @brief Optional fields a snapshot can record, to be or'ed together.
+     * Each one costs additional reads per process.
+     **/
+    enum snapshot_field
+    {
+        snapshot_namespaces = 1 << 0,
+        snapshot_cmdline = 1 << 1,
+        
+        /**
+         * @brief Not a field, reads the stat files of many processes per
+         * system call through io_uring where the kernel supports it.
+         * Falls back to one read per file otherwise.
+         **/
+        snapshot_batched = 1 << 2,
+        snapshot_io = 1 << 3,
+        snapshot_schedstat = 1 << 4
+    };
+    
+    /**
+     * @brief Creates a snapshot of all running processes on the system,
+     * recording optional fields.
+     *
+     * @param fields The snapshot_field values to record.
+     * @return process_snapshot_type The created snapshot.
+     **/
+    process_snapshot create_process_snapshot(unsigned fields);
+
+    /**
+     * @brief Creates a snapshot of all running processes on the system,
+     * reading optional fields with a deadline.
+     * Reads of files which block on a stuck process (cmdline) run on helper
+     * threads. If one doesn't finish within read_timeout, the entry is
+     * marked unavailable and extraction goes on with the next process.
+     *
+     * @param fields The snapshot_field values to record.
+     * @param read_timeout The time a single read may take.
+     * @return process_snapshot_type The created snapshot.
+     **/
+    process_snapshot create_process_snapshot(unsigned fields,
+        std::chrono::milliseconds read_timeout);
+
+    namespace unix_like
+    {
+        class procfs_context;
+    }
+
+    /**
+     * @brief Creates a snapshot of the processes of a ProcFS tree other
+     * than the default one.
+     *
+     * @param fields The snapshot_field values to record.
+     * @param context The ProcFS root to read, the snapshot keeps a copy.
+     * @return process_snapshot_type The created snapshot.
+     **/
+    process_snapshot create_process_snapshot(unsigned fields,
+        unix_like::procfs_context const& context);
+#endif
    
     /**
      * @brief Extracts the first process entry from the snapshot.
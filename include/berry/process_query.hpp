@@ -0,0 +1,185 @@
+/**
+ * @file process_query.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Public API to search processes by several criteria.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_PROCESSQUERY_HPP__
+#define __BERRY_PROCESSQUERY_HPP__ 1
+
+// C++ Standard Library:
+#include <cstddef>
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+// Boost Library:
+#include <boost/optional.hpp>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/process_entry.hpp>
+#include <berry/procfs_context.hpp>
+
+#ifdef BERRY_HAS_PROCFS
+namespace berry
+{
+    /**
+     * @brief Counts the work a query did.
+     **/
+    struct query_statistics
+    {
+        query_statistics();
+
+        /**
+         * @brief The number of processes looked at.
+         **/
+        std::size_t processes;
+
+        /**
+         * @brief The number of ProcFS directories stat'ed.
+         **/
+        std::size_t stats;
+
+        /**
+         * @brief The number of ProcFS files read.
+         **/
+        std::size_t files_read;
+    };
+
+    /**
+     * @brief A search for processes matching all of a set of criteria.
+     * The checks are run cheapest first: the owner of the process'
+     * directory, then comm, stat, cgroup and finally cmdline. A process is
+     * dropped by the first check it fails, so files needed only by later
+     * checks are never read for it.
+     **/
+    class process_query
+    {
+    private:
+        boost::optional<std::string> m_name;
+        bool m_case_sensitive;
+        boost::optional<unsigned int> m_uid;
+        boost::optional<pid_type> m_parent_pid;
+        boost::optional<char> m_state;
+        boost::optional<std::string> m_cgroup;
+        bool m_cgroup_recursive;
+        std::shared_ptr<std::regex const> m_cmdline;
+        std::shared_ptr<unix_like::procfs_context const> m_context;
+
+        std::size_t run(std::vector<process_entry>* out, std::size_t limit,
+            query_statistics* statistics) const;
+
+    public:
+        /**
+         * @brief Creates a query matching every process.
+         **/
+        process_query();
+
+        /**
+         * @brief Requires a process name.
+         * The name is truncated like the system truncates process names.
+         *
+         * @param name The name.
+         * @param case_sensitive Pass false to ignore the case.
+         * @return :process_query& *this
+         **/
+        process_query& with_name(std::string const& name,
+            bool case_sensitive = true);
+
+        /**
+         * @brief Requires an effective user id.
+         * Checked by the owner of the process' ProcFS directory. Processes
+         * which aren't dumpable, like setuid programs, have their directory
+         * owned by root, their status file is read instead.
+         *
+         * @param uid The user id.
+         * @return :process_query& *this
+         **/
+        process_query& with_uid(unsigned int uid);
+
+        /**
+         * @brief Requires a parent process.
+         *
+         * @param pid The parent's pid.
+         * @return :process_query& *this
+         **/
+        process_query& with_parent(pid_type pid);
+
+        /**
+         * @brief Requires a scheduling state as in proc(5), e.g. 'R'.
+         *
+         * @param state The state.
+         * @return :process_query& *this
+         **/
+        process_query& with_state(char state);
+
+        /**
+         * @brief Requires membership of a cgroup v2.
+         *
+         * @param cgroup The cgroup as in /proc/<pid>/cgroup.
+         * @param recursive Whether members of child cgroups match too.
+         * @return :process_query& *this
+         **/
+        process_query& with_cgroup(std::string const& cgroup,
+            bool recursive = false);
+
+        /**
+         * @brief Requires the command line to contain a match of a regular
+         * expression. The arguments are joined by single spaces.
+         *
+         * @param pattern The ECMAScript regular expression.
+         * @return :process_query& *this
+         * @throw std::regex_error If the pattern is invalid.
+         **/
+        process_query& with_cmdline(std::string const& pattern);
+
+        /**
+         * @brief Reads the processes of another ProcFS tree than the
+         * default one.
+         *
+         * @param context The ProcFS root, the query keeps a copy.
+         * @return :process_query& *this
+         **/
+        process_query& with_procfs(unix_like::procfs_context const& context);
+
+        /**
+         * @brief Returns all matching processes.
+         *
+         * @param statistics Receives the work done, may be null.
+         * @return :vector< berry::process_entry > The matches, by pid.
+         **/
+        std::vector<process_entry> find_all(
+            query_statistics* statistics = 0) const;
+
+        /**
+         * @brief Returns the matching process with the lowest pid.
+         *
+         * @param statistics Receives the work done, may be null.
+         * @return :optional< berry::process_entry > The match.
+         **/
+        boost::optional<process_entry> find_first(
+            query_statistics* statistics = 0) const;
+    };
+}
+#endif // BERRY_HAS_PROCFS
+
+#endif // __BERRY_PROCESSQUERY_HPP__
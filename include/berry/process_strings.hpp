@@ -0,0 +1,226 @@
+/**
+ * @file process_strings.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Public API to read the command line and environment of processes.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_PROCESSSTRINGS_HPP__
+#define __BERRY_PROCESSSTRINGS_HPP__ 1
+
+// C++ Standard Library:
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Boost Library:
+#include <boost/optional.hpp>
+#include <boost/range/iterator_range.hpp>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/process_entry.hpp>
+#include <berry/procfs_context.hpp>
+
+#ifdef BERRY_HAS_PROCFS
+namespace berry
+{
+    /**
+     * @brief A view of characters owned by someone else.
+     **/
+    typedef boost::iterator_range<char const*> string_range;
+
+    /**
+     * @brief Splits a block of NUL terminated strings into views.
+     *
+     * @param block The strings, the last terminator may be missing.
+     * @param out Receives the views, previous content is kept.
+     **/
+    void split_strings(string_range block, std::vector<string_range>& out);
+
+    /**
+     * @brief The NUL separated strings of /proc/<pid>/cmdline or environ.
+     * The file is read with one read into an arena which is reused by the
+     * next read, the strings are views into it. Reading again invalidates
+     * all views.
+     **/
+    class process_strings
+    {
+    private:
+        std::vector<char> m_arena;
+        std::vector<string_range> m_strings;
+
+        bool read(int dirfd, char const* path);
+        bool read_bounded(pid_type pid, char const* file,
+            std::chrono::milliseconds timeout, char const* caller);
+
+    public:
+        typedef std::vector<string_range>::const_iterator const_iterator;
+
+        /**
+         * @brief Reads the command line of a process.
+         *
+         * @param proc The process.
+         * @return bool False if the process is gone or access was denied.
+         * The strings are empty then.
+         **/
+        bool read_cmdline(process const& proc);
+
+        /**
+         * @brief Reads the command line of a process by pid.
+         * Cheaper than constructing a process object for a single read.
+         *
+         * @param pid The process' pid.
+         * @return bool False if the process is gone or access was denied.
+         **/
+        bool read_cmdline(pid_type pid);
+
+        /**
+         * @brief Reads the command line of a process by pid, with a
+         * deadline. The read runs on a helper thread which is left behind
+         * if the process blocks it, e.g. in uninterruptible sleep.
+         *
+         * @param pid The process' pid.
+         * @param read_timeout The time the read may take.
+         * @return bool False if the process is gone or access was denied.
+         * @throws std::system_error with std::errc::timed_out if the read
+         * didn't finish in time.
+         **/
+        bool read_cmdline(pid_type pid,
+            std::chrono::milliseconds read_timeout);
+
+        /**
+         * @brief Reads the initial environment of a process.
+         * Changes the process made to its environment after startup aren't
+         * visible.
+         *
+         * @param proc The process.
+         * @return bool False if the process is gone or access was denied.
+         **/
+        bool read_environ(process const& proc);
+
+        /**
+         * @brief Reads the initial environment of a process by pid.
+         *
+         * @param pid The process' pid.
+         * @return bool False if the process is gone or access was denied.
+         **/
+        bool read_environ(pid_type pid);
+
+        /**
+         * @brief Reads the initial environment of a process by pid, with a
+         * deadline, like read_cmdline.
+         *
+         * @param pid The process' pid.
+         * @param read_timeout The time the read may take.
+         * @return bool False if the process is gone or access was denied.
+         * @throws std::system_error with std::errc::timed_out if the read
+         * didn't finish in time.
+         **/
+        bool read_environ(pid_type pid,
+            std::chrono::milliseconds read_timeout);
+
+        /**
+         * @brief Looks up an environment variable by scanning the strings.
+         *
+         * @param key The variable's name.
+         * @return :optional< berry::string_range > The value.
+         **/
+        boost::optional<string_range> find_variable(
+            std::string const& key) const;
+
+        std::size_t size() const;
+        bool empty() const;
+        string_range operator[](std::size_t index) const;
+        const_iterator begin() const;
+        const_iterator end() const;
+    };
+
+    /**
+     * @brief The command lines of many processes in one arena.
+     * Meant for filters over all processes: building the column does one
+     * read per process and no per-process allocation.
+     **/
+    class cmdline_column
+    {
+    private:
+        std::vector<pid_type> m_pids;
+        std::vector<char> m_arena;
+        std::vector<std::size_t> m_offsets;
+
+        void load(unix_like::procfs_context const& context);
+
+    public:
+        /**
+         * @brief Reads the command lines of all processes.
+         **/
+        cmdline_column();
+
+        /**
+         * @brief Reads the command lines of the given processes.
+         *
+         * @param pids The processes.
+         **/
+        explicit cmdline_column(std::vector<pid_type> pids);
+
+        /**
+         * @brief Reads the command lines of the processes of a snapshot.
+         *
+         * @param entries The snapshot's entries.
+         **/
+        explicit cmdline_column(std::vector<process_entry> const& entries);
+
+        /**
+         * @brief Adds a row.
+         *
+         * @param pid The process' pid.
+         * @param cmdline The NUL separated arguments, copied into the arena.
+         **/
+        void append(pid_type pid, string_range cmdline);
+
+        /**
+         * @brief Returns the number of processes.
+         *
+         * @return :size_t The number of processes.
+         **/
+        std::size_t size() const;
+
+        /**
+         * @brief Returns the pid of a row.
+         *
+         * @param index The row.
+         * @return :pid_type The pid.
+         **/
+        pid_type pid(std::size_t index) const;
+
+        /**
+         * @brief Returns the command line of a row.
+         * Use split_strings to get the single arguments.
+         *
+         * @param index The row.
+         * @return :string_range The NUL separated arguments, empty for
+         * kernel threads and processes which vanished.
+         **/
+        string_range cmdline(std::size_t index) const;
+    };
+}
+#endif // BERRY_HAS_PROCFS
+
+#endif // __BERRY_PROCESSSTRINGS_HPP__
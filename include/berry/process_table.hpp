@@ -0,0 +1,100 @@
+/**
+ * @file process_table.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Public API for immutable tables of process entries.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_PROCESSTABLE_HPP__
+#define __BERRY_PROCESSTABLE_HPP__ 1
+
+// C++ Standard Library:
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/process_entry.hpp>
+
+namespace berry
+{
+    /**
+     * @brief All entries of one snapshot, sorted by pid.
+     * Tables are never modified after construction, so one table can be
+     * shared between threads without locking.
+     **/
+    class process_table
+    {
+    private:
+        std::vector<process_entry> m_entries;
+        std::chrono::steady_clock::time_point m_created;
+
+    public:
+        /**
+         * @brief Builds the table from a new snapshot.
+         **/
+        process_table();
+
+        /**
+         * @brief Builds the table from the remaining entries of a snapshot.
+         *
+         * @param snap The snapshot to consume.
+         **/
+        explicit process_table(process_snapshot& snap);
+
+        /**
+         * @brief Builds the table from a list of entries.
+         *
+         * @param entries The entries, in any order.
+         **/
+        explicit process_table(std::vector<process_entry> entries);
+
+        /**
+         * @brief Looks up the entry of a process.
+         *
+         * @param pid The pid to look for.
+         * @return :process_entry const* The entry or null.
+         **/
+        process_entry const* find(pid_type pid) const;
+
+        /**
+         * @brief Returns all entries, sorted by pid.
+         *
+         * @return :vector< berry::process_entry > const& The entries.
+         **/
+        std::vector<process_entry> const& entries() const;
+
+        /**
+         * @brief Returns the number of entries.
+         *
+         * @return :size_t The number of entries.
+         **/
+        std::size_t size() const;
+
+        /**
+         * @brief Returns when the table was built.
+         *
+         * @return :steady_clock::time_point The time of construction.
+         **/
+        std::chrono::steady_clock::time_point created() const;
+    };
+}
+
+#endif // __BERRY_PROCESSTABLE_HPP__
@@ -0,0 +1,105 @@
+/**
+ * @file process_tree.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Parent/child relations of a process snapshot.
+ * 
+ * This file is part of Berry.
+ * 
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_PROCESSTREE_HPP__
+#define __BERRY_PROCESSTREE_HPP__ 1
+
+// C++ Standard Library:
+#include <cstddef>
+#include <vector>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/process_entry.hpp>
+
+namespace berry
+{
+    /**
+     * @brief The process hierarchy as seen by one snapshot.
+     * Children are stored in one flat array indexed by parent, so walking
+     * a subtree doesn't chase parent links through the whole list.
+     **/
+    class process_tree
+    {
+    private:
+        std::vector<process_entry> m_entries;
+        std::vector<std::size_t> m_child_offsets;
+        std::vector<std::size_t> m_children;
+        
+        std::size_t index_of(pid_type pid) const;
+        
+    public:
+        /**
+         * @brief Builds the tree from a new snapshot.
+         **/
+        process_tree();
+        
+        /**
+         * @brief Builds the tree from the remaining entries of a snapshot.
+         *
+         * @param snap The snapshot to consume.
+         **/
+        explicit process_tree(process_snapshot& snap);
+        
+        /**
+         * @brief Builds the tree from a list of entries.
+         *
+         * @param entries The entries, in any order.
+         **/
+        explicit process_tree(std::vector<process_entry> entries);
+        
+        /**
+         * @brief Looks up the entry of a process.
+         *
+         * @param pid The pid to look for.
+         * @return :process_entry const* The entry or null.
+         **/
+        process_entry const* find(pid_type pid) const;
+        
+        /**
+         * @brief Returns the direct children of a process.
+         *
+         * @param pid The parent's pid.
+         * @return :vector< pid_type > The children's pids.
+         **/
+        std::vector<pid_type> children(pid_type pid) const;
+        
+        /**
+         * @brief Returns a process and all of its descendants.
+         *
+         * @param root The root of the subtree.
+         * @return :vector< pid_type > The pids in breadth-first order,
+         * starting with root. Empty if root isn't part of the tree.
+         **/
+        std::vector<pid_type> subtree(pid_type root) const;
+        
+        /**
+         * @brief Returns all entries, sorted by pid.
+         *
+         * @return :vector< berry::process_entry > const& The entries.
+         **/
+        std::vector<process_entry> const& entries() const;
+    };
+}
+
+#endif // __BERRY_PROCESSTREE_HPP__
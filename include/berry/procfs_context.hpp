@@ -0,0 +1,134 @@
+/**
+ * @file procfs_context.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Public API to select the ProcFS tree to read from.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_PROCFSCONTEXT_HPP__
+#define __BERRY_PROCFSCONTEXT_HPP__ 1
+
+// C++ Standard Library:
+#include <memory>
+#include <vector>
+
+// Boost Library:
+#include <boost/filesystem/path.hpp>
+
+// Berry:
+#include <berry/process.hpp>
+
+#ifdef BERRY_HAS_PROCFS
+namespace berry
+{
+    namespace unix_like
+    {
+        /**
+         * @brief An open ProcFS root, e.g. the host's /proc, the /proc
+         * mount of a container or a fixture tree.
+         * Every file below the root is opened relative to the held
+         * directory descriptor, so contexts for different roots can be
+         * used side by side from any number of threads.
+         **/
+        class procfs_context
+        {
+        private:
+            boost::filesystem::path m_root;
+            int m_fd;
+
+        public:
+            /**
+             * @brief Opens a ProcFS root.
+             *
+             * @param root The directory holding the pid directories.
+             * @throw std::system_error If the directory can't be opened.
+             **/
+            explicit procfs_context(boost::filesystem::path const& root);
+
+            procfs_context(procfs_context const& other);
+            procfs_context(procfs_context&& other);
+            ~procfs_context();
+            procfs_context& operator=(procfs_context const& other);
+            procfs_context& operator=(procfs_context&& other);
+
+            /**
+             * @brief Returns the path the context was opened with.
+             *
+             * @return :filesystem3::path const& The root.
+             **/
+            boost::filesystem::path const& root() const;
+
+            /**
+             * @brief Returns the descriptor of the root.
+             * Use it with openat and friends. As this is no copy, you may
+             * NOT close it.
+             *
+             * @return int The descriptor.
+             **/
+            int fd() const;
+
+            /**
+             * @brief Opens the directory of a process.
+             *
+             * @param pid The process' pid.
+             * @return int A new descriptor or -1, the caller closes it.
+             **/
+            int open_directory(pid_type pid) const;
+
+            /**
+             * @brief Opens a file of a process for reading.
+             *
+             * @param pid The process' pid.
+             * @param file The file relative to the process' directory.
+             * @return int A new descriptor or -1, the caller closes it.
+             **/
+            int open_file(pid_type pid, char const* file) const;
+
+            /**
+             * @brief Lists the pid directories.
+             *
+             * @param out Receives the pids, previous content is kept.
+             * @return bool False if the root couldn't be read.
+             **/
+            bool list_processes(std::vector<pid_type>& out) const;
+        };
+
+        /**
+         * @brief Returns the context used by functions which don't take
+         * one. Initially it's opened on /proc.
+         *
+         * @return :shared_ptr< berry::unix_like::procfs_context const > The
+         * default context or null if /proc couldn't be opened. Holding it
+         * keeps it usable after it was replaced.
+         **/
+        std::shared_ptr<procfs_context const> get_default_procfs_context();
+
+        /**
+         * @brief Replaces the default context.
+         * Calls in progress finish with the context they started with.
+         *
+         * @param context The new default context.
+         **/
+        void set_default_procfs_context(
+            std::shared_ptr<procfs_context const> context);
+    }
+}
+#endif // BERRY_HAS_PROCFS
+
+#endif // __BERRY_PROCFSCONTEXT_HPP__
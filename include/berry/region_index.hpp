@@ -0,0 +1,120 @@
+/**
+ * @file region_index.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Fast address to memory region lookups.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_REGIONINDEX_HPP__
+#define __BERRY_REGIONINDEX_HPP__ 1
+
+// C++ Standard Library:
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/memory_region.hpp>
+#include <berry/remote_memory.hpp>
+
+namespace berry
+{
+    /**
+     * @brief Immutable index answering which region an address belongs to.
+     * The region start addresses are stored in Eytzinger (BFS) order, so a
+     * lookup touches one cache line per few levels of the search instead of
+     * jumping across the whole array like a plain binary search.
+     **/
+    class region_index
+    {
+    private:
+        std::vector<memory_region> m_regions;
+        std::vector<remote_address> m_keys;
+        std::vector<std::uint32_t> m_ranks;
+
+    public:
+        /**
+         * @brief Constructs an empty index.
+         **/
+        region_index();
+
+        /**
+         * @brief Builds the index from a list of non-overlapping regions.
+         *
+         * @param regions The regions, in any order.
+         **/
+        explicit region_index(std::vector<memory_region> regions);
+
+        /**
+         * @brief Builds the index from the current mappings of a process.
+         *
+         * @param proc The process to inspect.
+         **/
+        explicit region_index(process const& proc);
+
+        /**
+         * @brief Finds the region containing an address.
+         *
+         * @param address The address to look up.
+         * @return :memory_region const* The region, or null if the address
+         * isn't mapped.
+         **/
+        memory_region const* lookup(remote_address address) const;
+
+        /**
+         * @brief Looks up many addresses at once.
+         * The addresses must be sorted ascending, which allows walking the
+         * regions once instead of searching for every address.
+         *
+         * @param begin Pointer to the first address.
+         * @param end Pointer past the last address.
+         * @param out Receives one region pointer per address, null for
+         * unmapped addresses.
+         **/
+        void lookup_sorted(remote_address const* begin,
+            remote_address const* end, memory_region const** out) const;
+
+        /**
+         * @brief Looks up many addresses at once.
+         *
+         * @param addresses The addresses, sorted ascending.
+         * @return :vector< memory_region const* > One region per address.
+         * @see lookup_sorted
+         **/
+        std::vector<memory_region const*> lookup_sorted(
+            std::vector<remote_address> const& addresses) const;
+
+        /**
+         * @brief Returns the indexed regions, sorted by address.
+         *
+         * @return :vector< berry::memory_region > const& The regions.
+         **/
+        std::vector<memory_region> const& regions() const;
+
+        /**
+         * @brief Returns the number of indexed regions.
+         *
+         * @return :size_t The number of regions.
+         **/
+        std::size_t size() const;
+    };
+}
+
+#endif // __BERRY_REGIONINDEX_HPP__
@@ -0,0 +1,142 @@
+/**
+ * @file remote_memory.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Public API to read the memory of other processes.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_REMOTEMEMORY_HPP__
+#define __BERRY_REMOTEMEMORY_HPP__ 1
+
+// C++ Standard Library:
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Boost Library:
+#include <boost/optional.hpp>
+
+// Berry:
+#include <berry/process.hpp>
+
+namespace berry
+{
+    /**
+     * @brief Type used to store addresses inside of other processes.
+     * Always 64 bit wide, so 64 bit targets can be read from 32 bit builds.
+     **/
+    typedef std::uint64_t remote_address;
+
+    /**
+     * @brief Describes a single piece of a gathered memory read.
+     **/
+    struct memory_transfer
+    {
+        memory_transfer();
+        memory_transfer(remote_address address, void* buffer,
+            std::size_t size);
+
+        remote_address address;
+        void* buffer;
+        std::size_t size;
+        bool succeeded;
+    };
+
+    /**
+     * @brief Reads a range of memory from another process.
+     * Throws if the range can't be read completely.
+     *
+     * @param proc The process to read from.
+     * @param address The remote address to start reading at.
+     * @param buffer The local buffer to read into.
+     * @param size The number of bytes to read.
+     **/
+    void read_memory(process const& proc, remote_address address,
+        void* buffer, std::size_t size);
+
+    /**
+     * @brief Performs a gathered read of many ranges at once.
+     * The ranges are read with as few system calls as possible. A range
+     * which can't be read doesn't abort the operation, only its succeeded
+     * flag is cleared. Throws if the process can't be accessed at all.
+     *
+     * @param proc The process to read from.
+     * @param begin Pointer to the first transfer.
+     * @param end Pointer past the last transfer.
+     * @return :size_t The number of transfers which succeeded.
+     **/
+    std::size_t read_memory(process const& proc, memory_transfer* begin,
+        memory_transfer* end);
+
+    /**
+     * @brief Performs a gathered read of many ranges at once.
+     *
+     * @param proc The process to read from.
+     * @param transfers The transfers to perform.
+     * @return :size_t The number of transfers which succeeded.
+     * @see read_memory
+     **/
+    std::size_t read_memory(process const& proc,
+        std::vector<memory_transfer>& transfers);
+
+    /**
+     * @brief Describes a multi-level pointer chain.
+     * Starting at base, each but the last offset is added to the current
+     * address and the pointer stored there is followed. The last offset is
+     * added to the final pointer. An empty chain resolves to base.
+     **/
+    struct pointer_chain
+    {
+        pointer_chain();
+        explicit pointer_chain(remote_address base,
+            std::vector<std::int64_t> offsets = std::vector<std::int64_t>());
+
+        remote_address base;
+        std::vector<std::int64_t> offsets;
+    };
+
+    /**
+     * @brief Resolves a pointer chain.
+     *
+     * @param proc The process to read from.
+     * @param chain The chain to resolve.
+     * @param pointer_size Size of a pointer in the remote process, 4 or 8.
+     * @return :optional< berry::remote_address > The resolved address, or
+     * nothing if a level couldn't be read.
+     **/
+    boost::optional<remote_address> resolve_pointer_chain(process const& proc,
+        pointer_chain const& chain, std::size_t pointer_size = sizeof(void*));
+
+    /**
+     * @brief Resolves many pointer chains at once.
+     * All chains are walked in lockstep, so each level of all chains costs
+     * a single gathered read.
+     *
+     * @param proc The process to read from.
+     * @param chains The chains to resolve.
+     * @param pointer_size Size of a pointer in the remote process, 4 or 8.
+     * @return :vector< optional< berry::remote_address > > The resolved
+     * addresses, in the order of the chains.
+     **/
+    std::vector<boost::optional<remote_address> > resolve_pointer_chains(
+        process const& proc, std::vector<pointer_chain> const& chains,
+        std::size_t pointer_size = sizeof(void*));
+}
+
+#endif // __BERRY_REMOTEMEMORY_HPP__
@@ -0,0 +1,324 @@
+/**
+ * @file remote_ptr.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Typed pointers into other processes and remote struct layouts.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_REMOTEPTR_HPP__
+#define __BERRY_REMOTEPTR_HPP__ 1
+
+// C++ Standard Library:
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <stdexcept>
+#include <type_traits>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/remote_memory.hpp>
+
+namespace berry
+{
+    /**
+     * @brief A typed pointer to an object living in another process.
+     * Only trivially copyable types can be read this way.
+     **/
+    template<typename T>
+    class remote_ptr
+    {
+        static_assert(std::is_trivially_copyable<T>::value,
+            "remote_ptr requires a trivially copyable type");
+
+    private:
+        remote_address m_address;
+
+    public:
+        typedef T element_type;
+
+        /**
+         * @brief Constructs a null pointer.
+         **/
+        remote_ptr()
+            : m_address(0)
+        { }
+
+        /**
+         * @brief Constructs a pointer to the specified remote address.
+         *
+         * @param address The remote address.
+         **/
+        explicit remote_ptr(remote_address address)
+            : m_address(address)
+        { }
+
+        /**
+         * @brief Returns the remote address the pointer points to.
+         *
+         * @return :remote_address The address.
+         **/
+        remote_address address() const
+        {
+            return m_address;
+        }
+
+        /**
+         * @brief Reads the pointed-to object.
+         *
+         * @param proc The process the pointer points into.
+         * @return T A local copy of the remote object.
+         **/
+        T read(process const& proc) const
+        {
+            T result;
+            read_memory(proc, m_address, &result, sizeof(T));
+            return result;
+        }
+
+        /**
+         * @brief Reads count consecutive objects with a single read.
+         *
+         * @param proc The process the pointer points into.
+         * @param count The number of objects to read.
+         * @return :vector< T > Local copies of the remote objects.
+         **/
+        std::vector<T> read_array(process const& proc, std::size_t count) const
+        {
+            std::vector<T> result(count);
+            if(count)
+                read_memory(proc, m_address, result.data(), count * sizeof(T));
+            return result;
+        }
+
+        /**
+         * @brief Returns a pointer to a member at a byte offset.
+         *
+         * @param offset The member's offset in the remote object.
+         * @return :remote_ptr< U > The member pointer.
+         **/
+        template<typename U>
+        remote_ptr<U> member(std::size_t offset) const
+        {
+            return remote_ptr<U>(m_address + offset);
+        }
+
+        remote_ptr operator+(std::ptrdiff_t n) const
+        {
+            return remote_ptr(m_address + n * sizeof(T));
+        }
+
+        remote_ptr operator-(std::ptrdiff_t n) const
+        {
+            return remote_ptr(m_address - n * sizeof(T));
+        }
+
+        remote_ptr& operator+=(std::ptrdiff_t n)
+        {
+            m_address += n * sizeof(T);
+            return *this;
+        }
+
+        remote_ptr& operator-=(std::ptrdiff_t n)
+        {
+            m_address -= n * sizeof(T);
+            return *this;
+        }
+
+        explicit operator bool() const
+        {
+            return m_address != 0;
+        }
+    };
+
+    template<typename T>
+    bool operator==(remote_ptr<T> const& lhs, remote_ptr<T> const& rhs)
+    {
+        return lhs.address() == rhs.address();
+    }
+
+    template<typename T>
+    bool operator!=(remote_ptr<T> const& lhs, remote_ptr<T> const& rhs)
+    {
+        return lhs.address() != rhs.address();
+    }
+
+    template<typename T>
+    bool operator<(remote_ptr<T> const& lhs, remote_ptr<T> const& rhs)
+    {
+        return lhs.address() < rhs.address();
+    }
+
+    /**
+     * @brief Maps a member of a local struct to an offset in a remote struct.
+     * Use BERRY_REMOTE_FIELD to declare fields.
+     **/
+    template<typename MemberPtr, MemberPtr Member, std::size_t Offset>
+    struct remote_field;
+
+    template<typename T, typename M, M T::*Member, std::size_t Offset>
+    struct remote_field<M T::*, Member, Offset>
+    {
+        static_assert(std::is_trivially_copyable<M>::value,
+            "remote fields require a trivially copyable type");
+
+        typedef T struct_type;
+        typedef M value_type;
+        static std::size_t const offset = Offset;
+        static std::size_t const size = sizeof(M);
+
+        static memory_transfer make_transfer(remote_address base, T& out)
+        {
+            return memory_transfer(base + Offset, &(out.*Member), sizeof(M));
+        }
+    };
+
+    /**
+     * @brief Declares a field of a remote layout.
+     * Example: BERRY_REMOTE_FIELD(player, health, 0x48)
+     **/
+#   define BERRY_REMOTE_FIELD(type, member, offset) \
+        ::berry::remote_field<decltype(&type::member), &type::member, (offset)>
+
+    namespace detail
+    {
+        namespace remote
+        {
+            template<typename T, typename... Fields>
+            struct fill_transfers;
+
+            template<typename T>
+            struct fill_transfers<T>
+            {
+                static void apply(remote_address, T&, memory_transfer*)
+                { }
+            };
+
+            template<typename T, typename Field, typename... Rest>
+            struct fill_transfers<T, Field, Rest...>
+            {
+                static_assert(std::is_same<T,
+                    typename Field::struct_type>::value,
+                    "remote field belongs to a different struct");
+
+                static void apply(remote_address base, T& out,
+                    memory_transfer* transfers)
+                {
+                    *transfers = Field::make_transfer(base, out);
+                    fill_transfers<T, Rest...>::apply(base, out,
+                        transfers + 1);
+                }
+            };
+        }
+    }
+
+    /**
+     * @brief Describes the layout of a remote struct at compile time.
+     * The remote struct may have any layout, only the listed fields are
+     * read and stored into the members of the local type T. Example:
+     *
+     * typedef berry::remote_layout<player,
+     *     BERRY_REMOTE_FIELD(player, health, 0x48),
+     *     BERRY_REMOTE_FIELD(player, name, 0x100)> player_layout;
+     **/
+    template<typename T, typename... Fields>
+    struct remote_layout
+    {
+        typedef T value_type;
+        static std::size_t const field_count = sizeof...(Fields);
+
+        /**
+         * @brief Creates one transfer per field, targeting out's members.
+         *
+         * @param base The remote address of the struct.
+         * @param out The local object to read into.
+         * @param transfers Array of at least field_count transfers.
+         **/
+        static void make_transfers(remote_address base, T& out,
+            memory_transfer* transfers)
+        {
+            detail::remote::fill_transfers<T, Fields...>::apply(base, out,
+                transfers);
+        }
+    };
+
+    /**
+     * @brief Reads all fields of a remote struct with one gathered read.
+     *
+     * @param proc The process to read from.
+     * @param address The remote address of the struct.
+     * @param out The local object to read into. Members which are not part
+     * of the layout are left untouched.
+     **/
+    template<typename Layout>
+    void read_layout(process const& proc, remote_address address,
+        typename Layout::value_type& out)
+    {
+        std::array<memory_transfer, Layout::field_count> transfers;
+        Layout::make_transfers(address, out, transfers.data());
+        std::size_t const read = read_memory(proc, transfers.data(),
+            transfers.data() + transfers.size());
+        if(read != transfers.size())
+            throw std::runtime_error(
+                "berry::read_layout : remote struct not readable");
+    }
+
+    /**
+     * @brief Reads many remote structs of the same layout with one gathered
+     * read.
+     *
+     * @param proc The process to read from.
+     * @param addresses The remote addresses of the structs.
+     * @param succeeded Optionally receives one flag per struct telling
+     * whether all of its fields could be read.
+     * @return :vector< Layout::value_type > The read structs, value
+     * initialized before reading.
+     **/
+    template<typename Layout>
+    std::vector<typename Layout::value_type> read_layouts(process const& proc,
+        std::vector<remote_address> const& addresses,
+        std::vector<bool>* succeeded = 0)
+    {
+        typedef typename Layout::value_type value_type;
+        std::size_t const fields = Layout::field_count;
+
+        std::vector<value_type> result(addresses.size());
+        std::vector<memory_transfer> transfers(addresses.size() * fields);
+        for(std::size_t i = 0; i < addresses.size(); ++i)
+        {
+            Layout::make_transfers(addresses[i], result[i],
+                transfers.data() + i * fields);
+        }
+        read_memory(proc, transfers);
+
+        if(succeeded)
+        {
+            succeeded->assign(addresses.size(), true);
+            for(std::size_t i = 0; i < transfers.size(); ++i)
+            {
+                if(!transfers[i].succeeded)
+                    (*succeeded)[i / fields] = false;
+            }
+        }
+        return result;
+    }
+}
+
+#endif // __BERRY_REMOTEPTR_HPP__
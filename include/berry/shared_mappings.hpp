@@ -0,0 +1,189 @@
+/**
+ * @file shared_mappings.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Public API to find files mapped by several processes.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_SHAREDMAPPINGS_HPP__
+#define __BERRY_SHAREDMAPPINGS_HPP__ 1
+
+// C++ Standard Library:
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/remote_memory.hpp>
+
+#ifdef BERRY_LINUX
+namespace berry
+{
+    /**
+     * @brief What backs a mapped file.
+     **/
+    enum mapping_kind
+    {
+        /**
+         * @brief A file with a name, including POSIX shared memory.
+         **/
+        mapping_file,
+
+        /**
+         * @brief A file deleted while still mapped, its pages stay in use
+         * until the last mapping is gone.
+         **/
+        mapping_deleted,
+
+        /**
+         * @brief An anonymous file created by memfd_create.
+         **/
+        mapping_memfd,
+
+        /**
+         * @brief A System V shared memory segment or shared anonymous
+         * memory, which shows as a deleted /dev/zero.
+         **/
+        mapping_shm
+    };
+
+    /**
+     * @brief A file mapped by at least one process.
+     **/
+    struct mapped_file
+    {
+        std::uint64_t device;
+        std::uint64_t inode;
+
+        /**
+         * @brief The path as in the maps file, without the " (deleted)"
+         * marker. Stored once per file, however often it is mapped.
+         **/
+        std::string path;
+
+        mapping_kind kind;
+
+        /**
+         * @brief The number of distinct processes mapping the file.
+         **/
+        std::size_t processes;
+
+        /**
+         * @brief The size of all mappings of the file, in bytes.
+         **/
+        std::uint64_t mapped_bytes;
+    };
+
+    /**
+     * @brief One mapping of a file into a process.
+     **/
+    struct file_mapping
+    {
+        pid_type pid;
+        remote_address begin;
+        remote_address end;
+
+        /**
+         * @brief The offset into the file the mapping starts at.
+         **/
+        std::uint64_t offset;
+    };
+
+    /**
+     * @brief Maps files to the processes and regions mapping them.
+     * Built in one pass over /proc/<pid>/maps of all processes. Anonymous
+     * memory isn't indexed, neither are processes the caller may not
+     * ptrace.
+     **/
+    class shared_mapping_index
+    {
+    private:
+        struct record
+        {
+            std::uint32_t file;
+            pid_type pid;
+            remote_address begin;
+            remote_address end;
+            std::uint64_t offset;
+        };
+
+        std::vector<mapped_file> m_files;
+        std::vector<record> m_records;
+
+    public:
+        /**
+         * @brief Indexes the mappings of all processes.
+         *
+         * @param workers The number of worker threads, 0 means one per
+         * core.
+         **/
+        explicit shared_mapping_index(unsigned workers = 0);
+
+        /**
+         * @brief Looks up a file.
+         *
+         * @param device The file's device, as st_dev of stat.
+         * @param inode The file's inode.
+         * @return :mapped_file const* The file or null if nobody maps it.
+         **/
+        mapped_file const* find(std::uint64_t device,
+            std::uint64_t inode) const;
+
+        /**
+         * @brief Returns the mappings of a file.
+         *
+         * @param file A file of this index.
+         * @return :vector< berry::file_mapping > The mappings, by pid and
+         * address.
+         **/
+        std::vector<file_mapping> mappings(mapped_file const& file) const;
+
+        /**
+         * @brief Returns the files mapped by several processes.
+         *
+         * @param min_processes The minimum number of processes.
+         * @return :vector< berry::mapped_file const* > The files, most
+         * mapped bytes first.
+         **/
+        std::vector<mapped_file const*> shared_files(
+            std::size_t min_processes = 2) const;
+
+        /**
+         * @brief Returns the files of a kind, e.g. all deleted files which
+         * are still mapped.
+         *
+         * @param kind The kind to look for.
+         * @return :vector< berry::mapped_file const* > The files.
+         **/
+        std::vector<mapped_file const*> files_of_kind(
+            mapping_kind kind) const;
+
+        /**
+         * @brief Returns all indexed files, sorted by device and inode.
+         *
+         * @return :vector< berry::mapped_file > const& The files.
+         **/
+        std::vector<mapped_file> const& files() const;
+    };
+}
+#endif // BERRY_LINUX
+
+#endif // __BERRY_SHAREDMAPPINGS_HPP__
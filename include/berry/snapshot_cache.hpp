@@ -0,0 +1,103 @@
+/**
+ * @file snapshot_cache.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Public API to share process tables between threads.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_SNAPSHOTCACHE_HPP__
+#define __BERRY_SNAPSHOTCACHE_HPP__ 1
+
+// C++ Standard Library:
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+// Berry:
+#include <berry/process_table.hpp>
+
+namespace berry
+{
+    /**
+     * @brief Shares one process table between threads and rebuilds it once
+     * it is older than a maximum age.
+     * The current table is swapped atomically, so readers never wait for a
+     * lock while a table is fresh. A stale table is rebuilt by one caller,
+     * callers arriving during the rebuild keep the old table instead of
+     * starting another one. Only the very first request waits.
+     **/
+    class snapshot_cache
+    {
+    public:
+        /**
+         * @brief Builds a new table.
+         **/
+        typedef std::function<process_table ()> source_type;
+
+    private:
+        std::shared_ptr<process_table const> m_current;
+        std::chrono::steady_clock::duration m_max_age;
+        source_type m_source;
+        std::mutex m_refresh_mutex;
+        std::atomic<std::size_t> m_refreshes;
+
+        std::shared_ptr<process_table const> rebuild();
+
+    public:
+        /**
+         * @brief Creates an empty cache.
+         *
+         * @param max_age The age after which a table is rebuilt.
+         * @param source Builds the tables, by default from a snapshot of
+         * all processes.
+         **/
+        explicit snapshot_cache(std::chrono::steady_clock::duration max_age =
+            std::chrono::seconds(1), source_type source = source_type());
+
+        snapshot_cache(snapshot_cache const&) = delete;
+        snapshot_cache& operator=(snapshot_cache const&) = delete;
+
+        /**
+         * @brief Returns the current table, rebuilding it if it is stale.
+         *
+         * @return :shared_ptr< berry::process_table const > The table.
+         **/
+        std::shared_ptr<process_table const> get();
+
+        /**
+         * @brief Rebuilds the table regardless of its age.
+         * Waits for a rebuild in progress and returns its result instead.
+         *
+         * @return :shared_ptr< berry::process_table const > The new table.
+         **/
+        std::shared_ptr<process_table const> refresh();
+
+        /**
+         * @brief Returns the number of tables built so far.
+         *
+         * @return :size_t The number of rebuilds.
+         **/
+        std::size_t refreshes() const;
+    };
+}
+
+#endif // __BERRY_SNAPSHOTCACHE_HPP__
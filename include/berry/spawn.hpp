@@ -0,0 +1,169 @@
+/**
+ * @file spawn.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Public API to start processes.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_SPAWN_HPP__
+#define __BERRY_SPAWN_HPP__ 1
+
+// C++ Standard Library:
+#include <map>
+#include <string>
+#include <vector>
+
+// Boost Library:
+#include <boost/filesystem/path.hpp>
+#include <boost/optional.hpp>
+
+// Berry:
+#include <berry/process.hpp>
+
+#ifdef BERRY_LINUX
+namespace berry
+{
+    namespace unix_like
+    {
+        /**
+         * @brief What to connect a standard stream of a child to.
+         **/
+        enum stdio_mode
+        {
+            stdio_inherit,
+            stdio_pipe,
+            stdio_null
+        };
+
+        /**
+         * @brief Options controlling how a process is spawned.
+         **/
+        struct spawn_options
+        {
+            spawn_options();
+
+            /**
+             * @brief The arguments, including argv[0].
+             * If empty, argv[0] is set to the executable path.
+             **/
+            std::vector<std::string> arguments;
+
+            /**
+             * @brief The environment as KEY=VALUE strings.
+             * If not set, the parent's environment is inherited.
+             **/
+            boost::optional<std::vector<std::string> > environment;
+
+            /**
+             * @brief The working directory, the parent's if empty.
+             **/
+            boost::filesystem::path working_directory;
+
+            stdio_mode stdin_mode;
+            stdio_mode stdout_mode;
+            stdio_mode stderr_mode;
+
+            /**
+             * @brief Additional descriptors to pass, child fd -> parent fd.
+             * Targets may overlap with sources, the mapping is applied as if
+             * all sources were duplicated at once.
+             **/
+            std::map<int, int> fd_map;
+        };
+
+        /**
+         * @brief A spawned process and the parent's ends of its pipes.
+         * The pipe ends are closed on destruction, the process isn't
+         * waited for.
+         **/
+        class spawned_process
+        {
+        public:
+            spawned_process();
+            spawned_process(spawned_process&& other);
+            ~spawned_process();
+            spawned_process& operator=(spawned_process&& other);
+
+            spawned_process(spawned_process const&) = delete;
+            spawned_process& operator=(spawned_process const&) = delete;
+
+            /**
+             * @brief The process, holding a pidfd for exit tracking.
+             **/
+            process proc;
+
+            /**
+             * @brief Write end of the child's stdin pipe or -1.
+             **/
+            int stdin_fd;
+
+            /**
+             * @brief Read end of the child's stdout pipe or -1.
+             **/
+            int stdout_fd;
+
+            /**
+             * @brief Read end of the child's stderr pipe or -1.
+             **/
+            int stderr_fd;
+        };
+
+        /**
+         * @brief Starts a new process.
+         * Uses posix_spawn, which creates the child with vfork semantics:
+         * the parent's page tables are never copied, so spawning from a
+         * process with a huge heap is as fast as from a small one.
+         *
+         * @param executable The program to start, not searched in PATH.
+         * @param options How to start it.
+         * @return :spawned_process The new process.
+         **/
+        spawned_process spawn(boost::filesystem::path const& executable,
+            spawn_options const& options = spawn_options());
+
+        /**
+         * @brief How a process ended.
+         **/
+        struct exit_status
+        {
+            /**
+             * @brief True if the process called exit, false if a signal
+             * killed it.
+             **/
+            bool exited;
+
+            /**
+             * @brief The exit code or the number of the killing signal.
+             **/
+            int code;
+        };
+
+        /**
+         * @brief Waits for a child process to end and reaps it.
+         * Waits on the process' pidfd if available.
+         *
+         * @param proc A child of the calling process.
+         * @return :exit_status How the process ended.
+         **/
+        exit_status wait_for_exit(process const& proc);
+    }
+}
+#endif // BERRY_LINUX
+
+#endif // __BERRY_SPAWN_HPP__
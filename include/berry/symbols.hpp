@@ -0,0 +1,258 @@
+/**
+ * @file symbols.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Public API to resolve addresses to ELF symbols.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_SYMBOLS_HPP__
+#define __BERRY_SYMBOLS_HPP__ 1
+
+// C++ Standard Library:
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Boost Library:
+#include <boost/filesystem/path.hpp>
+#include <boost/optional.hpp>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/module.hpp>
+#include <berry/remote_memory.hpp>
+
+#ifdef BERRY_LINUX
+namespace berry
+{
+    /**
+     * @brief A symbol of an ELF file.
+     **/
+    struct elf_symbol
+    {
+        /**
+         * @brief Virtual address of the symbol as stored in the file.
+         **/
+        std::uint64_t address;
+        std::uint64_t size;
+
+        /**
+         * @brief Points into the mapped file, valid while the table lives.
+         **/
+        char const* name;
+    };
+
+    /**
+     * @brief Sorted address index over the symbols of an ELF file.
+     * The file is mapped once and stays mapped, so symbol names are never
+     * copied. Both .symtab and .dynsym are read, which makes stripped
+     * libraries resolve to their exported symbols.
+     **/
+    class symbol_table
+    {
+    private:
+        void* m_mapping;
+        std::size_t m_mapping_size;
+        std::uint64_t m_load_delta;
+        std::vector<elf_symbol> m_symbols;
+
+        void load(int fd, std::uint64_t device, std::uint64_t inode);
+
+    public:
+        /**
+         * @brief Constructs an empty table.
+         **/
+        symbol_table();
+
+        /**
+         * @brief Reads the symbols of an ELF file.
+         * Files which aren't ELF files or can't be read yield an empty
+         * table.
+         *
+         * @param path The file to read.
+         * @param device If not zero, the file is only used if its device
+         * and inode match, so a replaced file isn't parsed by accident.
+         * @param inode See device.
+         **/
+        explicit symbol_table(boost::filesystem::path const& path,
+            std::uint64_t device = 0, std::uint64_t inode = 0);
+
+        /**
+         * @brief Reads the symbols of an opened ELF file.
+         *
+         * @param fd A readable descriptor of the file, it isn't closed.
+         * @param device If not zero, the file is only used if its device
+         * and inode match.
+         * @param inode See device.
+         **/
+        symbol_table(int fd, std::uint64_t device, std::uint64_t inode);
+
+        /**
+         * @brief Unmaps the file.
+         **/
+        ~symbol_table();
+
+        symbol_table(symbol_table const&) = delete;
+        symbol_table& operator=(symbol_table const&) = delete;
+
+        /**
+         * @brief Finds the symbol containing a file address.
+         * Symbols without size match every address up to the next symbol.
+         *
+         * @param address The virtual address as used inside the file.
+         * @return :elf_symbol const* The symbol or null.
+         **/
+        elf_symbol const* find(std::uint64_t address) const;
+
+        /**
+         * @brief Converts the base a module is mapped at to its load bias.
+         * Adding the bias to a file address yields the runtime address.
+         *
+         * @param base Address the file offset 0 is mapped at.
+         * @return :uint64_t The load bias.
+         **/
+        std::uint64_t load_bias(remote_address base) const;
+
+        /**
+         * @brief Returns the symbols, sorted by address.
+         *
+         * @return :vector< berry::elf_symbol > const& The symbols.
+         **/
+        std::vector<elf_symbol> const& symbols() const;
+    };
+
+    /**
+     * @brief Shares parsed symbol tables between processes.
+     * Tables are keyed by the device and inode of their file, so a library
+     * mapped by a thousand processes is parsed once. Thread safe.
+     **/
+    class symbol_cache
+    {
+    private:
+        struct entry
+        {
+            std::once_flag loaded;
+            std::shared_ptr<symbol_table const> table;
+        };
+
+        typedef std::pair<std::uint64_t, std::uint64_t> key_type;
+
+        mutable std::mutex m_mutex;
+        std::map<key_type, std::shared_ptr<entry> > m_entries;
+
+    public:
+        /**
+         * @brief Returns the symbol table of a module, parsing it if needed.
+         *
+         * @param proc The process the module belongs to. Its root directory
+         * is used to open the file, so containers are handled correctly.
+         * @param mod The module.
+         * @return :shared_ptr< berry::symbol_table const > The table.
+         **/
+        std::shared_ptr<symbol_table const> get(process const& proc,
+            module const& mod);
+
+        /**
+         * @brief Returns the number of cached tables.
+         *
+         * @return :size_t The number of tables.
+         **/
+        std::size_t size() const;
+
+        /**
+         * @brief Drops all cached tables.
+         * Tables still referenced elsewhere stay alive until released.
+         **/
+        void clear();
+    };
+
+    /**
+     * @brief Returns the process wide default symbol cache.
+     *
+     * @return :symbol_cache& The cache.
+     **/
+    symbol_cache& default_symbol_cache();
+
+    /**
+     * @brief The result of resolving an address.
+     **/
+    struct symbol_info
+    {
+        symbol_info();
+
+        module const* mod;
+        elf_symbol const* symbol;
+        std::uint64_t offset;
+    };
+
+    /**
+     * @brief Resolves addresses of one process to module!symbol+offset.
+     **/
+    class symbolizer
+    {
+    private:
+        std::vector<module> m_modules;
+        std::vector<std::shared_ptr<symbol_table const> > m_tables;
+
+    public:
+        /**
+         * @brief Loads the modules and symbol tables of a process.
+         *
+         * @param proc The process.
+         * @param cache The cache to take symbol tables from.
+         **/
+        explicit symbolizer(process const& proc,
+            symbol_cache& cache = default_symbol_cache());
+
+        /**
+         * @brief Resolves an address.
+         * If no symbol matches, the symbol is null and the offset is
+         * relative to the module's base.
+         *
+         * @param address The address to resolve.
+         * @return :optional< berry::symbol_info > Nothing if the address
+         * doesn't belong to a module.
+         **/
+        boost::optional<symbol_info> resolve(remote_address address) const;
+
+        /**
+         * @brief Formats an address as module!symbol+0xoffset.
+         * Falls back to module+0xoffset and plain 0xaddress.
+         *
+         * @param address The address to format.
+         * @return :string The formatted address.
+         **/
+        std::string symbolize(remote_address address) const;
+
+        /**
+         * @brief Returns the modules of the process.
+         *
+         * @return :vector< berry::module > const& The modules.
+         **/
+        std::vector<module> const& modules() const;
+    };
+}
+#endif // BERRY_LINUX
+
+#endif // __BERRY_SYMBOLS_HPP__
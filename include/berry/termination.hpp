@@ -0,0 +1,136 @@
+/**
+ * @file termination.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Public API to signal and terminate many processes at once.
+ * 
+ * This file is part of Berry.
+ * 
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_TERMINATION_HPP__
+#define __BERRY_TERMINATION_HPP__ 1
+
+// C++ Standard Library:
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/process_tree.hpp>
+
+#ifdef BERRY_LINUX
+namespace berry
+{
+    namespace unix_like
+    {
+        /**
+         * @brief Sends a signal to many processes.
+         * Signals are sent through the processes' pidfds where available.
+         * 
+         * @param procs The processes to signal.
+         * @param sig The signal to send.
+         * @return :size_t The number of processes the signal was delivered
+         * to.
+         **/
+        std::size_t signal_processes(std::vector<process> const& procs,
+            int sig);
+        
+        /**
+         * @brief Waits until processes exit or a deadline passes.
+         * All pidfds are watched by one epoll instance, so waiting for
+         * thousands of processes costs a handful of system calls.
+         * 
+         * @param procs The processes to wait for.
+         * @param timeout The maximum time to wait.
+         * @return :vector< bool > One flag per process, true if it exited.
+         **/
+        std::vector<bool> wait_for_exits(std::vector<process> const& procs,
+            std::chrono::milliseconds timeout);
+        
+        /**
+         * @brief Outcome of a termination request.
+         **/
+        struct termination_result
+        {
+            /**
+             * @brief Processes which exited after SIGTERM.
+             **/
+            std::vector<pid_type> terminated;
+            
+            /**
+             * @brief Processes which had to be killed with SIGKILL.
+             **/
+            std::vector<pid_type> killed;
+            
+            /**
+             * @brief Processes which were still alive at the end, e.g.
+             * because of missing permissions or uninterruptible sleep.
+             **/
+            std::vector<pid_type> survivors;
+        };
+        
+        /**
+         * @brief Terminates many processes at once.
+         * If freeze is set, all processes are stopped with SIGSTOP first,
+         * then SIGTERM and SIGCONT are sent. Processes alive after the
+         * grace period get SIGKILL.
+         * 
+         * @param procs The processes to terminate.
+         * @param grace The time processes get to exit after SIGTERM.
+         * @param freeze Pass true to stop all processes before signalling.
+         * @return :termination_result What happened to the processes.
+         **/
+        termination_result terminate_processes(
+            std::vector<process> const& procs,
+            std::chrono::milliseconds grace, bool freeze = true);
+        
+        /**
+         * @brief Terminates a process and all of its descendants.
+         * The subtree is computed from one snapshot. With freeze set, the
+         * subtree is stopped and then rescanned until it stops growing, so
+         * processes forking while being torn down (fork bombs) are caught.
+         * The calling process is never part of the subtree.
+         * 
+         * @param root The root of the subtree.
+         * @param grace The time processes get to exit after SIGTERM.
+         * @param freeze Pass true to stop the subtree before signalling.
+         * @return :termination_result What happened to the processes.
+         **/
+        termination_result terminate_tree(pid_type root,
+            std::chrono::milliseconds grace, bool freeze = true);
+        
+        /**
+         * @brief Terminates a process and all of its descendants, starting
+         * from a snapshot of the default ProcFS taken by the caller.
+         * Processes which exited or whose pid was reused since the snapshot
+         * are left out, rescans take fresh snapshots.
+         * 
+         * @param snapshot The process tree the subtree is taken from.
+         * @param root The root of the subtree.
+         * @param grace The time processes get to exit after SIGTERM.
+         * @param freeze Pass true to stop the subtree before signalling.
+         * @return :termination_result What happened to the processes.
+         **/
+        termination_result terminate_tree(process_tree const& snapshot,
+            pid_type root, std::chrono::milliseconds grace,
+            bool freeze = true);
+    }
+}
+#endif // BERRY_LINUX
+
+#endif // __BERRY_TERMINATION_HPP__
@@ -0,0 +1,109 @@
+/**
+ * @file thread_entry.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Public thread_entry API.
+ * 
+ * This file is part of Berry.
+ * 
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_THREADENTRY_HPP__
+#define __BERRY_THREADENTRY_HPP__ 1
+
+// C++ Standard Library:
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Boost Library:
+#include <boost/optional.hpp>
+
+// Berry:
+#include <berry/detail/process_detail.hpp>
+
+#ifdef BERRY_HAS_PROCFS
+namespace berry
+{
+    /**
+     * @brief Class representing a thread entry on the system.
+     **/
+    struct thread_entry
+    {
+        thread_entry();
+        
+        /**
+         * @brief The thread's id.
+         **/
+        detail::process::pid_type tid;
+        
+        /**
+         * @brief The id of the process the thread belongs to.
+         **/
+        detail::process::pid_type pid;
+        
+        std::string name;
+        
+        /**
+         * @brief The scheduling state as in proc(5), e.g. 'R' or 'S'.
+         **/
+        char state;
+        
+        std::chrono::microseconds user_time;
+        std::chrono::microseconds system_time;
+        
+        /**
+         * @brief The CPU the thread ran on last, -1 if unknown.
+         **/
+        int last_cpu;
+    };
+  
+    /**
+     * @brief Type used to store snapshots of threads.
+     **/
+    typedef std::shared_ptr<void> thread_snapshot;
+  
+    /**
+     * @brief Creates a snapshot of all threads of a process.
+     *
+     * @param pid The process to list the threads of.
+     * @return thread_snapshot The created snapshot.
+     **/
+    thread_snapshot create_thread_snapshot(detail::process::pid_type pid);
+   
+   /**
+    * @brief Extracts the next thread entry from the snapshot.
+    * Threads which exited after the snapshot was taken are skipped.
+    *
+    * @param snap The snapshot to extract from.
+    * @return :optional< berry::thread_entry > The next thread.
+    **/
+    boost::optional<thread_entry> extract_next_thread(thread_snapshot& snap);
+   
+    /**
+     * @brief Lists all threads of all processes on the system.
+     * The processes are split between a pool of worker threads, which is
+     * what makes a census of hundreds of thousands of threads fast.
+     *
+     * @param workers The number of worker threads, 0 means one per core.
+     * @return :vector< berry::thread_entry > All threads, grouped by process.
+     **/
+    std::vector<thread_entry> get_all_threads(unsigned workers = 0);
+}
+#endif // BERRY_HAS_PROCFS
+
+#endif // __BERRY_THREADENTRY_HPP__
@@ -0,0 +1,102 @@
+/**
+ * @file thread_iterator.hpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Public thread_iterator API. 
+ * 
+ * This file is part of Berry.
+ * 
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BERRY_THREADITERATOR_HPP__
+#define __BERRY_THREADITERATOR_HPP__ 1
+
+// Boost Library:
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/optional.hpp>
+
+// Berry:
+#include <berry/thread_entry.hpp>
+
+#ifdef BERRY_HAS_PROCFS
+namespace berry
+{
+   /**
+    * @brief An incrementable iterator to walk the threads of a process.
+    **/
+   class thread_iterator
+      : public boost::iterator_facade< thread_iterator,
+                                       thread_entry const,
+                                       boost::incrementable_traversal_tag>
+   {
+      friend class boost::iterator_core_access;
+      
+   private:
+      thread_snapshot m_snap;
+      boost::optional<thread_entry> m_entry;
+
+      void increment();
+      bool equal(thread_iterator const& other) const;
+      thread_entry const& dereference() const;
+      
+   public:
+      /**
+       * @brief Default constructor creating an invalid iterator.
+       **/
+      thread_iterator();
+      
+      /**
+       * @brief Constructor creating a valid iterator.
+       *
+       * @param pid The process whose threads to walk.
+       **/
+      explicit thread_iterator(detail::process::pid_type pid);
+   };
+   
+   /**
+    * @brief A begin/end interface to walk the threads of a process.
+    **/
+   class thread_list
+   {
+   private:
+      detail::process::pid_type m_pid;
+      
+   public:
+      /**
+       * @brief Constructs a list of the threads of a process.
+       *
+       * @param pid The process whose threads to walk.
+       **/
+      explicit thread_list(detail::process::pid_type pid);
+      
+      /**
+       * @brief Returns an iterator to the begin of the list.
+       *
+       * @return :thread_iterator An iterator to the begin of the list.
+       **/
+      thread_iterator begin() const;
+      
+      /**
+       * @brief Returns an iterator to the end of the list.
+       *
+       * @return :thread_iterator An iterator to the end of the list.
+       **/
+      thread_iterator end() const;
+   };
+}
+#endif // BERRY_HAS_PROCFS
+
+#endif // __BERRY_THREADITERATOR_HPP__
@@ -162,7 +162,7 @@ static void export_process_hpp()
 #ifdef BERRY_HAS_PROCFS
     { //::berry::unix_like::get_procfs_dir
         typedef ::boost::filesystem::path (*get_procfs_dir_function_type)
-            (::berry::process);
+            (::berry::process const&);
         
         bp::def( 
             "get_procfs_dir",
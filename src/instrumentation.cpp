@@ -0,0 +1,556 @@
+/**
+ * @file instrumentation.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Instrumentation counters.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// C++ Standard Library:
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Berry:
+#include <berry/instrumentation.hpp>
+#include <berry/detail/instrumentation.hpp>
+
+/******** Free helper functions ********/
+namespace
+{
+    char const* const api_names[berry::api_count] = {
+        "create_process_snapshot",
+        "extract_next_process",
+        "process::name",
+        "process::executable_path",
+        "process::bitness",
+        "process::still_exists",
+        "read_memory",
+        "other" };
+
+    char const* const operation_names[berry::procfs_operation_count] = {
+        "list directory",
+        "read stat",
+        "read status",
+        "read comm",
+        "read cmdline",
+        "read environ",
+        "read maps",
+        "read other" };
+
+#ifdef BERRY_INSTRUMENTATION
+    // Buckets 0-15 hold their value, above that every power of two is
+    // split into 16 linear sub-buckets.
+    std::size_t bucket_of(std::uint64_t value)
+    {
+        if(value < 16)
+            return static_cast<std::size_t>(value);
+        unsigned shift = 0;
+        while((value >> shift) >= 32)
+            ++shift;
+        return 16 + shift * 16 +
+            static_cast<std::size_t>((value >> shift) & 15);
+    }
+
+    enum counter
+    {
+        counter_calls,
+        counter_syscalls,
+        counter_opens,
+        counter_bytes_read,
+        counter_nanoseconds,
+        counter_count
+    };
+
+    typedef std::uint64_t counter_table[berry::api_count][counter_count];
+
+    // The counters of one thread. Only the owner writes, so a relaxed load
+    // and store is enough and no locked instruction is needed. Aligned to
+    // a cache line, so threads never write to the same line.
+    struct alignas(64) thread_slot
+    {
+        thread_slot();
+        ~thread_slot();
+
+        std::atomic<std::uint64_t> values[berry::api_count][counter_count];
+        berry::instrumented_api current;
+
+        void add(berry::instrumented_api api, counter which,
+            std::uint64_t amount)
+        {
+            std::atomic<std::uint64_t>& value = values[api][which];
+            value.store(value.load(std::memory_order_relaxed) + amount,
+                std::memory_order_relaxed);
+        }
+    };
+
+    // All live slots plus the sums of exited threads.
+    struct slot_registry
+    {
+        slot_registry()
+            : mutex(), slots()
+        {
+            std::fill(&retired[0][0], &retired[0][0] +
+                berry::api_count * counter_count, 0);
+        }
+
+        std::mutex mutex;
+        std::vector<thread_slot*> slots;
+        counter_table retired;
+    };
+
+    slot_registry& registry()
+    {
+        static slot_registry instance;
+        return instance;
+    }
+
+    thread_slot::thread_slot()
+        : current(berry::api_other)
+    {
+        for(int api = 0; api < berry::api_count; ++api)
+        {
+            for(int which = 0; which < counter_count; ++which)
+                values[api][which].store(0, std::memory_order_relaxed);
+        }
+
+        slot_registry& slots = ::registry();
+        std::lock_guard<std::mutex> lock(slots.mutex);
+        slots.slots.push_back(this);
+    }
+
+    thread_slot::~thread_slot()
+    {
+        slot_registry& slots = ::registry();
+        std::lock_guard<std::mutex> lock(slots.mutex);
+        for(int api = 0; api < berry::api_count; ++api)
+        {
+            for(int which = 0; which < counter_count; ++which)
+            {
+                slots.retired[api][which] +=
+                    values[api][which].load(std::memory_order_relaxed);
+            }
+        }
+        slots.slots.erase(std::find(slots.slots.begin(), slots.slots.end(),
+            this));
+    }
+
+    thread_slot& local_slot()
+    {
+        static thread_local thread_slot slot;
+        return slot;
+    }
+
+    // Shared by all threads, a bucket increment is a single relaxed
+    // fetch_add.
+    std::atomic<std::uint64_t> g_histograms[berry::procfs_operation_count]
+        [berry::latency_histogram::bucket_count];
+
+    // A slot of the slow operation ring. The sequence is odd while the
+    // slot is written and 2 * (index + 1) afterwards, readers drop slots
+    // whose sequence changed while they copied them.
+    struct ring_slot
+    {
+        std::atomic<std::uint64_t> sequence;
+        std::atomic<std::uint64_t> file[4];
+        std::atomic<int> pid;
+        std::atomic<int> operation;
+        std::atomic<std::int64_t> duration;
+        std::atomic<std::int64_t> time;
+    };
+
+    std::size_t const ring_size = 128;
+    ring_slot g_ring[ring_size];
+    std::atomic<std::uint64_t> g_ring_head(0);
+    std::atomic<std::int64_t> g_slow_threshold(10 * 1000 * 1000);
+
+    berry::procfs_operation classify(char const* path, bool directory)
+    {
+        if(directory)
+            return berry::procfs_list_directory;
+
+        char const* name = std::strrchr(path, '/');
+        name = name ? name + 1 : path;
+        static std::pair<char const*, berry::procfs_operation> const
+            files[] = {
+                std::make_pair("stat", berry::procfs_read_stat),
+                std::make_pair("status", berry::procfs_read_status),
+                std::make_pair("comm", berry::procfs_read_comm),
+                std::make_pair("cmdline", berry::procfs_read_cmdline),
+                std::make_pair("environ", berry::procfs_read_environ),
+                std::make_pair("maps", berry::procfs_read_maps) };
+        for(std::size_t i = 0; i < sizeof(files) / sizeof(files[0]); ++i)
+        {
+            if(std::strcmp(name, files[i].first) == 0)
+                return files[i].second;
+        }
+        return berry::procfs_read_other;
+    }
+
+    // Paths relative to the ProcFS root start with the pid.
+    berry::pid_type pid_of(char const* path)
+    {
+        berry::pid_type pid = 0;
+        for(; *path >= '0' && *path <= '9'; ++path)
+            pid = pid * 10 + (*path - '0');
+        return *path == '/' || *path == '\0' ? pid : 0;
+    }
+
+    void record_slow(char const* path, berry::procfs_operation operation,
+        std::int64_t nanoseconds)
+    {
+        std::uint64_t const index =
+            g_ring_head.fetch_add(1, std::memory_order_relaxed);
+        ring_slot& slot = g_ring[index % ring_size];
+        slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        char file[sizeof(slot.file)] = { 0 };
+        std::strncpy(file, path, sizeof(file) - 1);
+        for(std::size_t i = 0; i < 4; ++i)
+        {
+            std::uint64_t word;
+            std::memcpy(&word, file + i * sizeof(word), sizeof(word));
+            slot.file[i].store(word, std::memory_order_relaxed);
+        }
+        slot.pid.store(::pid_of(path), std::memory_order_relaxed);
+        slot.operation.store(operation, std::memory_order_relaxed);
+        slot.duration.store(nanoseconds, std::memory_order_relaxed);
+        slot.time.store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count(),
+            std::memory_order_relaxed);
+        slot.sequence.store(2 * index + 2, std::memory_order_release);
+    }
+
+    void add_current(counter which, std::uint64_t amount)
+    {
+        thread_slot& slot = ::local_slot();
+        slot.add(slot.current, which, amount);
+    }
+#endif // BERRY_INSTRUMENTATION
+}
+
+/******** Static members ********/
+std::size_t const berry::latency_histogram::bucket_count;
+
+/******** Constructors and Destructor ********/
+berry::api_stats::api_stats()
+    : calls(0), syscalls(0), opens(0), bytes_read(0), nanoseconds(0)
+{ }
+
+berry::latency_histogram::latency_histogram()
+    : m_counts(bucket_count, 0), m_total(0)
+{ }
+
+berry::latency_histogram::latency_histogram(
+    std::vector<std::uint64_t> counts)
+    : m_counts(std::move(counts)), m_total(0)
+{
+    m_counts.resize(bucket_count, 0);
+    for(std::size_t i = 0; i < m_counts.size(); ++i)
+        m_total += m_counts[i];
+}
+
+berry::slow_operation::slow_operation()
+    : pid(0), operation(berry::procfs_read_other), duration(0), time()
+{
+    file[0] = '\0';
+}
+
+#ifdef BERRY_INSTRUMENTATION
+berry::detail::instrumentation::api_scope::api_scope(
+    berry::instrumented_api api)
+    : m_previous(::local_slot().current), m_active(m_previous != api),
+      m_start()
+{
+    if(m_active)
+    {
+        ::local_slot().current = api;
+        m_start = std::chrono::steady_clock::now();
+    }
+}
+
+berry::detail::instrumentation::api_scope::~api_scope()
+{
+    if(!m_active)
+        return;
+
+    std::chrono::nanoseconds const elapsed =
+        std::chrono::steady_clock::now() - m_start;
+    thread_slot& slot = ::local_slot();
+    slot.add(slot.current, ::counter_calls, 1);
+    slot.add(slot.current, ::counter_nanoseconds,
+        static_cast<std::uint64_t>(elapsed.count()));
+    slot.current = m_previous;
+}
+
+berry::detail::instrumentation::procfs_timer::procfs_timer(char const* path,
+    bool directory)
+    : m_path(path), m_directory(directory),
+      m_start(std::chrono::steady_clock::now())
+{ }
+
+berry::detail::instrumentation::procfs_timer::~procfs_timer()
+{
+    berry::detail::instrumentation::record_procfs(m_path, m_directory,
+        std::chrono::steady_clock::now() - m_start);
+}
+#endif // BERRY_INSTRUMENTATION
+
+/******** Member functions ********/
+std::uint64_t berry::latency_histogram::count() const
+{
+    return m_total;
+}
+
+std::chrono::nanoseconds berry::latency_histogram::value_at_percentile(
+    double percentile) const
+{
+    if(!m_total)
+        return std::chrono::nanoseconds(0);
+
+    double const share = std::min(std::max(percentile, 0.0), 100.0) / 100;
+    std::uint64_t const wanted = std::max<std::uint64_t>(1,
+        static_cast<std::uint64_t>(std::ceil(share * m_total)));
+    std::uint64_t seen = 0;
+    for(std::size_t i = 0; i < m_counts.size(); ++i)
+    {
+        seen += m_counts[i];
+        if(seen >= wanted)
+            return upper_bound(i);
+    }
+    return upper_bound(m_counts.size() - 1);
+}
+
+std::vector<std::uint64_t> const& berry::latency_histogram::counts() const
+{
+    return m_counts;
+}
+
+std::chrono::nanoseconds berry::latency_histogram::lower_bound(
+    std::size_t bucket)
+{
+    if(bucket < 16)
+        return std::chrono::nanoseconds(bucket);
+    std::size_t const shift = (bucket - 16) / 16;
+    std::uint64_t const sub = (bucket - 16) % 16;
+    return std::chrono::nanoseconds((16 + sub) << shift);
+}
+
+std::chrono::nanoseconds berry::latency_histogram::upper_bound(
+    std::size_t bucket)
+{
+    if(bucket < 16)
+        return std::chrono::nanoseconds(bucket);
+    std::size_t const shift = (bucket - 16) / 16;
+    return lower_bound(bucket) + std::chrono::nanoseconds(
+        (std::uint64_t(1) << shift) - 1);
+}
+
+/******** Free functions ********/
+#ifdef BERRY_INSTRUMENTATION
+void berry::detail::instrumentation::count_syscalls(std::uint64_t count)
+{
+    ::add_current(::counter_syscalls, count);
+}
+
+void berry::detail::instrumentation::count_open()
+{
+    ::add_current(::counter_syscalls, 1);
+    ::add_current(::counter_opens, 1);
+}
+
+void berry::detail::instrumentation::count_read(long long bytes)
+{
+    ::add_current(::counter_syscalls, 1);
+    if(bytes > 0)
+        ::add_current(::counter_bytes_read, static_cast<std::uint64_t>(bytes));
+}
+
+void berry::detail::instrumentation::count_batched_read(long long bytes)
+{
+    ::add_current(::counter_opens, 1);
+    if(bytes > 0)
+        ::add_current(::counter_bytes_read, static_cast<std::uint64_t>(bytes));
+}
+
+void berry::detail::instrumentation::record_procfs(char const* path,
+    bool directory, std::chrono::nanoseconds elapsed)
+{
+    std::int64_t const nanoseconds = elapsed.count();
+    berry::procfs_operation const operation = ::classify(path, directory);
+    ::g_histograms[operation][::bucket_of(
+        static_cast<std::uint64_t>(nanoseconds))].fetch_add(1,
+            std::memory_order_relaxed);
+    if(nanoseconds >= ::g_slow_threshold.load(std::memory_order_relaxed))
+        ::record_slow(path, operation, nanoseconds);
+}
+#endif // BERRY_INSTRUMENTATION
+
+bool berry::instrumentation_enabled()
+{
+#ifdef BERRY_INSTRUMENTATION
+    return true;
+#else
+    return false;
+#endif
+}
+
+berry::instrumentation_stats berry::get_instrumentation_stats()
+{
+    berry::instrumentation_stats result;
+#ifdef BERRY_INSTRUMENTATION
+    counter_table sums;
+    slot_registry& slots = ::registry();
+    {
+        std::lock_guard<std::mutex> lock(slots.mutex);
+        std::copy(&slots.retired[0][0], &slots.retired[0][0] +
+            berry::api_count * ::counter_count, &sums[0][0]);
+        for(std::size_t i = 0; i < slots.slots.size(); ++i)
+        {
+            for(int api = 0; api < berry::api_count; ++api)
+            {
+                for(int which = 0; which < ::counter_count; ++which)
+                {
+                    sums[api][which] += slots.slots[i]->values[api][which]
+                        .load(std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    for(int api = 0; api < berry::api_count; ++api)
+    {
+        berry::api_stats& stats = result.apis[api];
+        stats.calls = sums[api][::counter_calls];
+        stats.syscalls = sums[api][::counter_syscalls];
+        stats.opens = sums[api][::counter_opens];
+        stats.bytes_read = sums[api][::counter_bytes_read];
+        stats.nanoseconds = sums[api][::counter_nanoseconds];
+    }
+#endif // BERRY_INSTRUMENTATION
+    return result;
+}
+
+char const* berry::get_api_name(berry::instrumented_api api)
+{
+    return api >= 0 && api < berry::api_count ? ::api_names[api] : "";
+}
+
+char const* berry::get_procfs_operation_name(
+    berry::procfs_operation operation)
+{
+    return operation >= 0 && operation < berry::procfs_operation_count ?
+        ::operation_names[operation] : "";
+}
+
+berry::latency_histogram berry::get_procfs_latency(
+    berry::procfs_operation operation)
+{
+    std::vector<std::uint64_t> counts(berry::latency_histogram::bucket_count,
+        0);
+#ifdef BERRY_INSTRUMENTATION
+    if(operation >= 0 && operation < berry::procfs_operation_count)
+    {
+        for(std::size_t i = 0; i < counts.size(); ++i)
+        {
+            counts[i] = ::g_histograms[operation][i].load(
+                std::memory_order_relaxed);
+        }
+    }
+#else
+    (void)operation;
+#endif // BERRY_INSTRUMENTATION
+    return berry::latency_histogram(std::move(counts));
+}
+
+void berry::set_slow_operation_threshold(std::chrono::nanoseconds threshold)
+{
+#ifdef BERRY_INSTRUMENTATION
+    ::g_slow_threshold.store(threshold.count(), std::memory_order_relaxed);
+#else
+    (void)threshold;
+#endif // BERRY_INSTRUMENTATION
+}
+
+std::vector<berry::slow_operation> berry::get_slow_operations()
+{
+    std::vector<berry::slow_operation> result;
+#ifdef BERRY_INSTRUMENTATION
+    std::uint64_t const head = ::g_ring_head.load(std::memory_order_acquire);
+    std::uint64_t const first = head > ::ring_size ? head - ::ring_size : 0;
+    for(std::uint64_t index = first; index < head; ++index)
+    {
+        ::ring_slot const& slot = ::g_ring[index % ::ring_size];
+        std::uint64_t const sequence =
+            slot.sequence.load(std::memory_order_acquire);
+        if(sequence != 2 * index + 2)
+            continue;
+
+        berry::slow_operation operation;
+        for(std::size_t i = 0; i < 4; ++i)
+        {
+            std::uint64_t const word =
+                slot.file[i].load(std::memory_order_relaxed);
+            std::memcpy(operation.file + i * sizeof(word), &word,
+                sizeof(word));
+        }
+        operation.file[sizeof(operation.file) - 1] = '\0';
+        operation.pid = slot.pid.load(std::memory_order_relaxed);
+        operation.operation = static_cast<berry::procfs_operation>(
+            slot.operation.load(std::memory_order_relaxed));
+        operation.duration = std::chrono::nanoseconds(
+            slot.duration.load(std::memory_order_relaxed));
+        operation.time = std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<
+                std::chrono::system_clock::duration>(
+                    std::chrono::nanoseconds(
+                        slot.time.load(std::memory_order_relaxed))));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(slot.sequence.load(std::memory_order_relaxed) == sequence)
+            result.push_back(operation);
+    }
+#endif // BERRY_INSTRUMENTATION
+    return result;
+}
+
+berry::instrumentation_stats berry::operator-(
+    berry::instrumentation_stats const& later,
+    berry::instrumentation_stats const& earlier)
+{
+    berry::instrumentation_stats result;
+    for(int api = 0; api < berry::api_count; ++api)
+    {
+        berry::api_stats const& lhs = later.apis[api];
+        berry::api_stats const& rhs = earlier.apis[api];
+        berry::api_stats& stats = result.apis[api];
+        stats.calls = lhs.calls - rhs.calls;
+        stats.syscalls = lhs.syscalls - rhs.syscalls;
+        stats.opens = lhs.opens - rhs.opens;
+        stats.bytes_read = lhs.bytes_read - rhs.bytes_read;
+        stats.nanoseconds = lhs.nanoseconds - rhs.nanoseconds;
+    }
+    return result;
+}
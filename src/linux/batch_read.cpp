@@ -0,0 +1,344 @@
+/**
+ * @file linux/batch_read.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Batched ProcFS reads through io_uring with a synchronous fallback.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <berry/detail/system.hpp>
+#ifndef BERRY_LINUX
+#   error "Attempt to compile source file on a wrong system"
+#endif
+
+// System:
+#if defined(__has_include)
+#   if __has_include(<linux/io_uring.h>)
+#       include <linux/io_uring.h>
+#   endif
+#endif
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+// C++ Standard Library:
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+// Berry:
+#include <berry/detail/batch_read.hpp>
+#include <berry/detail/procfs.hpp>
+#include <berry/detail/instrumentation.hpp>
+
+namespace procfs = berry::detail::procfs;
+
+// Headers older than 5.17 lack completion skipping, the reader then always
+// takes the synchronous path. Fixed file slots (5.15) are older still.
+#if defined(IORING_FEAT_CQE_SKIP) && defined(IOSQE_CQE_SKIP_SUCCESS)
+#   define BERRY_HAVE_IO_URING 1
+#endif
+
+/******** Helper classes ********/
+#ifdef BERRY_HAVE_IO_URING
+// The raw io_uring interface, Berry doesn't depend on liburing.
+struct berry::detail::procfs::batch_reader::ring
+{
+    ring()
+        : fd(-1), rings(MAP_FAILED), rings_size(0), sqes(MAP_FAILED),
+          sqes_size(0), sq_tail(0), sq_mask(0), sq_array(0), cq_head(0),
+          cq_tail(0), cq_mask(0), cqes(0)
+    { }
+
+    ~ring()
+    {
+        if(sqes != MAP_FAILED)
+            ::munmap(sqes, sqes_size);
+        if(rings != MAP_FAILED)
+            ::munmap(rings, rings_size);
+        if(fd != -1)
+            ::close(fd);
+    }
+
+    int fd;
+    void* rings;
+    std::size_t rings_size;
+    void* sqes;
+    std::size_t sqes_size;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    ::io_uring_cqe* cqes;
+};
+#else
+struct berry::detail::procfs::batch_reader::ring
+{ };
+#endif // BERRY_HAVE_IO_URING
+
+/******** Free helper functions ********/
+namespace
+{
+    std::size_t const path_size = 32;
+
+#ifdef BERRY_HAVE_IO_URING
+    // Every file takes an openat, a read and a close.
+    unsigned const entries_per_file = 3;
+
+    std::uint64_t make_user_data(std::uint32_t generation, std::size_t index,
+        unsigned step)
+    {
+        return static_cast<std::uint64_t>(generation) << 32 |
+            static_cast<std::uint32_t>(index * ::entries_per_file + step);
+    }
+
+    template<typename T>
+    T* at_offset(void* base, std::uint32_t offset)
+    {
+        return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+    }
+
+    // Returns null if the kernel lacks io_uring or any feature used here.
+    std::unique_ptr<procfs::batch_reader::ring> make_ring(
+        std::size_t capacity)
+    {
+        typedef procfs::batch_reader::ring ring;
+        ::io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        std::unique_ptr<ring> result(new ring);
+        result->fd = static_cast<int>(::syscall(__NR_io_uring_setup,
+            static_cast<unsigned>(capacity * entries_per_file), &params));
+        if(result->fd == -1)
+            return std::unique_ptr<ring>();
+
+        // Skipping completions came with 5.17, after opening into and
+        // closing fixed file slots (5.15). Older kernels would silently
+        // ignore the slot and leak the descriptors.
+        if(!(params.features & IORING_FEAT_SINGLE_MMAP) ||
+            !(params.features & IORING_FEAT_CQE_SKIP))
+            return std::unique_ptr<ring>();
+
+        std::size_t const sq_size = params.sq_off.array +
+            params.sq_entries * sizeof(unsigned);
+        std::size_t const cq_size = params.cq_off.cqes +
+            params.cq_entries * sizeof(::io_uring_cqe);
+        result->rings_size = std::max(sq_size, cq_size);
+        result->rings = ::mmap(0, result->rings_size,
+            PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, result->fd,
+            IORING_OFF_SQ_RING);
+        result->sqes_size = params.sq_entries * sizeof(::io_uring_sqe);
+        result->sqes = ::mmap(0, result->sqes_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, result->fd, IORING_OFF_SQES);
+        if(result->rings == MAP_FAILED || result->sqes == MAP_FAILED)
+            return std::unique_ptr<ring>();
+
+        void* const rings = result->rings;
+        result->sq_tail = ::at_offset<unsigned>(rings, params.sq_off.tail);
+        result->sq_mask = ::at_offset<unsigned>(rings,
+            params.sq_off.ring_mask);
+        result->sq_array = ::at_offset<unsigned>(rings, params.sq_off.array);
+        result->cq_head = ::at_offset<unsigned>(rings, params.cq_off.head);
+        result->cq_tail = ::at_offset<unsigned>(rings, params.cq_off.tail);
+        result->cq_mask = ::at_offset<unsigned>(rings,
+            params.cq_off.ring_mask);
+        result->cqes = ::at_offset< ::io_uring_cqe>(rings,
+            params.cq_off.cqes);
+
+        // One empty fixed file slot per file of a batch.
+        std::vector<int> slots(capacity, -1);
+        if(::syscall(__NR_io_uring_register, result->fd,
+            IORING_REGISTER_FILES, slots.data(),
+            static_cast<unsigned>(slots.size())) != 0)
+            return std::unique_ptr<ring>();
+        return result;
+    }
+
+    ::io_uring_sqe& next_sqe(procfs::batch_reader::ring& ring,
+        unsigned& tail)
+    {
+        unsigned const index = tail++ & *ring.sq_mask;
+        ring.sq_array[index] = index;
+        ::io_uring_sqe& sqe = static_cast< ::io_uring_sqe*>(ring.sqes)[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        return sqe;
+    }
+#else
+    std::unique_ptr<procfs::batch_reader::ring> make_ring(std::size_t)
+    {
+        return std::unique_ptr<procfs::batch_reader::ring>();
+    }
+#endif // BERRY_HAVE_IO_URING
+}
+
+/******** Constructors and Destructor ********/
+berry::detail::procfs::batch_reader::batch_reader(std::size_t capacity,
+    std::size_t slot_size)
+    : m_ring(::make_ring(capacity)), m_capacity(capacity),
+      m_slot_size(slot_size), m_buffer(capacity * slot_size),
+      m_sizes(capacity, -1), m_paths(capacity * ::path_size),
+      m_finished(capacity, 0), m_generation(0)
+{ }
+
+berry::detail::procfs::batch_reader::~batch_reader()
+{ }
+
+/******** Member functions ********/
+bool berry::detail::procfs::batch_reader::batched() const
+{
+    return m_ring.get() != 0;
+}
+
+void berry::detail::procfs::batch_reader::read(int dirfd,
+    berry::pid_type const* pids, std::size_t count, char const* file)
+{
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        std::snprintf(&m_paths[i * ::path_size], ::path_size, "%d/%s",
+            pids[i], file);
+        m_sizes[i] = -1;
+    }
+
+    if(m_ring && read_ring(dirfd, count))
+        return;
+
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        m_sizes[i] = procfs::read_small_file(dirfd, &m_paths[i * ::path_size],
+            &m_buffer[i * m_slot_size], m_slot_size);
+    }
+}
+
+#ifdef BERRY_HAVE_IO_URING
+bool berry::detail::procfs::batch_reader::read_ring(int dirfd,
+    std::size_t count)
+{
+    // Each chain opens into fixed slot i, reads from it and closes it
+    // again. A failed open cancels the rest of the chain, a short read
+    // must not, or the slot would stay open.
+    ++m_generation;
+    unsigned tail = *m_ring->sq_tail;
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        ::io_uring_sqe& open = ::next_sqe(*m_ring, tail);
+        open.opcode = IORING_OP_OPENAT;
+        open.flags = IOSQE_IO_LINK | IOSQE_CQE_SKIP_SUCCESS;
+        open.fd = dirfd == -1 ? AT_FDCWD : dirfd;
+        open.addr = reinterpret_cast<std::uintptr_t>(
+            &m_paths[i * ::path_size]);
+        open.open_flags = O_RDONLY;
+        open.file_index = static_cast<std::uint32_t>(i + 1);
+        open.user_data = ::make_user_data(m_generation, i, 0);
+
+        ::io_uring_sqe& read = ::next_sqe(*m_ring, tail);
+        read.opcode = IORING_OP_READ;
+        read.flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+        read.fd = static_cast<int>(i);
+        read.addr = reinterpret_cast<std::uintptr_t>(
+            &m_buffer[i * m_slot_size]);
+        read.len = static_cast<std::uint32_t>(m_slot_size);
+        read.user_data = ::make_user_data(m_generation, i, 1);
+
+        ::io_uring_sqe& close = ::next_sqe(*m_ring, tail);
+        close.opcode = IORING_OP_CLOSE;
+        close.flags = IOSQE_CQE_SKIP_SUCCESS;
+        close.file_index = static_cast<std::uint32_t>(i + 1);
+        close.user_data = ::make_user_data(m_generation, i, 2);
+    }
+    __atomic_store_n(m_ring->sq_tail, tail, __ATOMIC_RELEASE);
+    std::chrono::steady_clock::time_point const start =
+        std::chrono::steady_clock::now();
+
+    // Successful opens and closes post nothing. A chain is finished by
+    // the completion of its read or of its failed open, whose cancelled
+    // links may or may not post completions depending on the kernel.
+    // Those are told apart by the flags of finished chains and by the
+    // generation for completions arriving after their batch.
+    m_finished.assign(count, 0);
+    unsigned to_submit = static_cast<unsigned>(count * ::entries_per_file);
+    std::size_t finished = 0;
+    while(finished < count)
+    {
+        BERRY_COUNT_SYSCALLS(1);
+        long const submitted = ::syscall(__NR_io_uring_enter, m_ring->fd,
+            to_submit, static_cast<unsigned>(count - finished),
+            IORING_ENTER_GETEVENTS, 0, 0);
+        if(submitted == -1 && errno != EINTR && errno != EAGAIN &&
+            errno != EBUSY)
+        {
+            // Give up on the ring, the synchronous path rereads the batch.
+            m_ring.reset();
+            return false;
+        }
+        if(submitted > 0)
+            to_submit -= static_cast<unsigned>(submitted);
+
+        unsigned head = *m_ring->cq_head;
+        unsigned const end = __atomic_load_n(m_ring->cq_tail,
+            __ATOMIC_ACQUIRE);
+        for(; head != end; ++head)
+        {
+            ::io_uring_cqe const& cqe =
+                m_ring->cqes[head & *m_ring->cq_mask];
+            std::uint32_t const chain = static_cast<std::uint32_t>(
+                cqe.user_data);
+            std::size_t const index = chain / ::entries_per_file;
+            unsigned const step = chain % ::entries_per_file;
+            if(cqe.user_data >> 32 != m_generation || step == 2 ||
+                m_finished[index])
+                continue;
+
+            m_sizes[index] = cqe.res < 0 ? -1 : cqe.res;
+            m_finished[index] = 1;
+            ++finished;
+
+            // Chains are timed from the submission of their batch until
+            // they are reaped.
+            BERRY_COUNT_BATCHED_READ(m_sizes[index]);
+            BERRY_RECORD_PROCFS(&m_paths[index * ::path_size], false,
+                std::chrono::steady_clock::now() - start);
+        }
+        __atomic_store_n(m_ring->cq_head, head, __ATOMIC_RELEASE);
+    }
+    return true;
+}
+#else
+bool berry::detail::procfs::batch_reader::read_ring(int, std::size_t)
+{
+    return false;
+}
+#endif // BERRY_HAVE_IO_URING
+
+char const* berry::detail::procfs::batch_reader::data(
+    std::size_t index) const
+{
+    return &m_buffer[index * m_slot_size];
+}
+
+long berry::detail::procfs::batch_reader::size(std::size_t index) const
+{
+    return m_sizes[index];
+}
@@ -0,0 +1,211 @@
+/**
+ * @file linux/bounded_read.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief ProcFS reads with a deadline, run on a pool of helper threads.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <berry/detail/system.hpp>
+#ifndef BERRY_LINUX
+#   error "Attempt to compile source file on a wrong system"
+#endif
+
+// C++ Standard Library:
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+// Berry:
+#include <berry/detail/procfs.hpp>
+
+namespace procfs = berry::detail::procfs;
+
+/******** Helper classes ********/
+namespace
+{
+    // Shared by the caller and the helper, a helper stuck in the kernel
+    // writes into it long after the caller gave up.
+    struct read_request
+    {
+        std::shared_ptr<berry::unix_like::procfs_context const> context;
+        char path[64];
+        std::vector<char> buffer;
+        long result;
+        bool done;
+        bool abandoned;
+    };
+
+    enum submit_result
+    {
+        submit_queued,
+        submit_saturated,
+        submit_no_threads
+    };
+
+    class read_pool
+    {
+    public:
+        read_pool()
+            : m_mutex(), m_work(), m_finished(), m_queue(), m_threads(0),
+              m_idle(0)
+        { }
+
+        // Refuses requests no helper would pick up soon: when every
+        // helper is busy and no more may be started, they most likely hang
+        // on stuck processes, and queueing would cost each later read its
+        // full timeout.
+        submit_result submit(std::shared_ptr<read_request> const& request)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if(m_queue.size() >= m_idle)
+            {
+                if(m_threads >= max_threads)
+                    return submit_saturated;
+                try
+                {
+                    std::thread(&read_pool::run, this).detach();
+                    ++m_threads;
+                    ++m_idle;
+                }
+                catch(std::system_error const&)
+                {
+                    if(m_threads == 0)
+                        return submit_no_threads;
+                    if(m_queue.size() >= m_idle)
+                        return submit_saturated;
+                }
+            }
+            m_queue.push_back(request);
+            m_work.notify_one();
+            return submit_queued;
+        }
+
+        // Waits for the request, abandoning it when the deadline passes.
+        bool wait(std::shared_ptr<read_request> const& request,
+            std::chrono::steady_clock::time_point deadline)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if(m_finished.wait_until(lock, deadline,
+                [&]() { return request->done; }))
+                return true;
+            request->abandoned = true;
+            return false;
+        }
+
+    private:
+        // Enough to keep scanning while a few helpers hang on stuck
+        // processes. When all of them hang, reads time out at once.
+        static unsigned const max_threads = 16;
+
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            for(;;)
+            {
+                // Idle helpers go away after a while, a scan doesn't keep
+                // its threads forever.
+                if(!m_work.wait_for(lock, std::chrono::seconds(5),
+                    [&]() { return !m_queue.empty(); }))
+                {
+                    --m_idle;
+                    --m_threads;
+                    return;
+                }
+
+                std::shared_ptr<read_request> request = m_queue.front();
+                m_queue.pop_front();
+                if(request->abandoned)
+                    continue;
+
+                --m_idle;
+                lock.unlock();
+                long const result = procfs::append_file(
+                    request->context->fd(), request->path, request->buffer);
+                lock.lock();
+                ++m_idle;
+                request->result = result;
+                request->done = true;
+                m_finished.notify_all();
+            }
+        }
+
+        std::mutex m_mutex;
+        std::condition_variable m_work;
+        std::condition_variable m_finished;
+        std::deque<std::shared_ptr<read_request> > m_queue;
+        unsigned m_threads;
+        unsigned m_idle;
+    };
+
+    // Never destroyed, detached helpers may still use it at exit.
+    read_pool& get_read_pool()
+    {
+        static read_pool* const pool = new read_pool;
+        return *pool;
+    }
+}
+
+/******** Free functions ********/
+procfs::bounded_result berry::detail::procfs::read_file_bounded(
+    std::shared_ptr<berry::unix_like::procfs_context const> const& context,
+    char const* path, std::vector<char>& buffer,
+    std::chrono::steady_clock::duration timeout)
+{
+    std::chrono::steady_clock::time_point const deadline =
+        std::chrono::steady_clock::now() + timeout;
+
+    // The buffer moves into the request to reuse its capacity, and only
+    // comes back if the read finished in time.
+    std::shared_ptr< ::read_request> const request =
+        std::make_shared< ::read_request>();
+    request->context = context;
+    std::snprintf(request->path, sizeof(request->path), "%s", path);
+    buffer.clear();
+    request->buffer.swap(buffer);
+    request->result = -1;
+    request->done = false;
+    request->abandoned = false;
+
+    ::read_pool& pool = ::get_read_pool();
+    switch(pool.submit(request))
+    {
+    case ::submit_saturated:
+        request->buffer.swap(buffer);
+        return procfs::bounded_read_timed_out;
+    case ::submit_no_threads:
+        request->buffer.swap(buffer);
+        return procfs::append_file(context->fd(), path, buffer) == -1 ?
+            procfs::bounded_read_failed : procfs::bounded_read_ok;
+    default:
+        break;
+    }
+
+    if(!pool.wait(request, deadline))
+        return procfs::bounded_read_timed_out;
+
+    request->buffer.swap(buffer);
+    return request->result == -1 ? procfs::bounded_read_failed :
+        procfs::bounded_read_ok;
+}
@@ -0,0 +1,311 @@
+/**
+ * @file linux/build_id.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief GNU build-id extraction for Linux.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <berry/detail/system.hpp>
+#ifndef BERRY_LINUX
+#   error "Attempt to compile source file on a wrong system"
+#endif
+
+// System:
+#include <elf.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+// C++ Standard Library:
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/module.hpp>
+#include <berry/build_id.hpp>
+#include <berry/detail/procfs.hpp>
+
+/******** Free helper functions ********/
+namespace
+{
+    // Note segments of regular binaries are a few hundred bytes, anything
+    // larger than this isn't scanned.
+    std::size_t const max_note_size = 64 * 1024;
+
+    bool read_exact(int fd, void* buffer, std::size_t size,
+        std::uint64_t offset)
+    {
+        char* out = static_cast<char*>(buffer);
+        while(size)
+        {
+            ::ssize_t const result = ::pread(fd, out, size, offset);
+            if(result == -1 && errno == EINTR)
+                continue;
+            if(result <= 0)
+                return false;
+            out += result;
+            size -= result;
+            offset += result;
+        }
+        return true;
+    }
+
+    std::size_t align_up(std::size_t value, std::size_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    // Scans a note segment for the GNU build-id note.
+    bool find_build_id(std::vector<char> const& notes, std::size_t alignment,
+        berry::build_id& out)
+    {
+        std::size_t pos = 0;
+        while(pos + sizeof(Elf32_Nhdr) <= notes.size())
+        {
+            // 32 and 64 bit ELF files share the same note header layout.
+            Elf32_Nhdr header;
+            std::memcpy(&header, &notes[pos], sizeof(header));
+            std::size_t const name_pos = pos + sizeof(header);
+            std::size_t const desc_pos = name_pos +
+                ::align_up(header.n_namesz, alignment);
+            std::size_t const next = desc_pos +
+                ::align_up(header.n_descsz, alignment);
+            if(desc_pos + header.n_descsz > notes.size() || next <= pos)
+                return false;
+
+            if(header.n_type == NT_GNU_BUILD_ID && header.n_namesz == 4 &&
+                std::memcmp(&notes[name_pos], "GNU", 4) == 0)
+            {
+                out.assign(notes.begin() + desc_pos,
+                    notes.begin() + desc_pos + header.n_descsz);
+                return true;
+            }
+            pos = next;
+        }
+        return false;
+    }
+
+    template<typename Ehdr, typename Phdr>
+    boost::optional<berry::build_id> read_notes(int fd, char const* header,
+        std::size_t header_size)
+    {
+        Ehdr ehdr;
+        if(header_size < sizeof(ehdr))
+            return boost::optional<berry::build_id>();
+        std::memcpy(&ehdr, header, sizeof(ehdr));
+        if(ehdr.e_phentsize != sizeof(Phdr) || ehdr.e_phnum == 0)
+            return boost::optional<berry::build_id>();
+
+        std::vector<Phdr> phdrs(ehdr.e_phnum);
+        if(!::read_exact(fd, phdrs.data(), phdrs.size() * sizeof(Phdr),
+            ehdr.e_phoff))
+        {
+            return boost::optional<berry::build_id>();
+        }
+
+        std::vector<char> notes;
+        berry::build_id result;
+        for(std::size_t i = 0; i < phdrs.size(); ++i)
+        {
+            Phdr const& phdr = phdrs[i];
+            if(phdr.p_type != PT_NOTE || phdr.p_filesz > ::max_note_size)
+                continue;
+
+            notes.resize(phdr.p_filesz);
+            if(!::read_exact(fd, notes.data(), notes.size(), phdr.p_offset))
+                continue;
+
+            std::size_t const alignment = phdr.p_align == 8 ? 8 : 4;
+            if(::find_build_id(notes, alignment, result))
+                return result;
+        }
+        return boost::optional<berry::build_id>();
+    }
+
+    // Looks up a module by its path outside of the process' root. Only a
+    // file with the device and inode of the mapping is the module, any
+    // other file of the same name would yield a foreign build-id.
+    boost::optional<berry::build_id> host_build_id(
+        berry::module const& mod, berry::build_id_cache& cache)
+    {
+        int const fd = ::open(mod.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if(fd == -1)
+            return boost::optional<berry::build_id>();
+
+        struct ::stat info;
+        boost::optional<berry::build_id> result;
+        if(::fstat(fd, &info) == 0 && info.st_dev == mod.device &&
+            info.st_ino == mod.inode)
+        {
+            result = cache.get(fd);
+        }
+        ::close(fd);
+        return result;
+    }
+
+    // Looks up a file of the process' ProcFS directory, through the
+    // directory the process holds so a reused pid isn't read.
+    boost::optional<berry::build_id> process_build_id(
+        berry::process const& proc, std::string const& file,
+        berry::build_id_cache& cache)
+    {
+        int const fd = berry::detail::procfs::open_process_file(
+            berry::unix_like::get_procfs_dirfd(proc), proc.pid(), file);
+        if(fd == -1)
+            return boost::optional<berry::build_id>();
+
+        boost::optional<berry::build_id> const result = cache.get(fd);
+        ::close(fd);
+        return result;
+    }
+
+    boost::optional<berry::build_id> read_build_id_from_fd(int fd)
+    {
+        // One read covers the ELF header of both classes.
+        char header[sizeof(Elf64_Ehdr)];
+        ::ssize_t result;
+        do
+            result = ::pread(fd, header, sizeof(header), 0);
+        while(result == -1 && errno == EINTR);
+        if(result < EI_NIDENT || std::memcmp(header, ELFMAG, SELFMAG) != 0)
+            return boost::optional<berry::build_id>();
+
+        std::size_t const size = static_cast<std::size_t>(result);
+        if(header[EI_CLASS] == ELFCLASS64)
+            return ::read_notes<Elf64_Ehdr, Elf64_Phdr>(fd, header, size);
+        if(header[EI_CLASS] == ELFCLASS32)
+            return ::read_notes<Elf32_Ehdr, Elf32_Phdr>(fd, header, size);
+        return boost::optional<berry::build_id>();
+    }
+}
+
+/******** Member functions ********/
+boost::optional<berry::build_id> berry::build_id_cache::get(
+    boost::filesystem::path const& path)
+{
+    int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd == -1)
+        return boost::optional<berry::build_id>();
+
+    boost::optional<berry::build_id> const result = get(fd);
+    ::close(fd);
+    return result;
+}
+
+boost::optional<berry::build_id> berry::build_id_cache::get(int fd)
+{
+    struct ::stat info;
+    if(::fstat(fd, &info) != 0)
+        return boost::optional<berry::build_id>();
+
+    key_type const key(info.st_dev, info.st_ino, info.st_mtim.tv_sec,
+        info.st_mtim.tv_nsec);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::map<key_type, boost::optional<berry::build_id> >::const_iterator
+            it = m_entries.find(key);
+        if(it != m_entries.end())
+            return it->second;
+    }
+
+    boost::optional<berry::build_id> const result =
+        ::read_build_id_from_fd(fd);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.insert(std::make_pair(key, result));
+    return result;
+}
+
+std::size_t berry::build_id_cache::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+void berry::build_id_cache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+}
+
+/******** Free functions ********/
+std::string berry::to_hex(berry::build_id const& id)
+{
+    static char const digits[] = "0123456789abcdef";
+    std::string result(id.size() * 2, '0');
+    for(std::size_t i = 0; i < id.size(); ++i)
+    {
+        result[2 * i] = digits[id[i] >> 4];
+        result[2 * i + 1] = digits[id[i] & 0xf];
+    }
+    return result;
+}
+
+boost::optional<berry::build_id> berry::read_build_id(
+    boost::filesystem::path const& path)
+{
+    int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd == -1)
+        return boost::optional<berry::build_id>();
+
+    boost::optional<berry::build_id> const result =
+        ::read_build_id_from_fd(fd);
+    ::close(fd);
+    return result;
+}
+
+berry::build_id_cache& berry::default_build_id_cache()
+{
+    static berry::build_id_cache cache;
+    return cache;
+}
+
+boost::optional<berry::build_id> berry::get_executable_build_id(
+    berry::process const& proc, berry::build_id_cache& cache)
+{
+    return ::process_build_id(proc, "exe", cache);
+}
+
+std::vector<std::pair<berry::module, boost::optional<berry::build_id> > >
+    berry::get_module_build_ids(berry::process const& proc,
+        berry::build_id_cache& cache)
+{
+    std::vector<berry::module> modules(berry::get_modules(proc));
+
+    std::vector<std::pair<berry::module, boost::optional<berry::build_id> > >
+        result;
+    for(std::size_t i = 0; i < modules.size(); ++i)
+    {
+        if(!modules[i].executable)
+            continue;
+
+        // Prefer the view of the process' root, so files inside of
+        // containers are found.
+        boost::optional<berry::build_id> id = ::process_build_id(proc,
+            "root" + modules[i].path, cache);
+        if(!id)
+            id = ::host_build_id(modules[i], cache);
+        result.push_back(std::make_pair(std::move(modules[i]), id));
+    }
+    return result;
+}
@@ -0,0 +1,273 @@
+/**
+ * @file linux/cgroup.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Control group enumeration for Linux.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <berry/detail/system.hpp>
+#ifndef BERRY_LINUX
+#   error "Attempt to compile source file on a wrong system"
+#endif
+
+// System:
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+
+// C++ Standard Library:
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/process_entry.hpp>
+#include <berry/cgroup.hpp>
+#include <berry/detail/procfs.hpp>
+
+namespace procfs = berry::detail::procfs;
+
+/******** Free helper functions ********/
+namespace
+{
+    // Null until set_cgroup_root is called. Swapped atomically, an
+    // operation loads the root once and keeps it until it's done.
+    std::shared_ptr<boost::filesystem::path const>& root_slot()
+    {
+        static std::shared_ptr<boost::filesystem::path const> slot;
+        return slot;
+    }
+
+    boost::filesystem::path detect_cgroup_root()
+    {
+        // Hybrid hosts mount the v2 hierarchy below the v1 controllers.
+        char const* const candidates[] = {
+            "/sys/fs/cgroup", "/sys/fs/cgroup/unified" };
+        for(std::size_t i = 0; i < 2; ++i)
+        {
+            std::string const procs = std::string(candidates[i]) +
+                "/cgroup.procs";
+            if(::access(procs.c_str(), F_OK) == 0)
+                return candidates[i];
+        }
+        return candidates[0];
+    }
+
+    std::string normalize(std::string const& cgroup)
+    {
+        std::string result(cgroup);
+        if(result.empty() || result[0] != '/')
+            result.insert(result.begin(), '/');
+        while(result.size() > 1 && result[result.size() - 1] == '/')
+            result.erase(result.size() - 1);
+        return result;
+    }
+
+    std::string directory_of(std::string const& root,
+        std::string const& cgroup)
+    {
+        return cgroup == "/" ? root : root + cgroup;
+    }
+
+    // Appends the cgroup and, if wanted, all of its descendants in
+    // pre-order. Cgroups removed during the walk are skipped.
+    bool collect_cgroups(std::string const& root, std::string const& cgroup,
+        bool recursive, std::vector<std::string>& out)
+    {
+        std::string const directory = ::directory_of(root, cgroup);
+        struct ::stat info;
+        if(::stat(directory.c_str(), &info) != 0 || !S_ISDIR(info.st_mode))
+            return false;
+
+        out.push_back(cgroup);
+        if(!recursive)
+            return true;
+
+        for(std::size_t next = out.size() - 1; next < out.size(); ++next)
+        {
+            std::string const parent = out[next];
+            ::DIR* dir = ::opendir(::directory_of(root, parent).c_str());
+            if(!dir)
+                continue;
+
+            while(::dirent* entry = ::readdir(dir))
+            {
+                char const* name = entry->d_name;
+                if(name[0] == '.' && (name[1] == '\0' ||
+                    (name[1] == '.' && name[2] == '\0')))
+                {
+                    continue;
+                }
+
+                std::string child = parent == "/" ? parent + name :
+                    parent + '/' + name;
+                if(entry->d_type == DT_UNKNOWN)
+                {
+                    if(::stat(::directory_of(root, child).c_str(),
+                        &info) != 0 || !S_ISDIR(info.st_mode))
+                    {
+                        continue;
+                    }
+                }
+                else if(entry->d_type != DT_DIR)
+                    continue;
+                out.push_back(std::move(child));
+            }
+            ::closedir(dir);
+        }
+        return true;
+    }
+
+    // Parses a cgroup.procs or cgroup.threads file, one id per line.
+    void read_ids(std::string const& root, std::string const& cgroup,
+        char const* file, std::vector<char>& buffer,
+        std::vector<berry::pid_type>& out)
+    {
+        std::string const path = ::directory_of(root, cgroup) + '/' + file;
+        if(!procfs::read_file(-1, path.c_str(), buffer))
+            return;
+
+        char const* it = buffer.data();
+        char const* const end = it + buffer.size();
+        while(it != end)
+        {
+            std::uint64_t value = 0;
+            char const* const next = procfs::parse_decimal(it, end, value);
+            if(next != it)
+                out.push_back(static_cast<berry::pid_type>(value));
+            it = next;
+            while(it != end && (*it < '0' || *it > '9'))
+                ++it;
+        }
+    }
+
+    std::vector<berry::pid_type> list_ids(std::string const& cgroup,
+        bool recursive, char const* file, char const* caller)
+    {
+        std::string const root = berry::get_cgroup_root().string();
+        std::vector<std::string> cgroups;
+        if(!::collect_cgroups(root, ::normalize(cgroup), recursive, cgroups))
+            throw std::runtime_error(std::string(caller) +
+                " : cgroup not found");
+
+        std::vector<char> buffer;
+        std::vector<berry::pid_type> result;
+        for(std::size_t i = 0; i < cgroups.size(); ++i)
+            ::read_ids(root, cgroups[i], file, buffer, result);
+        return result;
+    }
+
+    bool pid_less(std::pair<berry::pid_type, std::size_t> const& entry,
+        berry::pid_type pid)
+    {
+        return entry.first < pid;
+    }
+}
+
+/******** Constructors and Destructor ********/
+berry::cgroup_index::cgroup_index()
+    : cgroup_index("/")
+{ }
+
+berry::cgroup_index::cgroup_index(std::string const& cgroup)
+    : m_cgroups(), m_processes()
+{
+    std::string const root = berry::get_cgroup_root().string();
+    if(!::collect_cgroups(root, ::normalize(cgroup), true, m_cgroups))
+        throw std::runtime_error(   "berry::cgroup_index::cgroup_index : "
+                                    "cgroup not found");
+
+    std::vector<char> buffer;
+    std::vector<berry::pid_type> pids;
+    for(std::size_t i = 0; i < m_cgroups.size(); ++i)
+    {
+        pids.clear();
+        ::read_ids(root, m_cgroups[i], "cgroup.procs", buffer, pids);
+        for(std::size_t j = 0; j < pids.size(); ++j)
+            m_processes.push_back(std::make_pair(pids[j], i));
+    }
+    std::sort(m_processes.begin(), m_processes.end());
+}
+
+/******** Member functions ********/
+std::string const* berry::cgroup_index::find(berry::pid_type pid) const
+{
+    std::vector<std::pair<berry::pid_type, std::size_t> >::const_iterator
+        it = std::lower_bound(m_processes.begin(), m_processes.end(), pid,
+            &::pid_less);
+    if(it == m_processes.end() || it->first != pid)
+        return 0;
+    return &m_cgroups[it->second];
+}
+
+std::vector<std::string> const& berry::cgroup_index::cgroups() const
+{
+    return m_cgroups;
+}
+
+std::size_t berry::cgroup_index::size() const
+{
+    return m_processes.size();
+}
+
+/******** Free functions ********/
+void berry::set_cgroup_root(boost::filesystem::path const& root)
+{
+    std::shared_ptr<boost::filesystem::path const> value;
+    if(!root.empty())
+        value = std::make_shared<boost::filesystem::path const>(root);
+    std::atomic_store(&::root_slot(), std::move(value));
+}
+
+boost::filesystem::path berry::get_cgroup_root()
+{
+    std::shared_ptr<boost::filesystem::path const> const root =
+        std::atomic_load(&::root_slot());
+    if(root)
+        return *root;
+    static boost::filesystem::path const detected = ::detect_cgroup_root();
+    return detected;
+}
+
+std::vector<berry::pid_type> berry::get_cgroup_processes(
+    std::string const& cgroup, bool recursive)
+{
+    return ::list_ids(cgroup, recursive, "cgroup.procs",
+        "berry::get_cgroup_processes");
+}
+
+std::vector<berry::pid_type> berry::get_cgroup_threads(
+    std::string const& cgroup, bool recursive)
+{
+    return ::list_ids(cgroup, recursive, "cgroup.threads",
+        "berry::get_cgroup_threads");
+}
+
+berry::process_snapshot berry::create_cgroup_snapshot(
+    std::string const& cgroup, bool recursive, unsigned fields)
+{
+    return procfs::make_process_snapshot(::list_ids(cgroup, recursive,
+        "cgroup.procs", "berry::create_cgroup_snapshot"), fields);
+}
@@ -0,0 +1,393 @@
+/**
+ * @file linux/cmdline_search.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Command line search for Linux.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <berry/detail/system.hpp>
+#ifndef BERRY_LINUX
+#   error "Attempt to compile source file on a wrong system"
+#endif
+
+// System:
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+// C++ Standard Library:
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/process_strings.hpp>
+#include <berry/cmdline_search.hpp>
+#include <berry/detail/parallel.hpp>
+#include <berry/detail/procfs.hpp>
+
+namespace procfs = berry::detail::procfs;
+
+/******** Free helper functions ********/
+namespace
+{
+    void keep_longer(std::string& run, std::string& best)
+    {
+        if(run.size() > best.size())
+            best = run;
+        run.clear();
+    }
+
+    // Returns the index behind the bracket expression starting at begin, or
+    // begin if it isn't terminated.
+    std::size_t skip_class(std::string const& pattern, std::size_t begin)
+    {
+        std::size_t i = begin + 1;
+        if(i < pattern.size() && (pattern[i] == '^' || pattern[i] == '!'))
+            ++i;
+        if(i < pattern.size() && pattern[i] == ']')
+            ++i;
+        for(; i < pattern.size(); ++i)
+        {
+            if(pattern[i] == '\\')
+                ++i;
+            else if(pattern[i] == ']')
+                return i + 1;
+        }
+        return begin;
+    }
+
+    // Finds a literal every match of the regular expression contains. Only
+    // the top level sequence is looked at, groups and alternations are
+    // skipped, which may miss literals but never invents one.
+    std::string regex_literal(std::string const& pattern)
+    {
+        std::string best, run;
+        int depth = 0;
+        for(std::size_t i = 0; i < pattern.size(); ++i)
+        {
+            char const c = pattern[i];
+            if(c == '\\')
+            {
+                ++i;
+                continue;
+            }
+            if(c == '[')
+            {
+                std::size_t const end = ::skip_class(pattern, i);
+                if(end != i)
+                    i = end - 1;
+                continue;
+            }
+            if(c == '(')
+                ++depth;
+            else if(c == ')')
+                --depth;
+            else if(c == '|' && depth == 0)
+                return std::string();
+        }
+
+        for(std::size_t i = 0; i < pattern.size(); ++i)
+        {
+            char const c = pattern[i];
+            switch(c)
+            {
+            case '\\':
+                if(i + 1 < pattern.size() &&
+                    std::ispunct(static_cast<unsigned char>(pattern[i + 1])))
+                {
+                    run += pattern[++i];
+                }
+                else
+                {
+                    ++i;
+                    ::keep_longer(run, best);
+                }
+                break;
+
+            case '[':
+            {
+                std::size_t const end = ::skip_class(pattern, i);
+                i = end == i ? pattern.size() : end - 1;
+                ::keep_longer(run, best);
+                break;
+            }
+
+            case '(':
+                for(int nesting = 0; i < pattern.size(); ++i)
+                {
+                    if(pattern[i] == '\\')
+                        ++i;
+                    else if(pattern[i] == '[')
+                        i = std::max(i, ::skip_class(pattern, i) - 1);
+                    else if(pattern[i] == '(')
+                        ++nesting;
+                    else if(pattern[i] == ')' && --nesting == 0)
+                        break;
+                }
+                ::keep_longer(run, best);
+                break;
+
+            // The previous character is optional.
+            case '?':
+            case '*':
+            case '{':
+                if(!run.empty())
+                    run.erase(run.size() - 1);
+                ::keep_longer(run, best);
+                if(c == '{')
+                {
+                    while(i < pattern.size() && pattern[i] != '}')
+                        ++i;
+                }
+                break;
+
+            case '+':
+            case '.':
+            case '^':
+            case '$':
+            case ')':
+                ::keep_longer(run, best);
+                break;
+
+            default:
+                run += c;
+                break;
+            }
+        }
+        ::keep_longer(run, best);
+        return best;
+    }
+
+    std::string glob_literal(std::string const& pattern)
+    {
+        std::string best, run;
+        for(std::size_t i = 0; i < pattern.size(); ++i)
+        {
+            char const c = pattern[i];
+            if(c == '\\' && i + 1 < pattern.size())
+                run += pattern[++i];
+            else if(c == '*' || c == '?')
+                ::keep_longer(run, best);
+            else if(c == '[' && ::skip_class(pattern, i) != i)
+            {
+                i = ::skip_class(pattern, i) - 1;
+                ::keep_longer(run, best);
+            }
+            else
+                run += c;
+        }
+        ::keep_longer(run, best);
+        return best;
+    }
+
+    // Matches one character against the bracket expression at p. Returns
+    // the position behind it, or null if the character doesn't match.
+    char const* match_class(char const* p, char const* end, char c)
+    {
+        char const* it = p + 1;
+        bool const negate = it != end && (*it == '!' || *it == '^');
+        if(negate)
+            ++it;
+
+        bool matched = false;
+        bool first = true;
+        for(; it != end && (first || *it != ']'); first = false)
+        {
+            char low = *it++;
+            if(low == '\\' && it != end)
+                low = *it++;
+            char high = low;
+            if(it + 1 < end && *it == '-' && it[1] != ']')
+            {
+                high = it[1];
+                it += 2;
+            }
+            if(c >= low && c <= high)
+                matched = true;
+        }
+        if(it == end)
+            return 0;
+        return matched != negate ? it + 1 : 0;
+    }
+
+    bool glob_match(char const* p, char const* p_end, char const* s,
+        char const* s_end)
+    {
+        char const* star = 0;
+        char const* star_s = 0;
+        while(s != s_end)
+        {
+            if(p != p_end)
+            {
+                if(*p == '*')
+                {
+                    star = ++p;
+                    star_s = s;
+                    continue;
+                }
+                if(*p == '?')
+                {
+                    ++p;
+                    ++s;
+                    continue;
+                }
+
+                char const* next = 0;
+                if(*p == '[' && std::find(p + 1, p_end, ']') != p_end)
+                    next = ::match_class(p, p_end, *s);
+                else
+                {
+                    char const* literal = p;
+                    if(*p == '\\' && p + 1 != p_end)
+                        ++literal;
+                    if(*literal == *s)
+                        next = literal + 1;
+                }
+                if(next)
+                {
+                    p = next;
+                    ++s;
+                    continue;
+                }
+            }
+
+            // Let the last star swallow one more character.
+            if(!star)
+                return false;
+            p = star;
+            s = ++star_s;
+        }
+
+        while(p != p_end && *p == '*')
+            ++p;
+        return p == p_end;
+    }
+}
+
+/******** Constructors and Destructor ********/
+berry::cmdline_pattern::cmdline_pattern(std::string const& pattern,
+    berry::pattern_syntax syntax)
+    : m_syntax(syntax), m_pattern(pattern), m_regex(), m_literal()
+{
+    if(syntax == berry::pattern_regex)
+    {
+        m_regex = std::make_shared<std::regex const>(pattern,
+            std::regex::ECMAScript | std::regex::optimize);
+        m_literal = ::regex_literal(pattern);
+    }
+    else
+        m_literal = ::glob_literal(pattern);
+}
+
+/******** Member functions ********/
+bool berry::cmdline_pattern::matches(char const* begin, char const* end) const
+{
+    if(!m_literal.empty() && !::memmem(begin, end - begin, m_literal.data(),
+        m_literal.size()))
+    {
+        return false;
+    }
+
+    if(m_syntax == berry::pattern_regex)
+        return std::regex_search(begin, end, *m_regex);
+    return ::glob_match(m_pattern.data(), m_pattern.data() + m_pattern.size(),
+        begin, end);
+}
+
+std::string const& berry::cmdline_pattern::literal() const
+{
+    return m_literal;
+}
+
+/******** Free functions ********/
+berry::cmdline_column berry::search_cmdlines(
+    berry::cmdline_pattern const& pattern, unsigned workers)
+{
+    std::shared_ptr<berry::unix_like::procfs_context const> const context =
+        procfs::context("berry::search_cmdlines");
+    std::vector<berry::pid_type> pids;
+    if(!context->list_processes(pids))
+        throw std::runtime_error(   "berry::search_cmdlines : "
+                                    "procfs not correctly mounted");
+    int const basefd = context->fd();
+
+    // Every worker reads into its own arena and collects its own matches.
+    struct worker_state
+    {
+        worker_state()
+            : raw(), joined(), matches(std::vector<berry::pid_type>())
+        { }
+
+        std::vector<char> raw;
+        std::vector<char> joined;
+        berry::cmdline_column matches;
+    };
+
+    workers = berry::detail::worker_count(workers, pids.size());
+    std::vector<worker_state> states(workers);
+    berry::detail::parallel_for(pids.size(), workers,
+        [&](unsigned worker, std::size_t i)
+        {
+            worker_state& state = states[worker];
+            char path[64];
+            std::snprintf(path, sizeof(path), "%d/cmdline", pids[i]);
+            state.raw.clear();
+            if(procfs::append_file(basefd, path, state.raw) <= 0)
+                return;
+
+            state.joined.assign(state.raw.begin(), state.raw.end());
+            while(!state.joined.empty() && state.joined.back() == '\0')
+                state.joined.pop_back();
+            std::replace(state.joined.begin(), state.joined.end(),
+                '\0', ' ');
+
+            char const* joined = state.joined.data();
+            if(pattern.matches(joined, joined + state.joined.size()))
+            {
+                char const* raw = state.raw.data();
+                state.matches.append(pids[i], berry::string_range(raw,
+                    raw + state.raw.size()));
+            }
+        });
+
+    // Merge the workers' matches in pid order.
+    std::vector<std::tuple<berry::pid_type, unsigned, std::size_t> > rows;
+    for(unsigned i = 0; i < workers; ++i)
+    {
+        for(std::size_t j = 0; j < states[i].matches.size(); ++j)
+            rows.push_back(std::make_tuple(states[i].matches.pid(j), i, j));
+    }
+    std::sort(rows.begin(), rows.end());
+
+    berry::cmdline_column result((std::vector<berry::pid_type>()));
+    for(std::size_t i = 0; i < rows.size(); ++i)
+    {
+        worker_state const& state = states[std::get<1>(rows[i])];
+        result.append(std::get<0>(rows[i]),
+            state.matches.cmdline(std::get<2>(rows[i])));
+    }
+    return result;
+}
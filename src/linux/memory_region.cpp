@@ -0,0 +1,118 @@
+/**
+ * @file linux/memory_region.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Memory region API for Linux.
+ * 
+ * This file is part of Berry.
+ * 
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <berry/detail/system.hpp>
+#ifndef BERRY_LINUX
+#   error "Attempt to compile source file on a wrong system"
+#endif
+
+// C++ Standard Library:
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/memory_region.hpp>
+#include <berry/detail/procfs.hpp>
+
+namespace procfs = berry::detail::procfs;
+
+/******** Free helper functions ********/
+static std::vector<berry::memory_region> parse_regions(
+    std::vector<char> const& buffer)
+{
+    std::vector<berry::memory_region> result;
+    char const* it = buffer.data();
+    char const* const end = it + buffer.size();
+    while(it != end)
+    {
+        char const* line_end = static_cast<char const*>(
+            std::memchr(it, '\n', end - it));
+        if(!line_end)
+            line_end = end;
+
+        procfs::maps_line line;
+        if(procfs::parse_maps_line(it, line_end, line))
+        {
+            berry::memory_region region;
+            region.begin = line.begin;
+            region.end = line.end;
+            region.protection = berry::memory_protection(line.permissions);
+            region.offset = line.offset;
+            region.device = line.device;
+            region.inode = line.inode;
+            region.path.assign(line.path, line.path_size);
+            result.push_back(std::move(region));
+        }
+
+        it = line_end == end ? end : line_end + 1;
+    }
+    return result;
+}
+
+/******** Free functions ********/
+std::vector<berry::memory_region> berry::get_memory_regions(
+    berry::process const& proc)
+{
+    assert(proc != berry::not_a_process);
+
+    std::vector<char> buffer;
+    int const dirfd = berry::unix_like::get_procfs_dirfd(proc);
+    bool const read = dirfd != -1 ? procfs::read_file(dirfd, "maps", buffer) :
+        procfs::read_file(procfs::context("berry::get_memory_regions")->fd(),
+            (std::to_string(proc.pid()) + "/maps").c_str(), buffer);
+    if(!read)
+    {
+        throw std::runtime_error(
+            "berry::get_memory_regions : maps not readable");
+    }
+    return ::parse_regions(buffer);
+}
+
+std::vector<berry::memory_region> berry::get_memory_regions(
+    berry::process const& proc, std::chrono::milliseconds read_timeout)
+{
+    assert(proc != berry::not_a_process);
+
+    // The helper may outlive the process object, so the file is opened
+    // through the context rather than the process' directory.
+    std::vector<char> buffer;
+    switch(procfs::read_file_bounded(
+        procfs::context("berry::get_memory_regions"),
+        (std::to_string(proc.pid()) + "/maps").c_str(), buffer,
+        read_timeout))
+    {
+    case procfs::bounded_read_failed:
+        throw std::runtime_error(
+            "berry::get_memory_regions : maps not readable");
+    case procfs::bounded_read_timed_out:
+        throw std::system_error(std::make_error_code(std::errc::timed_out),
+            "berry::get_memory_regions : reading maps timed out");
+    default:
+        return ::parse_regions(buffer);
+    }
+}
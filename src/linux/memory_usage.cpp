@@ -0,0 +1,227 @@
+/**
+ * @file linux/memory_usage.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Memory accounting from smaps_rollup for Linux.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <berry/detail/system.hpp>
+#ifndef BERRY_LINUX
+#   error "Attempt to compile source file on a wrong system"
+#endif
+
+// C++ Standard Library:
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+// Boost Library:
+#include <boost/optional.hpp>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/memory_usage.hpp>
+#include <berry/procfs_context.hpp>
+#include <berry/detail/parallel.hpp>
+#include <berry/detail/procfs.hpp>
+
+namespace procfs = berry::detail::procfs;
+
+/******** Free helper functions ********/
+namespace
+{
+    struct usage_key
+    {
+        char const* name;
+        std::size_t size;
+        std::uint64_t berry::memory_usage::* field;
+    };
+
+#define BERRY_USAGE_KEY(name, field) \
+    { name, sizeof(name) - 1, &berry::memory_usage::field }
+
+    // Keys mapping to the same field are summed up, so are the regions of
+    // a smaps file.
+    usage_key const keys[] = {
+        BERRY_USAGE_KEY("Rss", rss),
+        BERRY_USAGE_KEY("Pss", pss),
+        BERRY_USAGE_KEY("Pss_Anon", pss_anon),
+        BERRY_USAGE_KEY("Pss_File", pss_file),
+        BERRY_USAGE_KEY("Pss_Shmem", pss_shmem),
+        BERRY_USAGE_KEY("Shared_Clean", shared),
+        BERRY_USAGE_KEY("Shared_Dirty", shared),
+        BERRY_USAGE_KEY("Private_Clean", uss),
+        BERRY_USAGE_KEY("Private_Dirty", uss),
+        BERRY_USAGE_KEY("Anonymous", anonymous),
+        BERRY_USAGE_KEY("Swap", swap),
+        BERRY_USAGE_KEY("SwapPss", swap_pss)
+    };
+
+#undef BERRY_USAGE_KEY
+
+    // Parses "Key:   123 kB" lines, everything else (the region headers of
+    // smaps, VmFlags, unknown keys) is skipped.
+    void parse_usage(char const* it, char const* const end,
+        berry::memory_usage& usage)
+    {
+        while(it != end)
+        {
+            char const* line_end = static_cast<char const*>(
+                std::memchr(it, '\n', end - it));
+            if(!line_end)
+                line_end = end;
+
+            char const* const colon = static_cast<char const*>(
+                std::memchr(it, ':', line_end - it));
+            if(colon)
+            {
+                std::size_t const size = colon - it;
+                for(std::size_t i = 0; i < sizeof(keys) / sizeof(*keys); ++i)
+                {
+                    usage_key const& key = keys[i];
+                    if(key.size != size || std::memcmp(key.name, it, size))
+                        continue;
+
+                    std::uint64_t kilobytes = 0;
+                    procfs::parse_decimal(procfs::skip_blanks(colon + 1,
+                        line_end), line_end, kilobytes);
+                    usage.*key.field += kilobytes * 1024;
+                    break;
+                }
+            }
+            it = line_end == end ? end : line_end + 1;
+        }
+    }
+
+    // Returns false for processes without memory and unreadable files.
+    bool read_usage(int root, berry::pid_type pid, std::vector<char>& buffer,
+        berry::memory_usage& usage)
+    {
+        char path[64];
+        std::snprintf(path, sizeof(path), "%d/smaps_rollup", pid);
+        if(!procfs::read_file(root, path, buffer))
+        {
+            std::snprintf(path, sizeof(path), "%d/smaps", pid);
+            if(!procfs::read_file(root, path, buffer))
+                return false;
+        }
+        if(buffer.empty())
+            return false;
+
+        usage = berry::memory_usage();
+        usage.pid = pid;
+        ::parse_usage(buffer.data(), buffer.data() + buffer.size(), usage);
+        return true;
+    }
+
+    bool pid_less(berry::memory_usage const& usage, berry::pid_type pid)
+    {
+        return usage.pid < pid;
+    }
+}
+
+/******** Constructors ********/
+berry::memory_usage::memory_usage()
+    : pid(0), rss(0), pss(0), pss_anon(0), pss_file(0), pss_shmem(0),
+      uss(0), shared(0), anonymous(0), swap(0), swap_pss(0)
+{ }
+
+/******** Member operator overloads ********/
+berry::memory_usage& berry::memory_usage::operator+=(
+    berry::memory_usage const& other)
+{
+    rss += other.rss;
+    pss += other.pss;
+    pss_anon += other.pss_anon;
+    pss_file += other.pss_file;
+    pss_shmem += other.pss_shmem;
+    uss += other.uss;
+    shared += other.shared;
+    anonymous += other.anonymous;
+    swap += other.swap;
+    swap_pss += other.swap_pss;
+    return *this;
+}
+
+/******** Free functions ********/
+boost::optional<berry::memory_usage> berry::get_memory_usage(
+    berry::pid_type pid)
+{
+    std::vector<char> buffer;
+    berry::memory_usage usage;
+    if(!::read_usage(procfs::context("berry::get_memory_usage")->fd(), pid,
+        buffer, usage))
+        return boost::optional<berry::memory_usage>();
+    return usage;
+}
+
+std::vector<berry::memory_usage> berry::get_all_memory_usage(
+    unsigned workers)
+{
+    std::shared_ptr<berry::unix_like::procfs_context const> const context =
+        procfs::context("berry::get_all_memory_usage");
+    int const root = context->fd();
+    std::vector<berry::pid_type> pids;
+    if(!context->list_processes(pids))
+        throw std::runtime_error(   "berry::get_all_memory_usage : "
+                                    "procfs not correctly mounted");
+
+    // Every worker collects into its own vector with its own buffer.
+    workers = berry::detail::worker_count(workers, pids.size());
+    std::vector<std::vector<berry::memory_usage> > results(workers);
+    std::vector<std::vector<char> > buffers(workers);
+
+    berry::detail::parallel_for(pids.size(), workers,
+        [&](unsigned worker, std::size_t i)
+        {
+            berry::memory_usage usage;
+            if(::read_usage(root, pids[i], buffers[worker], usage))
+                results[worker].push_back(usage);
+        });
+
+    std::vector<berry::memory_usage> result;
+    for(std::size_t i = 0; i < results.size(); ++i)
+        result.insert(result.end(), results[i].begin(), results[i].end());
+    std::sort(result.begin(), result.end(),
+        [](berry::memory_usage const& a, berry::memory_usage const& b)
+        {
+            return a.pid < b.pid;
+        });
+    return result;
+}
+
+berry::memory_usage berry::sum_memory_usage(
+    std::vector<berry::memory_usage> const& usages,
+    std::vector<berry::pid_type> const& pids)
+{
+    berry::memory_usage sum;
+    for(std::size_t i = 0; i < pids.size(); ++i)
+    {
+        std::vector<berry::memory_usage>::const_iterator const it =
+            std::lower_bound(usages.begin(), usages.end(), pids[i],
+                &::pid_less);
+        if(it != usages.end() && it->pid == pids[i])
+            sum += *it;
+    }
+    return sum;
+}
@@ -0,0 +1,256 @@
+/**
+ * @file linux/open_files.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Open file descriptor enumeration for Linux.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <berry/detail/system.hpp>
+#ifndef BERRY_LINUX
+#   error "Attempt to compile source file on a wrong system"
+#endif
+
+// System:
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+// C++ Standard Library:
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/open_files.hpp>
+#include <berry/procfs_context.hpp>
+#include <berry/detail/parallel.hpp>
+#include <berry/detail/procfs.hpp>
+#include <berry/detail/instrumentation.hpp>
+
+namespace procfs = berry::detail::procfs;
+
+/******** Free helper functions ********/
+namespace
+{
+    // Calls fn(name, fd) for every descriptor of /proc/<pid>/fd. Reads the
+    // directory with getdents64 straight into a stack buffer, a process
+    // with a few hundred descriptors takes a single call.
+    template<typename Function>
+    bool for_each_fd(int root, berry::pid_type pid, Function fn)
+    {
+        char path[64];
+        std::snprintf(path, sizeof(path), "%d/fd", pid);
+        int const dirfd = ::openat(root, path,
+            O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        BERRY_COUNT_OPEN();
+        if(dirfd == -1)
+            return false;
+
+        std::uint64_t buffer[1024];
+        for(;;)
+        {
+            BERRY_COUNT_SYSCALLS(1);
+            long const size = ::syscall(SYS_getdents64, dirfd, buffer,
+                sizeof(buffer));
+            if(size == -1 && errno == EINTR)
+                continue;
+            if(size <= 0)
+                break;
+
+            char const* const begin = reinterpret_cast<char const*>(buffer);
+            for(long offset = 0; offset < size; )
+            {
+                ::dirent64 const* const entry =
+                    reinterpret_cast< ::dirent64 const*>(begin + offset);
+                offset += entry->d_reclen;
+
+                char const* name = entry->d_name;
+                if(*name < '0' || *name > '9')
+                    continue;
+                int fd = 0;
+                for(; *name >= '0' && *name <= '9'; ++name)
+                    fd = fd * 10 + (*name - '0');
+                if(*name == '\0')
+                    fn(dirfd, entry->d_name, fd);
+            }
+        }
+
+        ::close(dirfd);
+        BERRY_COUNT_SYSCALLS(1);
+        return true;
+    }
+
+    // Sockets all live on the device of sockfs, which only shows in a
+    // stat of a socket.
+    std::uint64_t socket_device()
+    {
+        int const fd = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if(fd == -1)
+            return 0;
+        struct ::stat info;
+        std::uint64_t const result = ::fstat(fd, &info) == 0 ?
+            info.st_dev : 0;
+        ::close(fd);
+        return result;
+    }
+}
+
+/******** Constructors ********/
+berry::open_file::open_file()
+    : fd(-1), device(0), inode(0), target()
+{ }
+
+berry::open_file_index::open_file_index(unsigned workers)
+    : m_records(), m_socket_device(::socket_device())
+{
+    std::shared_ptr<berry::unix_like::procfs_context const> const context =
+        procfs::context("berry::open_file_index::open_file_index");
+    int const root = context->fd();
+    std::vector<berry::pid_type> pids;
+    if(!context->list_processes(pids))
+        throw std::runtime_error(   "berry::open_file_index::open_file_index"
+                                    " : procfs not correctly mounted");
+
+    // A stat through the fd link yields device and inode of every kind of
+    // descriptor with one call, the link target isn't needed.
+    workers = berry::detail::worker_count(workers, pids.size());
+    std::vector<std::vector<record> > results(workers);
+    berry::detail::parallel_for(pids.size(), workers,
+        [&](unsigned worker, std::size_t i)
+        {
+            berry::pid_type const pid = pids[i];
+            std::vector<record>& out = results[worker];
+            ::for_each_fd(root, pid,
+                [&](int dirfd, char const* name, int fd)
+                {
+                    struct ::stat info;
+                    BERRY_COUNT_SYSCALLS(1);
+                    if(::fstatat(dirfd, name, &info, 0) != 0)
+                        return;
+                    record current;
+                    current.device = info.st_dev;
+                    current.inode = info.st_ino;
+                    current.holder.pid = pid;
+                    current.holder.fd = fd;
+                    out.push_back(current);
+                });
+        });
+
+    std::size_t total = 0;
+    for(std::size_t i = 0; i < results.size(); ++i)
+        total += results[i].size();
+    m_records.reserve(total);
+    for(std::size_t i = 0; i < results.size(); ++i)
+        m_records.insert(m_records.end(), results[i].begin(),
+            results[i].end());
+    std::sort(m_records.begin(), m_records.end(),
+        &berry::open_file_index::record_less);
+}
+
+/******** Member functions ********/
+bool berry::open_file_index::record_less(record const& lhs,
+    record const& rhs)
+{
+    if(lhs.device != rhs.device)
+        return lhs.device < rhs.device;
+    if(lhs.inode != rhs.inode)
+        return lhs.inode < rhs.inode;
+    if(lhs.holder.pid != rhs.holder.pid)
+        return lhs.holder.pid < rhs.holder.pid;
+    return lhs.holder.fd < rhs.holder.fd;
+}
+
+std::vector<berry::file_holder> berry::open_file_index::find(
+    std::uint64_t device, std::uint64_t inode) const
+{
+    record key;
+    key.device = device;
+    key.inode = inode;
+    key.holder.pid = 0;
+    key.holder.fd = -1;
+
+    std::vector<berry::file_holder> result;
+    std::vector<record>::const_iterator it = std::lower_bound(
+        m_records.begin(), m_records.end(), key,
+        &berry::open_file_index::record_less);
+    for(; it != m_records.end() && it->device == device &&
+        it->inode == inode; ++it)
+    {
+        result.push_back(it->holder);
+    }
+    return result;
+}
+
+std::vector<berry::file_holder> berry::open_file_index::find_socket(
+    std::uint64_t inode) const
+{
+    return find(m_socket_device, inode);
+}
+
+std::size_t berry::open_file_index::size() const
+{
+    return m_records.size();
+}
+
+/******** Free functions ********/
+std::vector<berry::open_file> berry::get_open_files(berry::pid_type pid)
+{
+    std::vector<berry::open_file> result;
+    std::shared_ptr<berry::unix_like::procfs_context const> const context =
+        procfs::context("berry::get_open_files");
+    ::for_each_fd(context->fd(), pid,
+        [&](int dirfd, char const* name, int fd)
+        {
+            berry::open_file file;
+            file.fd = fd;
+
+            char target[4096];
+            BERRY_COUNT_SYSCALLS(1);
+            ::ssize_t const size = ::readlinkat(dirfd, name, target,
+                sizeof(target));
+            if(size > 0)
+                file.target.assign(target, size);
+
+            struct ::stat info;
+            BERRY_COUNT_SYSCALLS(1);
+            if(::fstatat(dirfd, name, &info, 0) == 0)
+            {
+                file.device = info.st_dev;
+                file.inode = info.st_ino;
+            }
+            result.push_back(std::move(file));
+        });
+
+    std::sort(result.begin(), result.end(),
+        [](berry::open_file const& a, berry::open_file const& b)
+        {
+            return a.fd < b.fd;
+        });
+    return result;
+}
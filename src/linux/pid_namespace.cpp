@@ -0,0 +1,137 @@
+/**
+ * @file linux/pid_namespace.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Pid namespace translation for Linux.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <berry/detail/system.hpp>
+#ifndef BERRY_LINUX
+#   error "Attempt to compile source file on a wrong system"
+#endif
+
+// C++ Standard Library:
+#include <algorithm>
+#include <vector>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/process_entry.hpp>
+#include <berry/pid_namespace.hpp>
+#include <berry/detail/snapshot_util.hpp>
+
+/******** Free helper functions ********/
+namespace
+{
+    bool namespace_less(berry::namespaced_pid const& lhs,
+        berry::namespaced_pid const& rhs)
+    {
+        if(lhs.pid_namespace != rhs.pid_namespace)
+            return lhs.pid_namespace < rhs.pid_namespace;
+        return lhs.local_pid < rhs.local_pid;
+    }
+
+    bool pid_less(berry::namespaced_pid const& lhs,
+        berry::namespaced_pid const& rhs)
+    {
+        return lhs.pid < rhs.pid;
+    }
+}
+
+/******** Constructors and Destructor ********/
+berry::pid_namespace_index::pid_namespace_index()
+    : pid_namespace_index(berry::detail::snapshot_util::drain_new(
+        berry::snapshot_namespaces))
+{ }
+
+berry::pid_namespace_index::pid_namespace_index(
+    std::vector<berry::process_entry> const& entries)
+    : m_by_namespace(), m_by_pid()
+{
+    for(std::size_t i = 0; i < entries.size(); ++i)
+    {
+        berry::process_entry const& entry = entries[i];
+        if(entry.pid_namespace == 0)
+            continue;
+
+        // NSpid lists the innermost namespace last.
+        berry::namespaced_pid record;
+        record.pid_namespace = entry.pid_namespace;
+        record.local_pid = entry.namespace_pids.empty() ? entry.pid :
+            entry.namespace_pids.back();
+        record.pid = entry.pid;
+        m_by_namespace.push_back(record);
+    }
+
+    m_by_pid = m_by_namespace;
+    std::sort(m_by_namespace.begin(), m_by_namespace.end(),
+        &::namespace_less);
+    std::sort(m_by_pid.begin(), m_by_pid.end(), &::pid_less);
+}
+
+/******** Member functions ********/
+berry::namespaced_pid const* berry::pid_namespace_index::find(
+    berry::pid_type pid) const
+{
+    berry::namespaced_pid key = { 0, 0, pid };
+    std::vector<berry::namespaced_pid>::const_iterator it =
+        std::lower_bound(m_by_pid.begin(), m_by_pid.end(), key, &::pid_less);
+    if(it == m_by_pid.end() || it->pid != pid)
+        return 0;
+    return &*it;
+}
+
+boost::optional<berry::pid_type> berry::pid_namespace_index::translate(
+    std::uint64_t pid_namespace, berry::pid_type local_pid) const
+{
+    berry::namespaced_pid key = { pid_namespace, local_pid, 0 };
+    std::vector<berry::namespaced_pid>::const_iterator it =
+        std::lower_bound(m_by_namespace.begin(), m_by_namespace.end(), key,
+            &::namespace_less);
+    if(it == m_by_namespace.end() || it->pid_namespace != pid_namespace ||
+        it->local_pid != local_pid)
+    {
+        return boost::optional<berry::pid_type>();
+    }
+    return it->pid;
+}
+
+std::vector<std::uint64_t> berry::pid_namespace_index::namespaces() const
+{
+    std::vector<std::uint64_t> result;
+    for(std::size_t i = 0; i < m_by_namespace.size(); ++i)
+    {
+        if(result.empty() || result.back() != m_by_namespace[i].pid_namespace)
+            result.push_back(m_by_namespace[i].pid_namespace);
+    }
+    return result;
+}
+
+std::vector<berry::namespaced_pid> berry::pid_namespace_index::members(
+    std::uint64_t pid_namespace) const
+{
+    berry::namespaced_pid const key = { pid_namespace, 0, 0 };
+    std::vector<berry::namespaced_pid>::const_iterator it =
+        std::lower_bound(m_by_namespace.begin(), m_by_namespace.end(), key,
+            &::namespace_less);
+    std::vector<berry::namespaced_pid>::const_iterator end = it;
+    while(end != m_by_namespace.end() && end->pid_namespace == pid_namespace)
+        ++end;
+    return std::vector<berry::namespaced_pid>(it, end);
+}
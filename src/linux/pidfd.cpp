@@ -0,0 +1,71 @@
+/**
+ * @file linux/pidfd.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Non-public wrappers around Linux process file descriptors.
+ * 
+ * This file is part of Berry.
+ * 
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <berry/detail/system.hpp>
+#ifndef BERRY_LINUX
+#   error "Attempt to compile source file on a wrong system"
+#endif
+
+// System:
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+// Berry:
+#include <berry/detail/pidfd.hpp>
+
+// The C library may predate pidfds, the numbers are the same on all
+// architectures supported by Berry.
+#ifndef SYS_pidfd_open
+#   define SYS_pidfd_open 434
+#endif
+#ifndef SYS_pidfd_send_signal
+#   define SYS_pidfd_send_signal 424
+#endif
+
+/******** Free functions ********/
+int berry::detail::pidfd::open(berry::detail::process::pid_type pid)
+{
+    // pidfds are always close-on-exec.
+    return static_cast<int>(::syscall(SYS_pidfd_open, pid, 0));
+}
+
+int berry::detail::pidfd::send_signal(int fd, int sig)
+{
+    return static_cast<int>(::syscall(SYS_pidfd_send_signal, fd, sig, 0, 0));
+}
+
+int berry::detail::pidfd::duplicate(int fd)
+{
+    return fd == -1 ? -1 : ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+}
+
+void berry::detail::pidfd::close(int& fd)
+{
+    if(fd != -1)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+}
@@ -29,35 +29,108 @@
 // System:
 #include <elf.h>
 #include <sys/types.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <signal.h>
 #include <unistd.h>
+#include <errno.h>
 
 // C++ Standard Library:
 #include <cassert>
+#include <cstdio>
+#include <cstring>
 #include <string>
 #include <stdexcept>
 #include <array>
+#include <memory>
 #include <system_error>
 
 // Boost:
 #include <boost/filesystem/path.hpp>
-#include <boost/filesystem/fstream.hpp>
-#include <boost/filesystem/operations.hpp>
 
 // Berry:
 #include <berry/process.hpp>
 #include <berry/detail/process_detail.hpp>
+#include <berry/detail/pidfd.hpp>
+#include <berry/detail/procfs.hpp>
+#include <berry/detail/instrumentation.hpp>
 #include <berry/process_entry.hpp>
+#include <berry/procfs_context.hpp>
 
 #define ASSERT_PROCESS() assert(*this != berry::not_a_process)
 
+namespace pidfd = berry::detail::pidfd;
+
 /******** Free helper functions ********/
+// Path of a process' file relative to the ProcFS root.
+static std::string make_procfs_path(berry::pid_type pid, char const* file)
+{
+    char path[256];
+    std::snprintf(path, sizeof(path), "%d%s%s", pid, *file ? "/" : "",
+        file);
+    return path;
+}
+
+static berry::detail::process::process_data open_process(berry::pid_type pid)
+{
+    berry::detail::process::process_data data(pid);
+    if(pid <= 0)
+        return data;
+    
+    // Open the pidfd first. If the process is still alive after its
+    // directory was opened, the pid can't have been reused in between.
+    data.pidfd = pidfd::open(pid);
+    BERRY_COUNT_SYSCALLS(1);
+    std::shared_ptr<berry::unix_like::procfs_context const> const context =
+        berry::unix_like::get_default_procfs_context();
+    if(context)
+    {
+        data.dirfd = context->open_directory(pid);
+        BERRY_COUNT_OPEN();
+    }
+    if(data.pidfd != -1 && data.dirfd != -1)
+    {
+        BERRY_COUNT_SYSCALLS(1);
+        if(pidfd::send_signal(data.pidfd, 0) == -1 && errno == ESRCH)
+            pidfd::close(data.dirfd);
+    }
+    return data;
+}
+
+static berry::detail::process::process_data copy_process(
+    berry::detail::process::process_data const& other)
+{
+    return berry::detail::process::process_data(other.pid,
+        pidfd::duplicate(other.pidfd), pidfd::duplicate(other.dirfd));
+}
+
+// Opens a file inside of the process' ProcFS directory. Without a directory
+// descriptor (e.g. the process didn't exist when the object was created)
+// the file is opened relative to the default ProcFS root.
+static int open_procfs_file(berry::detail::process::process_data const& data,
+    char const* file)
+{
+    BERRY_COUNT_OPEN();
+    return berry::detail::procfs::open_process_file(data.dirfd, data.pid,
+        file);
+}
+
 static boost::filesystem::path extract_link(
-   boost::filesystem::path const& link)
+    berry::detail::process::process_data const& data, char const* link)
 {
-    std::size_t const buffer_size = 1024;
-    std::array<char, buffer_size> buffer;
-    ::ssize_t result = ::readlink(link.c_str(), buffer.data(), buffer.size());
+    std::array<char, PATH_MAX> buffer;
+    ::ssize_t result;
+    BERRY_COUNT_SYSCALLS(1);
+    if(data.dirfd != -1)
+        result = ::readlinkat(data.dirfd, link, buffer.data(), buffer.size());
+    else
+    {
+        std::shared_ptr<berry::unix_like::procfs_context const> const
+            context = berry::unix_like::get_default_procfs_context();
+        result = ::readlinkat(context ? context->fd() : -1,
+            ::make_procfs_path(data.pid, link).c_str(), buffer.data(),
+            buffer.size());
+    }
     if(result == -1)
     {
         std::error_code error(errno, std::system_category());
@@ -73,7 +146,7 @@ berry::process::process()
 { }
 
 berry::process::process(pid_type pid)
-    : m_data(pid)
+    : m_data(::open_process(pid))
 { }
 
 berry::process::process(std::string const& name, bool case_sensitive)
@@ -82,21 +155,26 @@ berry::process::process(std::string const& name, bool case_sensitive)
    boost::optional<process_entry> entry(
        berry::get_entry_by_name(name, case_sensitive));
    if(entry)
-       m_data.pid = entry->pid;
+       m_data = ::open_process(entry->pid);
    else
        throw std::runtime_error("berry::process::process : process not found");
 }
         
 berry::process::process(process const& other)
-    : m_data(other.m_data.pid)
+    : m_data(::copy_process(other.m_data))
 { }
         
 berry::process::process(process&& other)
-    : m_data(other.m_data.pid)
-{ }
+    : m_data(other.m_data)
+{
+    other.m_data = berry::detail::process::process_data();
+}
 
 berry::process::~process()
-{ }
+{
+    pidfd::close(m_data.pidfd);
+    pidfd::close(m_data.dirfd);
+}
 
 /******** Member functions ********/
 berry::pid_type berry::process::pid() const
@@ -107,40 +185,55 @@ berry::pid_type berry::process::pid() const
 std::string berry::process::name() const
 {
     ASSERT_PROCESS();
+    BERRY_INSTRUMENT_API(berry::api_process_name);
     
-    std::string result;
-    {
-        boost::filesystem::ifstream comm(
-            berry::unix_like::get_procfs_dir(*this) / "comm");
-        
-        // Provide fallback.
-        if(!comm)
-            return executable_path().filename().string();
-        
-        std::getline(comm, result);
-    }
-    return result;
+    int const fd = ::open_procfs_file(m_data, "comm");
+    
+    // Provide fallback.
+    if(fd == -1)
+        return executable_path().filename().string();
+    
+    char buffer[64];
+    ::ssize_t size = ::read(fd, buffer, sizeof(buffer));
+    BERRY_COUNT_READ(size);
+    ::close(fd);
+    BERRY_COUNT_SYSCALLS(1);
+    if(size <= 0)
+        return executable_path().filename().string();
+    
+    if(buffer[size - 1] == '\n')
+        --size;
+    return std::string(buffer, size);
 }
         
 boost::filesystem::path berry::process::executable_path() const
 {
     ASSERT_PROCESS();
+    BERRY_INSTRUMENT_API(berry::api_executable_path);
     
-    return ::extract_link(berry::unix_like::get_procfs_dir(*this) / "exe");
+    return ::extract_link(m_data, "exe");
 }
         
 int berry::process::bitness() const
 {
     ASSERT_PROCESS();
+    BERRY_INSTRUMENT_API(berry::api_bitness);
     
-    // Open the process' executable and read the elf ident.
+    // Open the process' executable and read the elf ident. Going through
+    // the exe link also works for deleted executables.
     std::array<char, EI_NIDENT> ident;
     {
-        boost::filesystem::ifstream exe(executable_path());
-        if(!exe)
+        int const fd = ::open_procfs_file(m_data, "exe");
+        if(fd == -1)
+            throw std::runtime_error(
+                "berry::process::bitness : exe not readable");
+        ::ssize_t const size = ::pread(fd, &ident[0], ident.size(), 0);
+        BERRY_COUNT_READ(size);
+        ::close(fd);
+        BERRY_COUNT_SYSCALLS(1);
+        if(size != static_cast< ::ssize_t>(ident.size()))
             throw std::runtime_error(
                 "berry::process::bitness : exe not readable");
-        exe.read(&ident[0], ident.size());
     }
    
     // Assert if it is a valid elf file.
@@ -168,12 +261,19 @@ void berry::process::terminate(bool force)
 {
     ASSERT_PROCESS();
     
-    // Send a sigterm to the process.
-    if(::kill(pid(), force ? SIGKILL : SIGTERM) == -1)
+    // Signal through the pidfd if possible, so a recycled pid is never hit.
+    int const sig = force ? SIGKILL : SIGTERM;
+    int result = -1;
+    if(m_data.pidfd != -1)
+        result = pidfd::send_signal(m_data.pidfd, sig);
+    if(m_data.pidfd == -1 || (result == -1 && errno == ENOSYS))
+        result = ::kill(pid(), sig);
+    
+    if(result == -1)
     {
         std::error_code error(errno, std::system_category());
         throw std::system_error(error,
-            "berry::process::terminate : ::kill failed");
+            "berry::process::terminate : sending the signal failed");
     }
 }
         
@@ -181,20 +281,48 @@ bool berry::process::still_exists() const
 {
     if(*this == berry::not_a_process)
         return false;
+    BERRY_INSTRUMENT_API(berry::api_still_exists);
     
-    return boost::filesystem::exists(berry::unix_like::get_procfs_dir(*this));
+    // A pidfd knows if its process is gone, even if the pid was reused.
+    if(m_data.pidfd != -1)
+    {
+        BERRY_COUNT_SYSCALLS(1);
+        if(pidfd::send_signal(m_data.pidfd, 0) == 0 || errno == EPERM)
+            return true;
+        if(errno == ESRCH)
+            return false;
+    }
+    
+    std::shared_ptr<berry::unix_like::procfs_context const> const context =
+        berry::unix_like::get_default_procfs_context();
+    BERRY_COUNT_SYSCALLS(1);
+    return ::faccessat(context ? context->fd() : -1,
+        ::make_procfs_path(m_data.pid, "").c_str(), F_OK, 0) == 0;
 }
 
 /******** Member operator overloads ********/
 berry::process& berry::process::operator=(berry::process const& other)
 {
-    m_data.pid = other.m_data.pid;
+    if(this != &other)
+    {
+        berry::detail::process::process_data copy(
+            ::copy_process(other.m_data));
+        pidfd::close(m_data.pidfd);
+        pidfd::close(m_data.dirfd);
+        m_data = copy;
+    }
     return *this;
 }
         
 berry::process& berry::process::operator=(berry::process&& other)
 {
-    m_data.pid = other.m_data.pid;
+    if(this != &other)
+    {
+        pidfd::close(m_data.pidfd);
+        pidfd::close(m_data.dirfd);
+        m_data = other.m_data;
+        other.m_data = berry::detail::process::process_data();
+    }
     return *this;
 }
 
@@ -205,15 +333,26 @@ berry::process const& berry::get_current_process()
     return current_process;
 }
 
-static boost::filesystem::path g_procfs_base("/proc/");
-
 void berry::unix_like::set_procfs_base(boost::filesystem::path const& base_dir)
 {
-    assert(boost::filesystem::exists(base_dir));
-    g_procfs_base = base_dir;
+    berry::unix_like::set_default_procfs_context(
+        std::make_shared<berry::unix_like::procfs_context const>(base_dir));
+}
+
+boost::filesystem::path berry::unix_like::get_procfs_dir(
+    berry::process const& proc)
+{
+    return berry::detail::procfs::context(
+        "berry::unix_like::get_procfs_dir")->root() /
+        std::to_string(proc.pid());
+}
+
+int berry::unix_like::get_pidfd(berry::process const& proc)
+{
+    return proc.m_data.pidfd;
 }
 
-boost::filesystem::path berry::unix_like::get_procfs_dir(berry::process proc)
+int berry::unix_like::get_procfs_dirfd(berry::process const& proc)
 {
-    return g_procfs_base / std::to_string(proc.pid());
+    return proc.m_data.dirfd;
 }
@@ -0,0 +1,209 @@
+/**
+ * @file linux/process_activity.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief I/O and scheduler rates between samples for Linux.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <berry/detail/system.hpp>
+#ifndef BERRY_LINUX
+#   error "Attempt to compile source file on a wrong system"
+#endif
+
+// C++ Standard Library:
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Berry:
+#include <berry/process_activity.hpp>
+#include <berry/process_entry.hpp>
+#include <berry/process_table.hpp>
+
+/******** Free helper functions ********/
+namespace
+{
+    unsigned const activity_fields =
+        berry::snapshot_io | berry::snapshot_schedstat;
+
+    double io_rate(berry::process_activity const& activity)
+    {
+        return activity.read_rate + activity.write_rate;
+    }
+
+    double rank(berry::process_activity const& activity,
+        berry::activity_order order)
+    {
+        switch(order)
+        {
+        case berry::order_by_io_rate:
+            return ::io_rate(activity);
+        case berry::order_by_syscall_rate:
+            return activity.syscall_rate;
+        case berry::order_by_run_delay:
+            return activity.run_delay;
+        default:
+            return activity.cpu_usage;
+        }
+    }
+
+    // A process keeps its start time, a different one means a new process
+    // got the pid in between.
+    bool reused(berry::process_entry const& before,
+        berry::process_entry const& after)
+    {
+        return after.start_time != before.start_time;
+    }
+
+    // Counters only grow while a process lives. A smaller value means one
+    // sample didn't read the file, the difference would wrap around.
+    double increase(std::uint64_t before, std::uint64_t after)
+    {
+        return after > before ? static_cast<double>(after - before) : 0;
+    }
+    
+    bool both_read(berry::process_entry const& before,
+        berry::process_entry const& after, unsigned field)
+    {
+        return (before.counters_read & after.counters_read & field) != 0;
+    }
+
+    std::shared_ptr<berry::process_table const> take_sample(
+        unsigned fields)
+    {
+        berry::process_snapshot snap(berry::create_process_snapshot(
+            fields | ::activity_fields));
+        return std::make_shared<berry::process_table const>(snap);
+    }
+}
+
+/******** Constructors ********/
+berry::process_activity::process_activity()
+    : pid(0), name(), read_rate(0), write_rate(0), syscall_rate(0),
+      run_delay(0), cpu_usage(0)
+{ }
+
+berry::activity_sampler::activity_sampler(unsigned fields)
+    : m_fields(fields | ::activity_fields), m_previous(::take_sample(fields)),
+      m_activity()
+{ }
+
+/******** Member functions ********/
+std::vector<berry::process_activity> const& berry::activity_sampler::sample()
+{
+    std::shared_ptr<berry::process_table const> const current =
+        ::take_sample(m_fields);
+    m_activity = berry::compute_activity(*m_previous, *current);
+    m_previous = current;
+    return m_activity;
+}
+
+std::vector<berry::process_activity> const&
+    berry::activity_sampler::activity() const
+{
+    return m_activity;
+}
+
+std::vector<berry::process_activity> berry::activity_sampler::top(
+    std::size_t count, berry::activity_order order) const
+{
+    return berry::top_activity(m_activity, count, order);
+}
+
+std::shared_ptr<berry::process_table const>
+    berry::activity_sampler::latest() const
+{
+    return m_previous;
+}
+
+/******** Free functions ********/
+std::vector<berry::process_activity> berry::compute_activity(
+    berry::process_table const& before, berry::process_table const& after,
+    std::chrono::steady_clock::duration interval)
+{
+    std::vector<berry::process_activity> result;
+    double const seconds =
+        std::chrono::duration<double>(interval).count();
+    if(seconds <= 0)
+        return result;
+
+    // Both tables are sorted by pid, so one merge pass matches them.
+    std::vector<berry::process_entry> const& old_entries = before.entries();
+    std::vector<berry::process_entry> const& new_entries = after.entries();
+    std::size_t i = 0;
+    result.reserve(new_entries.size());
+    for(std::size_t j = 0; j < new_entries.size(); ++j)
+    {
+        berry::process_entry const& now = new_entries[j];
+        while(i < old_entries.size() && old_entries[i].pid < now.pid)
+            ++i;
+        if(i == old_entries.size() || old_entries[i].pid != now.pid ||
+            ::reused(old_entries[i], now))
+            continue;
+
+        berry::process_entry const& then = old_entries[i];
+        berry::process_activity activity;
+        activity.pid = now.pid;
+        activity.name = now.name;
+        if(::both_read(then, now, berry::snapshot_io))
+        {
+            activity.read_rate = ::increase(then.io.read_bytes,
+                now.io.read_bytes) / seconds;
+            activity.write_rate = ::increase(then.io.write_bytes,
+                now.io.write_bytes) / seconds;
+            activity.syscall_rate = ::increase(then.io.read_syscalls +
+                then.io.write_syscalls, now.io.read_syscalls +
+                now.io.write_syscalls) / seconds;
+        }
+        if(::both_read(then, now, berry::snapshot_schedstat))
+        {
+            activity.run_delay = ::increase(then.scheduler.wait_time,
+                now.scheduler.wait_time) / 1e9 / seconds;
+            activity.cpu_usage = ::increase(then.scheduler.run_time,
+                now.scheduler.run_time) / 1e9 / seconds;
+        }
+        result.push_back(activity);
+    }
+    return result;
+}
+
+std::vector<berry::process_activity> berry::compute_activity(
+    berry::process_table const& before, berry::process_table const& after)
+{
+    return berry::compute_activity(before, after,
+        after.created() - before.created());
+}
+
+std::vector<berry::process_activity> berry::top_activity(
+    std::vector<berry::process_activity> const& activity, std::size_t count,
+    berry::activity_order order)
+{
+    std::vector<berry::process_activity> result(
+        std::min(count, activity.size()));
+    std::partial_sort_copy(activity.begin(), activity.end(),
+        result.begin(), result.end(),
+        [order](berry::process_activity const& a,
+            berry::process_activity const& b)
+        {
+            return ::rank(a, order) > ::rank(b, order);
+        });
+    return result;
+}
@@ -27,94 +27,394 @@
 #endif
 
 // System:
-#include <glob.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 // C++ Standard Library:
-#include <limits>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 // Boost Library:
 #include <boost/optional.hpp>
-#include <boost/filesystem/path.hpp>
-#include <boost/filesystem/fstream.hpp>
 
 // Berry:
 #include <berry/process.hpp>
 #include <berry/process_entry.hpp>
+#include <berry/procfs_context.hpp>
+#include <berry/detail/procfs.hpp>
+#include <berry/detail/batch_read.hpp>
+#include <berry/detail/instrumentation.hpp>
+
+namespace procfs = berry::detail::procfs;
 
 /******** Helper classes ********/
+// Stat files read ahead per batch, and the slot size of each. The slot
+// matches the stack buffer of the synchronous path.
+static std::size_t const stat_batch = 128;
+static std::size_t const stat_size = 1024;
+
 struct snapshot
 {
-    snapshot()
-        : data_ptr(0), data()
+    snapshot(std::shared_ptr<berry::unix_like::procfs_context const> context,
+        unsigned fields)
+        : context(std::move(context)), pids(), next(0), fields(fields),
+          read_timeout(std::chrono::steady_clock::duration::zero()),
+          buffer(), batch(), batch_begin(0), batch_count(0)
     {
-        int result =
-            ::glob("/proc/[0-9]*", GLOB_ONLYDIR, 0, &data);
-        if(result == GLOB_NOSPACE)
-            throw std::runtime_error("snapshot::snapshot : out of memory");
-        if(result == GLOB_ABORTED || result == GLOB_NOMATCH)
+        if(!this->context->list_processes(pids))
             throw std::runtime_error(   "snapshot::snapshot : "
                                         "procfs not correctly mounted");
+        if(fields & berry::snapshot_batched)
+            make_batch_reader();
     }
-   
-    ~snapshot()
+
+    snapshot(std::shared_ptr<berry::unix_like::procfs_context const> context,
+        std::vector<berry::pid_type>&& pids, unsigned fields)
+        : context(std::move(context)), pids(std::move(pids)), next(0),
+          fields(fields),
+          read_timeout(std::chrono::steady_clock::duration::zero()),
+          buffer(), batch(), batch_begin(0), batch_count(0)
     {
-        ::globfree(&data);
+        if(fields & berry::snapshot_batched)
+            make_batch_reader();
     }
-   
-    std::size_t data_ptr;
-    ::glob_t data;
+
+    // A smaller ring is set up faster, worth it for small systems.
+    void make_batch_reader()
+    {
+        std::size_t const capacity = std::max<std::size_t>(1,
+            std::min(::stat_batch, pids.size()));
+        batch.reset(new procfs::batch_reader(capacity, ::stat_size));
+    }
+
+    // Kept for the whole iteration, changing the default context doesn't
+    // affect existing snapshots.
+    std::shared_ptr<berry::unix_like::procfs_context const> context;
+    std::vector<berry::pid_type> pids;
+    std::size_t next;
+    unsigned fields;
+
+    // Zero reads synchronously.
+    std::chrono::steady_clock::duration read_timeout;
+
+    // Reused for the optional files.
+    std::vector<char> buffer;
+
+    // Stat files of pids[batch_begin, batch_begin + batch_count), only
+    // with snapshot_batched.
+    std::unique_ptr<procfs::batch_reader> batch;
+    std::size_t batch_begin;
+    std::size_t batch_count;
 };
 
 /******** Free helper functions ********/
+static char const nspid_key[] = "\nNSpid:";
+
+struct io_key
+{
+    char const* name;
+    std::size_t size;
+    std::uint64_t berry::io_counters::* field;
+};
+
+#define BERRY_IO_KEY(name, field) \
+    { name, sizeof(name) - 1, &berry::io_counters::field }
+
+static io_key const io_keys[] = {
+    BERRY_IO_KEY("rchar", read_chars),
+    BERRY_IO_KEY("wchar", write_chars),
+    BERRY_IO_KEY("syscr", read_syscalls),
+    BERRY_IO_KEY("syscw", write_syscalls),
+    BERRY_IO_KEY("read_bytes", read_bytes),
+    BERRY_IO_KEY("write_bytes", write_bytes)
+};
+
+#undef BERRY_IO_KEY
+
 static void destroy_snapshot(void* snap)
 {
     delete static_cast< ::snapshot*>(snap);
 }
 
-static berry::process_entry make_entry_from_path(boost::filesystem::path& dir)
+// Records the pid namespace and the NSpid chain. The namespace link needs
+// ptrace access, so it stays 0 for foreign processes of other users.
+static void add_namespaces(int root, berry::pid_type pid,
+    berry::process_entry& entry)
 {
-    dir /= "stat";
-    boost::filesystem::ifstream stat(dir);
-   
-    berry::process_entry result;
-    stat >> result.pid;
-    stat.ignore(std::numeric_limits<std::streamsize>::max(), '(');
-    std::getline(stat, result.name, ')');
-    char state; stat >> state >> result.parent_pid;
-   
-    return result;
+    char path[64];
+    std::snprintf(path, sizeof(path), "%d/ns/pid", pid);
+    struct ::stat info;
+    BERRY_COUNT_SYSCALLS(1);
+    entry.pid_namespace = ::fstatat(root, path, &info, 0) == 0 ?
+        info.st_ino : 0;
+
+    std::snprintf(path, sizeof(path), "%d/status", pid);
+    char buffer[4096];
+    long const size = procfs::read_small_file(root, path, buffer,
+        sizeof(buffer));
+    entry.namespace_pids.clear();
+    if(size <= 0)
+        return;
+
+    char const* const begin = buffer;
+    char const* const end = buffer + size;
+    char const* it = std::search(begin, end, ::nspid_key,
+        ::nspid_key + sizeof(::nspid_key) - 1);
+    if(it == end)
+        return;
+    it += sizeof(::nspid_key) - 1;
+    for(;;)
+    {
+        it = procfs::skip_blanks(it, end);
+        std::uint64_t value = 0;
+        char const* const next = procfs::parse_decimal(it, end, value);
+        if(next == it)
+            break;
+        entry.namespace_pids.push_back(static_cast<berry::pid_type>(value));
+        it = next;
+    }
+}
+
+// Parses the "key: value" lines of /proc/<pid>/io in a stack buffer. The
+// file needs ptrace access, the counters stay zero without.
+static void add_io(int root, berry::pid_type pid,
+    berry::process_entry& entry)
+{
+    entry.io = berry::io_counters();
+    char path[64];
+    std::snprintf(path, sizeof(path), "%d/io", pid);
+    char buffer[512];
+    long const size = procfs::read_small_file(root, path, buffer,
+        sizeof(buffer));
+    if(size <= 0)
+        return;
+    entry.counters_read |= berry::snapshot_io;
+
+    char const* it = buffer;
+    char const* const end = buffer + size;
+    while(it != end)
+    {
+        char const* line_end = static_cast<char const*>(
+            std::memchr(it, '\n', end - it));
+        if(!line_end)
+            line_end = end;
+        char const* const colon = static_cast<char const*>(
+            std::memchr(it, ':', line_end - it));
+        for(std::size_t i = 0; colon &&
+            i < sizeof(::io_keys) / sizeof(*::io_keys); ++i)
+        {
+            ::io_key const& key = ::io_keys[i];
+            if(key.size == static_cast<std::size_t>(colon - it) &&
+                std::memcmp(key.name, it, key.size) == 0)
+            {
+                procfs::parse_decimal(procfs::skip_blanks(colon + 1,
+                    line_end), line_end, entry.io.*key.field);
+                break;
+            }
+        }
+        it = line_end == end ? end : line_end + 1;
+    }
+}
+
+// Parses "run_time wait_time timeslices" of /proc/<pid>/schedstat.
+static void add_schedstat(int root, berry::pid_type pid,
+    berry::process_entry& entry)
+{
+    entry.scheduler = berry::scheduler_counters();
+    char path[64];
+    std::snprintf(path, sizeof(path), "%d/schedstat", pid);
+    char buffer[128];
+    long const size = procfs::read_small_file(root, path, buffer,
+        sizeof(buffer));
+    if(size <= 0)
+        return;
+    entry.counters_read |= berry::snapshot_schedstat;
+
+    char const* const end = buffer + size;
+    char const* it = procfs::parse_decimal(buffer, end,
+        entry.scheduler.run_time);
+    it = procfs::parse_decimal(procfs::skip_blanks(it, end), end,
+        entry.scheduler.wait_time);
+    procfs::parse_decimal(procfs::skip_blanks(it, end), end,
+        entry.scheduler.timeslices);
+}
+
+// Records the command line, through the helper threads if the snapshot
+// has a read timeout.
+static void add_cmdline(::snapshot& snap, berry::pid_type pid,
+    berry::process_entry& entry)
+{
+    char path[64];
+    std::snprintf(path, sizeof(path), "%d/cmdline", pid);
+    bool read = false;
+    if(snap.read_timeout == std::chrono::steady_clock::duration::zero())
+    {
+        snap.buffer.clear();
+        read = procfs::append_file(snap.context->fd(), path,
+            snap.buffer) != -1;
+    }
+    else
+    {
+        procfs::bounded_result const result = procfs::read_file_bounded(
+            snap.context, path, snap.buffer, snap.read_timeout);
+        entry.available = result != procfs::bounded_read_timed_out;
+        read = result == procfs::bounded_read_ok;
+    }
+
+    if(read)
+        entry.cmdline.assign(snap.buffer.begin(), snap.buffer.end());
+    else
+        entry.cmdline.clear();
+}
+
+// Returns the stat file of the index'th pid, reading ahead a batch of
+// them if the snapshot has a batch reader.
+static long read_stat(::snapshot& snap, std::size_t index,
+    char (&buffer)[::stat_size], char const*& data)
+{
+    if(!snap.batch)
+    {
+        char path[64];
+        std::snprintf(path, sizeof(path), "%d/stat", snap.pids[index]);
+        data = buffer;
+        return procfs::read_small_file(snap.context->fd(), path, buffer,
+            sizeof(buffer));
+    }
+
+    if(index < snap.batch_begin ||
+        index >= snap.batch_begin + snap.batch_count)
+    {
+        snap.batch_begin = index;
+        snap.batch_count = std::min(::stat_batch, snap.pids.size() - index);
+        snap.batch->read(snap.context->fd(), &snap.pids[index],
+            snap.batch_count, "stat");
+    }
+    data = snap.batch->data(index - snap.batch_begin);
+    return snap.batch->size(index - snap.batch_begin);
+}
+
+// Reads /proc/<pid>/stat into a stack buffer and parses it in place, the
+// only allocation left is the entry's name.
+static bool make_entry(::snapshot& snap, std::size_t index,
+    berry::process_entry& entry)
+{
+    int const root = snap.context->fd();
+    unsigned const fields = snap.fields;
+    berry::pid_type const pid = snap.pids[index];
+
+    char buffer[::stat_size];
+    char const* data = 0;
+    long const size = ::read_stat(snap, index, buffer, data);
+    procfs::stat_line line;
+    if(size <= 0 || !procfs::parse_stat(data, data + size, line))
+        return false;
+
+    entry.pid = line.pid;
+    entry.parent_pid = line.parent_pid;
+    entry.name.assign(line.name, line.name_size);
+    entry.start_time = line.start_time;
+    if(fields & berry::snapshot_namespaces)
+        ::add_namespaces(root, pid, entry);
+    entry.available = true;
+    entry.counters_read = 0;
+    if(fields & berry::snapshot_cmdline)
+        ::add_cmdline(snap, pid, entry);
+    if(fields & berry::snapshot_io)
+        ::add_io(root, pid, entry);
+    if(fields & berry::snapshot_schedstat)
+        ::add_schedstat(root, pid, entry);
+    return true;
 }
 
 /******** Constructors and Destructor ********/
 berry::process_entry::process_entry()
-    : pid(0), parent_pid(0), name()
+    : pid(0), parent_pid(0), name(), pid_namespace(0), namespace_pids(),
+      cmdline(), available(true), counters_read(0), io(), scheduler(),
+      start_time(0)
+{ }
+
+berry::io_counters::io_counters()
+    : read_chars(0), write_chars(0), read_syscalls(0), write_syscalls(0),
+      read_bytes(0), write_bytes(0)
+{ }
+
+berry::scheduler_counters::scheduler_counters()
+    : run_time(0), wait_time(0), timeslices(0)
 { }
 
 /******** Free functions ********/
+std::shared_ptr<void> berry::detail::procfs::make_process_snapshot(
+    std::vector<berry::pid_type> pids, unsigned fields)
+{
+    BERRY_INSTRUMENT_API(berry::api_create_snapshot);
+    return std::shared_ptr<void>(new ::snapshot(procfs::context(
+        "berry::detail::procfs::make_process_snapshot"), std::move(pids),
+        fields), &::destroy_snapshot);
+}
+
 berry::process_snapshot berry::create_process_snapshot()
 {
-    return berry::process_snapshot(new ::snapshot(), &::destroy_snapshot);
+    return berry::create_process_snapshot(0);
+}
+
+berry::process_snapshot berry::create_process_snapshot(unsigned fields)
+{
+    BERRY_INSTRUMENT_API(berry::api_create_snapshot);
+    return berry::process_snapshot(new ::snapshot(procfs::context(
+        "berry::create_process_snapshot"), fields), &::destroy_snapshot);
+}
+
+berry::process_snapshot berry::create_process_snapshot(unsigned fields,
+    std::chrono::milliseconds read_timeout)
+{
+    BERRY_INSTRUMENT_API(berry::api_create_snapshot);
+    ::snapshot* const snap = new ::snapshot(procfs::context(
+        "berry::create_process_snapshot"), fields);
+    snap->read_timeout = read_timeout;
+    return berry::process_snapshot(snap, &::destroy_snapshot);
+}
+
+berry::process_snapshot berry::create_process_snapshot(unsigned fields,
+    berry::unix_like::procfs_context const& context)
+{
+    BERRY_INSTRUMENT_API(berry::api_create_snapshot);
+    return berry::process_snapshot(new ::snapshot(
+        std::make_shared<berry::unix_like::procfs_context const>(context),
+        fields), &::destroy_snapshot);
 }
    
 berry::process_entry
     berry::extract_first_process(berry::process_snapshot& snap)
 {
-    ::snapshot* ss = static_cast< ::snapshot*>(snap.get());
-    boost::filesystem::path dir(ss->data.gl_pathv[0]);
-    return ::make_entry_from_path(dir);
+    static_cast< ::snapshot*>(snap.get())->next = 0;
+    boost::optional<berry::process_entry> entry =
+        berry::extract_next_process(snap);
+    if(!entry)
+        throw std::runtime_error(
+            "berry::extract_first_process : no process found");
+    return *entry;
 }
    
 boost::optional<berry::process_entry> berry::extract_next_process(
     berry::process_snapshot& snap)
 {
+    // Processes which exited since the snapshot was taken are skipped.
+    BERRY_INSTRUMENT_API(berry::api_extract_process);
     ::snapshot* ss = static_cast< ::snapshot*>(snap.get());
-    if(ss->data_ptr < ss->data.gl_pathc)
+    berry::process_entry entry;
+    while(ss->next < ss->pids.size())
     {
-        boost::filesystem::path dir(ss->data.gl_pathv[ss->data_ptr++]);
-        return boost::optional<berry::process_entry>(
-            ::make_entry_from_path(dir));
+        if(::make_entry(*ss, ss->next++, entry))
+            return entry;
     }
    
     return boost::optional<berry::process_entry>();
-}
\ No newline at end of file
+}
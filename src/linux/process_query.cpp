@@ -0,0 +1,349 @@
+/**
+ * @file linux/process_query.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Process search for Linux.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <berry/detail/system.hpp>
+#ifndef BERRY_LINUX
+#   error "Attempt to compile source file on a wrong system"
+#endif
+
+// System:
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+// C++ Standard Library:
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Boost Library:
+#include <boost/algorithm/string/compare.hpp>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/process_entry.hpp>
+#include <berry/process_query.hpp>
+#include <berry/detail/procfs.hpp>
+
+namespace procfs = berry::detail::procfs;
+
+/******** Free helper functions ********/
+namespace
+{
+    // Reads a small file relative to the ProcFS base directory.
+    long read_at(int basefd, char const* path, char* buffer, std::size_t size,
+        berry::query_statistics& statistics)
+    {
+        ++statistics.files_read;
+        return procfs::read_small_file(basefd, path, buffer, size);
+    }
+
+    bool same_name(char const* begin, char const* end, std::string const& name,
+        bool case_sensitive)
+    {
+        if(static_cast<std::size_t>(end - begin) != name.size())
+            return false;
+        if(case_sensitive)
+            return std::equal(begin, end, name.begin());
+        return std::equal(begin, end, name.begin(),
+            boost::algorithm::is_iequal());
+    }
+
+    // Finds the cgroup v2 entry ("0::/path") of a /proc/<pid>/cgroup file.
+    bool find_unified_cgroup(char const* begin, char const* end,
+        char const*& path_begin, char const*& path_end)
+    {
+        char const* line = begin;
+        while(line < end)
+        {
+            char const* line_end = static_cast<char const*>(
+                std::memchr(line, '\n', end - line));
+            if(!line_end)
+                line_end = end;
+            if(line_end - line >= 3 && std::memcmp(line, "0::", 3) == 0)
+            {
+                path_begin = line + 3;
+                path_end = line_end;
+                return true;
+            }
+            line = line_end + 1;
+        }
+        return false;
+    }
+
+    // Finds the effective user id, the second value of the Uid line of a
+    // /proc/<pid>/status file.
+    bool find_effective_uid(char const* begin, char const* end,
+        std::uint64_t& uid)
+    {
+        char const* line = begin;
+        while(line < end)
+        {
+            char const* line_end = static_cast<char const*>(
+                std::memchr(line, '\n', end - line));
+            if(!line_end)
+                line_end = end;
+            if(line_end - line >= 4 && std::memcmp(line, "Uid:", 4) == 0)
+            {
+                char const* it = procfs::skip_blanks(line + 4, line_end);
+                it = procfs::parse_decimal(it, line_end, uid);
+                it = procfs::skip_blanks(it, line_end);
+                return procfs::parse_decimal(it, line_end, uid) != it;
+            }
+            line = line_end + 1;
+        }
+        return false;
+    }
+
+    bool in_cgroup(char const* begin, char const* end,
+        std::string const& cgroup, bool recursive)
+    {
+        std::size_t const size = end - begin;
+        if(size < cgroup.size() ||
+            std::memcmp(begin, cgroup.data(), cgroup.size()) != 0)
+        {
+            return false;
+        }
+        if(size == cgroup.size())
+            return true;
+        return recursive && (cgroup == "/" || begin[cgroup.size()] == '/');
+    }
+}
+
+/******** Constructors and Destructor ********/
+berry::query_statistics::query_statistics()
+    : processes(0), stats(0), files_read(0)
+{ }
+
+berry::process_query::process_query()
+    :   m_name(), m_case_sensitive(true), m_uid(), m_parent_pid(), m_state(),
+        m_cgroup(), m_cgroup_recursive(false), m_cmdline(),
+        m_context()
+{ }
+
+/******** Member functions ********/
+berry::process_query& berry::process_query::with_name(
+    std::string const& name, bool case_sensitive)
+{
+    m_name = name.substr(0, berry::detail::process::max_comm_len);
+    m_case_sensitive = case_sensitive;
+    return *this;
+}
+
+berry::process_query& berry::process_query::with_uid(unsigned int uid)
+{
+    m_uid = uid;
+    return *this;
+}
+
+berry::process_query& berry::process_query::with_parent(berry::pid_type pid)
+{
+    m_parent_pid = pid;
+    return *this;
+}
+
+berry::process_query& berry::process_query::with_state(char state)
+{
+    m_state = state;
+    return *this;
+}
+
+berry::process_query& berry::process_query::with_cgroup(
+    std::string const& cgroup, bool recursive)
+{
+    std::string normalized(cgroup);
+    if(normalized.empty() || normalized[0] != '/')
+        normalized.insert(normalized.begin(), '/');
+    while(normalized.size() > 1 && normalized[normalized.size() - 1] == '/')
+        normalized.erase(normalized.size() - 1);
+    m_cgroup = normalized;
+    m_cgroup_recursive = recursive;
+    return *this;
+}
+
+berry::process_query& berry::process_query::with_cmdline(
+    std::string const& pattern)
+{
+    m_cmdline = std::make_shared<std::regex const>(pattern,
+        std::regex::ECMAScript | std::regex::optimize);
+    return *this;
+}
+
+berry::process_query& berry::process_query::with_procfs(
+    berry::unix_like::procfs_context const& context)
+{
+    m_context = std::make_shared<berry::unix_like::procfs_context const>(
+        context);
+    return *this;
+}
+
+std::size_t berry::process_query::run(
+    std::vector<berry::process_entry>* out, std::size_t limit,
+    berry::query_statistics* statistics) const
+{
+    berry::query_statistics local;
+    berry::query_statistics& counts = statistics ? *statistics : local;
+    counts = berry::query_statistics();
+
+    std::shared_ptr<berry::unix_like::procfs_context const> const context =
+        m_context ? m_context : procfs::context("berry::process_query::run");
+    std::vector<berry::pid_type> pids;
+    if(!context->list_processes(pids))
+        throw std::runtime_error(   "berry::process_query::run : "
+                                    "procfs not correctly mounted");
+    std::sort(pids.begin(), pids.end());
+
+    int const basefd = context->fd();
+
+    std::size_t found = 0;
+    std::vector<char> arena;
+    for(std::size_t i = 0; i < pids.size() && found < limit; ++i)
+    {
+        ++counts.processes;
+        char path[64];
+        char buffer[1024];
+        int const length = std::snprintf(path, sizeof(path), "%d",
+            pids[i]);
+
+        // 1. The directory is owned by the process' effective user,
+        // unless the process isn't dumpable (e.g. setuid programs), then
+        // root owns it and only status tells the real owner.
+        if(m_uid)
+        {
+            ++counts.stats;
+            struct ::stat info;
+            if(::fstatat(basefd, path, &info, 0) != 0)
+                continue;
+            if(info.st_uid == 0)
+            {
+                std::uint64_t uid = 0;
+                std::strcpy(path + length, "/status");
+                long const size = ::read_at(basefd, path, buffer,
+                    sizeof(buffer), counts);
+                if(size <= 0 || !::find_effective_uid(buffer, buffer + size,
+                    uid) || uid != *m_uid)
+                {
+                    continue;
+                }
+            }
+            else if(info.st_uid != *m_uid)
+                continue;
+        }
+
+        // 2. comm holds the name only, a few bytes.
+        if(m_name)
+        {
+            std::strcpy(path + length, "/comm");
+            long size = ::read_at(basefd, path, buffer, sizeof(buffer),
+                counts);
+            if(size <= 0)
+                continue;
+            if(buffer[size - 1] == '\n')
+                --size;
+            if(!::same_name(buffer, buffer + size, *m_name, m_case_sensitive))
+                continue;
+        }
+
+        // 3. stat is needed for the entry of a match anyway.
+        procfs::stat_line line;
+        std::strcpy(path + length, "/stat");
+        long const stat_size = ::read_at(basefd, path, buffer,
+            sizeof(buffer), counts);
+        if(stat_size <= 0 ||
+            !procfs::parse_stat(buffer, buffer + stat_size, line))
+        {
+            continue;
+        }
+        if(m_parent_pid && line.parent_pid != *m_parent_pid)
+            continue;
+        if(m_state && line.state != *m_state)
+            continue;
+
+        berry::process_entry entry;
+        entry.pid = line.pid;
+        entry.parent_pid = line.parent_pid;
+        entry.name.assign(line.name, line.name_size);
+
+        // 4. cgroup is a few lines.
+        if(m_cgroup)
+        {
+            char cgroup[4096];
+            std::strcpy(path + length, "/cgroup");
+            long const size = ::read_at(basefd, path, cgroup, sizeof(cgroup),
+                counts);
+            char const* begin;
+            char const* end;
+            if(size <= 0 ||
+                !::find_unified_cgroup(cgroup, cgroup + size, begin, end) ||
+                !::in_cgroup(begin, end, *m_cgroup, m_cgroup_recursive))
+            {
+                continue;
+            }
+        }
+
+        // 5. cmdline may be large.
+        if(m_cmdline)
+        {
+            ++counts.files_read;
+            std::strcpy(path + length, "/cmdline");
+            arena.clear();
+            if(procfs::append_file(basefd, path, arena) == -1)
+                continue;
+            while(!arena.empty() && arena.back() == '\0')
+                arena.pop_back();
+            std::replace(arena.begin(), arena.end(), '\0', ' ');
+
+            char const* data = arena.data();
+            if(!std::regex_search(data, data + arena.size(), *m_cmdline))
+                continue;
+        }
+
+        ++found;
+        if(out)
+            out->push_back(entry);
+    }
+    return found;
+}
+
+std::vector<berry::process_entry> berry::process_query::find_all(
+    berry::query_statistics* statistics) const
+{
+    std::vector<berry::process_entry> result;
+    run(&result, static_cast<std::size_t>(-1), statistics);
+    return result;
+}
+
+boost::optional<berry::process_entry> berry::process_query::find_first(
+    berry::query_statistics* statistics) const
+{
+    std::vector<berry::process_entry> result;
+    if(!run(&result, 1, statistics))
+        return boost::optional<berry::process_entry>();
+    return result.front();
+}
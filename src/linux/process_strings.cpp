@@ -0,0 +1,263 @@
+/**
+ * @file linux/process_strings.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Command line and environment reading for Linux.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <berry/detail/system.hpp>
+#ifndef BERRY_LINUX
+#   error "Attempt to compile source file on a wrong system"
+#endif
+
+// C++ Standard Library:
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/process_strings.hpp>
+#include <berry/detail/procfs.hpp>
+
+namespace procfs = berry::detail::procfs;
+
+/******** Free helper functions ********/
+static void make_path(char* path, std::size_t size, berry::pid_type pid,
+    char const* file)
+{
+    std::snprintf(path, size, "%d/%s", pid, file);
+}
+
+/******** Constructors and Destructor ********/
+berry::cmdline_column::cmdline_column()
+    : m_pids(), m_arena(), m_offsets(1, 0)
+{
+    std::shared_ptr<berry::unix_like::procfs_context const> const context =
+        procfs::context("berry::cmdline_column::cmdline_column");
+    if(!context->list_processes(m_pids))
+        throw std::runtime_error(   "berry::cmdline_column::cmdline_column : "
+                                    "procfs not correctly mounted");
+    load(*context);
+}
+
+berry::cmdline_column::cmdline_column(std::vector<berry::pid_type> pids)
+    : m_pids(std::move(pids)), m_arena(), m_offsets(1, 0)
+{
+    if(!m_pids.empty())
+        load(*procfs::context("berry::cmdline_column::cmdline_column"));
+}
+
+berry::cmdline_column::cmdline_column(
+    std::vector<berry::process_entry> const& entries)
+    : m_pids(), m_arena(), m_offsets(1, 0)
+{
+    m_pids.reserve(entries.size());
+    for(std::size_t i = 0; i < entries.size(); ++i)
+        m_pids.push_back(entries[i].pid);
+    if(!m_pids.empty())
+        load(*procfs::context("berry::cmdline_column::cmdline_column"));
+}
+
+/******** Member functions ********/
+bool berry::process_strings::read(int dirfd, char const* path)
+{
+    m_arena.clear();
+    m_strings.clear();
+    if(procfs::append_file(dirfd, path, m_arena) == -1)
+        return false;
+
+    berry::split_strings(berry::string_range(m_arena.data(),
+        m_arena.data() + m_arena.size()), m_strings);
+    return true;
+}
+
+bool berry::process_strings::read_bounded(berry::pid_type pid,
+    char const* file, std::chrono::milliseconds timeout, char const* caller)
+{
+    char path[64];
+    ::make_path(path, sizeof(path), pid, file);
+    m_strings.clear();
+    switch(procfs::read_file_bounded(procfs::context(caller), path, m_arena,
+        timeout))
+    {
+    case procfs::bounded_read_failed:
+        return false;
+    case procfs::bounded_read_timed_out:
+        throw std::system_error(std::make_error_code(std::errc::timed_out),
+            std::string(caller) + " : read timed out");
+    default:
+        break;
+    }
+
+    berry::split_strings(berry::string_range(m_arena.data(),
+        m_arena.data() + m_arena.size()), m_strings);
+    return true;
+}
+
+bool berry::process_strings::read_cmdline(berry::process const& proc)
+{
+    int const dirfd = berry::unix_like::get_procfs_dirfd(proc);
+    if(dirfd != -1)
+        return read(dirfd, "cmdline");
+    return read_cmdline(proc.pid());
+}
+
+bool berry::process_strings::read_cmdline(berry::pid_type pid)
+{
+    char path[64];
+    ::make_path(path, sizeof(path), pid, "cmdline");
+    return read(procfs::context("berry::process_strings::read_cmdline")->fd(),
+        path);
+}
+
+bool berry::process_strings::read_cmdline(berry::pid_type pid,
+    std::chrono::milliseconds read_timeout)
+{
+    return read_bounded(pid, "cmdline", read_timeout,
+        "berry::process_strings::read_cmdline");
+}
+
+bool berry::process_strings::read_environ(berry::process const& proc)
+{
+    int const dirfd = berry::unix_like::get_procfs_dirfd(proc);
+    if(dirfd != -1)
+        return read(dirfd, "environ");
+    return read_environ(proc.pid());
+}
+
+bool berry::process_strings::read_environ(berry::pid_type pid)
+{
+    char path[64];
+    ::make_path(path, sizeof(path), pid, "environ");
+    return read(procfs::context("berry::process_strings::read_environ")->fd(),
+        path);
+}
+
+bool berry::process_strings::read_environ(berry::pid_type pid,
+    std::chrono::milliseconds read_timeout)
+{
+    return read_bounded(pid, "environ", read_timeout,
+        "berry::process_strings::read_environ");
+}
+
+boost::optional<berry::string_range> berry::process_strings::find_variable(
+    std::string const& key) const
+{
+    for(std::size_t i = 0; i < m_strings.size(); ++i)
+    {
+        berry::string_range const& entry = m_strings[i];
+        if(static_cast<std::size_t>(entry.size()) > key.size() &&
+            entry.begin()[key.size()] == '=' &&
+            std::memcmp(entry.begin(), key.data(), key.size()) == 0)
+        {
+            return berry::string_range(entry.begin() + key.size() + 1,
+                entry.end());
+        }
+    }
+    return boost::optional<berry::string_range>();
+}
+
+std::size_t berry::process_strings::size() const
+{
+    return m_strings.size();
+}
+
+bool berry::process_strings::empty() const
+{
+    return m_strings.empty();
+}
+
+berry::string_range berry::process_strings::operator[](
+    std::size_t index) const
+{
+    return m_strings[index];
+}
+
+berry::process_strings::const_iterator berry::process_strings::begin() const
+{
+    return m_strings.begin();
+}
+
+berry::process_strings::const_iterator berry::process_strings::end() const
+{
+    return m_strings.end();
+}
+
+void berry::cmdline_column::load(
+    berry::unix_like::procfs_context const& context)
+{
+    // Offsets instead of views, the arena moves while it grows.
+    m_offsets.reserve(m_pids.size() + 1);
+    for(std::size_t i = 0; i < m_pids.size(); ++i)
+    {
+        char path[64];
+        ::make_path(path, sizeof(path), m_pids[i], "cmdline");
+        procfs::append_file(context.fd(), path, m_arena);
+        m_offsets.push_back(m_arena.size());
+    }
+    m_arena.shrink_to_fit();
+}
+
+void berry::cmdline_column::append(berry::pid_type pid,
+    berry::string_range cmdline)
+{
+    m_pids.push_back(pid);
+    m_arena.insert(m_arena.end(), cmdline.begin(), cmdline.end());
+    m_offsets.push_back(m_arena.size());
+}
+
+std::size_t berry::cmdline_column::size() const
+{
+    return m_pids.size();
+}
+
+berry::pid_type berry::cmdline_column::pid(std::size_t index) const
+{
+    return m_pids[index];
+}
+
+berry::string_range berry::cmdline_column::cmdline(std::size_t index) const
+{
+    char const* data = m_arena.data();
+    return berry::string_range(data + m_offsets[index],
+        data + m_offsets[index + 1]);
+}
+
+/******** Free functions ********/
+void berry::split_strings(berry::string_range block,
+    std::vector<berry::string_range>& out)
+{
+    char const* it = block.begin();
+    char const* const end = block.end();
+    while(it != end)
+    {
+        char const* terminator = static_cast<char const*>(
+            std::memchr(it, '\0', end - it));
+        if(!terminator)
+            terminator = end;
+        out.push_back(berry::string_range(it, terminator));
+        it = terminator == end ? end : terminator + 1;
+    }
+}
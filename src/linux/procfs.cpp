@@ -0,0 +1,363 @@
+/**
+ * @file linux/procfs.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Non-public helpers to read and parse ProcFS files.
+ * 
+ * This file is part of Berry.
+ * 
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <berry/detail/system.hpp>
+#ifndef BERRY_LINUX
+#   error "Attempt to compile source file on a wrong system"
+#endif
+
+// System:
+#include <sys/types.h>
+#include <sys/sysmacros.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+// C++ Standard Library:
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+// Berry:
+#include <berry/detail/procfs.hpp>
+#include <berry/detail/instrumentation.hpp>
+
+/******** Free functions ********/
+std::shared_ptr<berry::unix_like::procfs_context const>
+    berry::detail::procfs::context(char const* caller)
+{
+    std::shared_ptr<berry::unix_like::procfs_context const> result =
+        berry::unix_like::get_default_procfs_context();
+    if(!result)
+        throw std::runtime_error(std::string(caller) +
+            " : procfs not correctly mounted");
+    return result;
+}
+
+int berry::detail::procfs::open_process_file(int dirfd,
+    berry::detail::process::pid_type pid, std::string const& file)
+{
+    if(dirfd != -1)
+        return ::openat(dirfd, file.c_str(), O_RDONLY | O_CLOEXEC);
+
+    std::shared_ptr<berry::unix_like::procfs_context const> const context =
+        berry::unix_like::get_default_procfs_context();
+    if(!context)
+    {
+        errno = ENOENT;
+        return -1;
+    }
+    std::string const path = std::to_string(pid) + '/' + file;
+    return ::openat(context->fd(), path.c_str(), O_RDONLY | O_CLOEXEC);
+}
+
+bool berry::detail::procfs::read_file(int dirfd, char const* path,
+    std::vector<char>& buffer)
+{
+    BERRY_TIME_PROCFS(path, false);
+    buffer.clear();
+    int const fd = ::openat(dirfd == -1 ? AT_FDCWD : dirfd, path,
+        O_RDONLY | O_CLOEXEC);
+    BERRY_COUNT_OPEN();
+    if(fd == -1)
+        return false;
+
+    std::size_t const chunk = 4096;
+    std::size_t used = 0;
+    bool ok = true;
+    for(;;)
+    {
+        if(buffer.size() < used + chunk)
+            buffer.resize(used + chunk);
+
+        ::ssize_t const result = ::read(fd, &buffer[used], chunk);
+        BERRY_COUNT_READ(result);
+        if(result == -1)
+        {
+            if(errno == EINTR)
+                continue;
+            ok = false;
+            break;
+        }
+        if(result == 0)
+            break;
+        used += static_cast<std::size_t>(result);
+    }
+
+    ::close(fd);
+    BERRY_COUNT_SYSCALLS(1);
+    buffer.resize(used);
+    return ok;
+}
+
+long berry::detail::procfs::append_file(int dirfd, char const* path,
+    std::vector<char>& buffer)
+{
+    BERRY_TIME_PROCFS(path, false);
+    int const fd = ::openat(dirfd == -1 ? AT_FDCWD : dirfd, path,
+        O_RDONLY | O_CLOEXEC);
+    BERRY_COUNT_OPEN();
+    if(fd == -1)
+        return -1;
+
+    // Use the spare capacity, but don't clear megabytes of a big arena for
+    // a file of a few hundred bytes.
+    std::size_t const start = buffer.size();
+    std::size_t used = start;
+    std::size_t wanted = std::min<std::size_t>(64 * 1024,
+        std::max<std::size_t>(4096, buffer.capacity() - used));
+    bool ok = true;
+    for(;;)
+    {
+        buffer.resize(used + wanted);
+        ::ssize_t const result = ::read(fd, &buffer[used], wanted);
+        BERRY_COUNT_READ(result);
+        if(result == -1 && errno == EINTR)
+            continue;
+        if(result == -1)
+        {
+            ok = false;
+            used = start;
+            break;
+        }
+
+        used += static_cast<std::size_t>(result);
+        if(static_cast<std::size_t>(result) < wanted)
+            break;
+        wanted *= 2;
+    }
+
+    ::close(fd);
+    BERRY_COUNT_SYSCALLS(1);
+    buffer.resize(used);
+    return ok ? static_cast<long>(used - start) : -1;
+}
+
+char const* berry::detail::procfs::parse_hex(char const* it, char const* end,
+    std::uint64_t& out)
+{
+    out = 0;
+    for(; it != end; ++it)
+    {
+        char const c = *it;
+        if(c >= '0' && c <= '9')
+            out = (out << 4) | static_cast<std::uint64_t>(c - '0');
+        else if(c >= 'a' && c <= 'f')
+            out = (out << 4) | static_cast<std::uint64_t>(c - 'a' + 10);
+        else if(c >= 'A' && c <= 'F')
+            out = (out << 4) | static_cast<std::uint64_t>(c - 'A' + 10);
+        else
+            break;
+    }
+    return it;
+}
+
+char const* berry::detail::procfs::parse_decimal(char const* it,
+    char const* end, std::uint64_t& out)
+{
+    out = 0;
+    for(; it != end && *it >= '0' && *it <= '9'; ++it)
+        out = out * 10 + static_cast<std::uint64_t>(*it - '0');
+    return it;
+}
+
+char const* berry::detail::procfs::skip_blanks(char const* it,
+    char const* end)
+{
+    while(it != end && (*it == ' ' || *it == '\t'))
+        ++it;
+    return it;
+}
+
+long berry::detail::procfs::read_small_file(int dirfd, char const* path,
+    char* buffer, std::size_t size)
+{
+    BERRY_TIME_PROCFS(path, false);
+    int const fd = ::openat(dirfd == -1 ? AT_FDCWD : dirfd, path,
+        O_RDONLY | O_CLOEXEC);
+    BERRY_COUNT_OPEN();
+    if(fd == -1)
+        return -1;
+
+    ::ssize_t result;
+    do
+    {
+        result = ::read(fd, buffer, size);
+        BERRY_COUNT_READ(result);
+    }
+    while(result == -1 && errno == EINTR);
+    ::close(fd);
+    BERRY_COUNT_SYSCALLS(1);
+    return result;
+}
+
+bool berry::detail::procfs::list_numeric_entries(int dirfd, char const* path,
+    std::vector<berry::detail::process::pid_type>& out)
+{
+    BERRY_TIME_PROCFS(path, true);
+    // A directory stream needs its own descriptor, even for ".".
+    int const fd = ::openat(dirfd == -1 ? AT_FDCWD : dirfd, path,
+        O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    BERRY_COUNT_OPEN();
+    if(fd == -1)
+        return false;
+    ::DIR* dir = ::fdopendir(fd);
+    if(!dir)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    while(::dirent* entry = ::readdir(dir))
+    {
+        char const* name = entry->d_name;
+        if(*name < '1' || *name > '9')
+            continue;
+
+        berry::detail::process::pid_type value = 0;
+        for(; *name >= '0' && *name <= '9'; ++name)
+            value = value * 10 + (*name - '0');
+        if(*name == '\0')
+            out.push_back(value);
+    }
+
+    ::closedir(dir);
+    BERRY_COUNT_SYSCALLS(1);
+    return true;
+}
+
+bool berry::detail::procfs::parse_maps_line(char const* it,
+    char const* end, berry::detail::procfs::maps_line& out)
+{
+    it = berry::detail::procfs::parse_hex(it, end, out.begin);
+    if(it == end || *it++ != '-')
+        return false;
+    it = berry::detail::procfs::parse_hex(it, end, out.end);
+
+    it = berry::detail::procfs::skip_blanks(it, end);
+    if(end - it < 4)
+        return false;
+    out.permissions = it;
+    it = berry::detail::procfs::skip_blanks(it + 4, end);
+
+    it = berry::detail::procfs::parse_hex(it, end, out.offset);
+    it = berry::detail::procfs::skip_blanks(it, end);
+
+    std::uint64_t major;
+    std::uint64_t minor;
+    it = berry::detail::procfs::parse_hex(it, end, major);
+    if(it == end || *it++ != ':')
+        return false;
+    it = berry::detail::procfs::parse_hex(it, end, minor);
+    out.device = makedev(major, minor);
+
+    it = berry::detail::procfs::skip_blanks(it, end);
+    it = berry::detail::procfs::parse_decimal(it, end, out.inode);
+
+    it = berry::detail::procfs::skip_blanks(it, end);
+    out.path = it;
+    out.path_size = end - it;
+    return true;
+}
+
+bool berry::detail::procfs::parse_stat(char const* begin, char const* end,
+    berry::detail::procfs::stat_line& out)
+{
+    // pid (name) state ppid ...
+    char const* open = static_cast<char const*>(
+        std::memchr(begin, '(', end - begin));
+    char const* close = end;
+    while(close != begin && *(close - 1) != ')')
+        --close;
+    if(!open || close == begin || --close <= open)
+        return false;
+
+    std::uint64_t value;
+    berry::detail::procfs::parse_decimal(begin, open, value);
+    out.pid = static_cast<berry::detail::process::pid_type>(value);
+    out.name = open + 1;
+    out.name_size = close - open - 1;
+
+    // Walk the space separated fields after the name. Field 3 is the state,
+    // the numbers are counted like in proc(5).
+    char const* it = close + 1;
+    out.state = '?';
+    out.parent_pid = 0;
+    out.user_time = out.system_time = 0;
+    out.thread_count = out.start_time = 0;
+    out.processor = -1;
+    for(unsigned field = 3; it != end && field <= 39; ++field)
+    {
+        it = berry::detail::procfs::skip_blanks(it, end);
+        if(it == end || *it == '\n')
+            break;
+
+        char const* const token = it;
+        while(it != end && *it != ' ' && *it != '\n')
+            ++it;
+
+        switch(field)
+        {
+        case 3:
+            out.state = *token;
+            break;
+
+        case 4:
+            berry::detail::procfs::parse_decimal(token, it, value);
+            out.parent_pid =
+                static_cast<berry::detail::process::pid_type>(value);
+            break;
+
+        case 14:
+            berry::detail::procfs::parse_decimal(token, it, out.user_time);
+            break;
+
+        case 15:
+            berry::detail::procfs::parse_decimal(token, it, out.system_time);
+            break;
+
+        case 20:
+            berry::detail::procfs::parse_decimal(token, it, out.thread_count);
+            break;
+
+        case 22:
+            berry::detail::procfs::parse_decimal(token, it, out.start_time);
+            break;
+
+        case 39:
+            berry::detail::procfs::parse_decimal(token, it, value);
+            out.processor = static_cast<int>(value);
+            break;
+        }
+    }
+    return out.state != '?';
+}
+
+std::uint64_t berry::detail::procfs::clock_ticks()
+{
+    static std::uint64_t const ticks = ::sysconf(_SC_CLK_TCK);
+    return ticks;
+}
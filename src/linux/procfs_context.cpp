@@ -0,0 +1,176 @@
+/**
+ * @file linux/procfs_context.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief ProcFS roots for Linux.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <berry/detail/system.hpp>
+#ifndef BERRY_LINUX
+#   error "Attempt to compile source file on a wrong system"
+#endif
+
+// System:
+#include <fcntl.h>
+#include <errno.h>
+
+// C++ Standard Library:
+#include <cstdio>
+#include <memory>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/procfs_context.hpp>
+#include <berry/detail/pidfd.hpp>
+#include <berry/detail/procfs.hpp>
+
+namespace pidfd = berry::detail::pidfd;
+namespace procfs = berry::detail::procfs;
+
+/******** Free helper functions ********/
+namespace
+{
+    // Without /proc the default stays empty until one is set.
+    std::shared_ptr<berry::unix_like::procfs_context const> open_default()
+    {
+        try
+        {
+            return std::make_shared<berry::unix_like::procfs_context const>(
+                "/proc");
+        }
+        catch(std::system_error const&)
+        {
+            return std::shared_ptr<berry::unix_like::procfs_context const>();
+        }
+    }
+
+    // Function-local, so the first use from any thread opens /proc once.
+    std::shared_ptr<berry::unix_like::procfs_context const>& default_slot()
+    {
+        static std::shared_ptr<berry::unix_like::procfs_context const> slot(
+            ::open_default());
+        return slot;
+    }
+}
+
+/******** Constructors and Destructor ********/
+berry::unix_like::procfs_context::procfs_context(
+    boost::filesystem::path const& root)
+    : m_root(root),
+      m_fd(::open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC))
+{
+    if(m_fd == -1)
+    {
+        std::error_code error(errno, std::system_category());
+        throw std::system_error(error,
+            "berry::unix_like::procfs_context::procfs_context : "
+            "::open failed");
+    }
+}
+
+berry::unix_like::procfs_context::procfs_context(procfs_context const& other)
+    : m_root(other.m_root), m_fd(pidfd::duplicate(other.m_fd))
+{ }
+
+berry::unix_like::procfs_context::procfs_context(procfs_context&& other)
+    : m_root(std::move(other.m_root)), m_fd(other.m_fd)
+{
+    other.m_fd = -1;
+}
+
+berry::unix_like::procfs_context::~procfs_context()
+{
+    pidfd::close(m_fd);
+}
+
+/******** Member operator overloads ********/
+berry::unix_like::procfs_context&
+    berry::unix_like::procfs_context::operator=(procfs_context const& other)
+{
+    if(this != &other)
+    {
+        int const fd = pidfd::duplicate(other.m_fd);
+        pidfd::close(m_fd);
+        m_fd = fd;
+        m_root = other.m_root;
+    }
+    return *this;
+}
+
+berry::unix_like::procfs_context&
+    berry::unix_like::procfs_context::operator=(procfs_context&& other)
+{
+    if(this != &other)
+    {
+        pidfd::close(m_fd);
+        m_fd = other.m_fd;
+        m_root = std::move(other.m_root);
+        other.m_fd = -1;
+    }
+    return *this;
+}
+
+/******** Member functions ********/
+boost::filesystem::path const& berry::unix_like::procfs_context::root() const
+{
+    return m_root;
+}
+
+int berry::unix_like::procfs_context::fd() const
+{
+    return m_fd;
+}
+
+int berry::unix_like::procfs_context::open_directory(
+    berry::pid_type pid) const
+{
+    char path[32];
+    std::snprintf(path, sizeof(path), "%d", pid);
+    return ::openat(m_fd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+}
+
+int berry::unix_like::procfs_context::open_file(berry::pid_type pid,
+    char const* file) const
+{
+    char path[256];
+    std::snprintf(path, sizeof(path), "%d/%s", pid, file);
+    return ::openat(m_fd, path, O_RDONLY | O_CLOEXEC);
+}
+
+bool berry::unix_like::procfs_context::list_processes(
+    std::vector<berry::pid_type>& out) const
+{
+    return procfs::list_numeric_entries(m_fd, ".", out);
+}
+
+/******** Free functions ********/
+std::shared_ptr<berry::unix_like::procfs_context const>
+    berry::unix_like::get_default_procfs_context()
+{
+    return std::atomic_load(&::default_slot());
+}
+
+void berry::unix_like::set_default_procfs_context(
+    std::shared_ptr<berry::unix_like::procfs_context const> context)
+{
+    std::atomic_store(&::default_slot(), std::move(context));
+}
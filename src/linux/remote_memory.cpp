@@ -0,0 +1,125 @@
+/**
+ * @file linux/remote_memory.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Remote memory API for Linux.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <berry/detail/system.hpp>
+#ifndef BERRY_LINUX
+#   error "Attempt to compile source file on a wrong system"
+#endif
+
+// System:
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <limits.h>
+#include <errno.h>
+
+// C++ Standard Library:
+#include <cassert>
+#include <array>
+#include <stdexcept>
+#include <system_error>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/remote_memory.hpp>
+#include <berry/detail/instrumentation.hpp>
+
+/******** Free helper functions ********/
+namespace
+{
+    // Both iovec arrays passed to process_vm_readv are limited to IOV_MAX
+    // elements, larger batches are split into several calls.
+    std::size_t const max_iovecs = IOV_MAX;
+}
+
+/******** Free functions ********/
+void berry::read_memory(berry::process const& proc,
+    berry::remote_address address, void* buffer, std::size_t size)
+{
+    BERRY_INSTRUMENT_API(berry::api_read_memory);
+    berry::memory_transfer transfer(address, buffer, size);
+    if(berry::read_memory(proc, &transfer, &transfer + 1) != 1)
+    {
+        throw std::runtime_error(
+            "berry::read_memory : remote memory not readable");
+    }
+}
+
+std::size_t berry::read_memory(berry::process const& proc,
+    berry::memory_transfer* begin, berry::memory_transfer* end)
+{
+    assert(proc != berry::not_a_process);
+    BERRY_INSTRUMENT_API(berry::api_read_memory);
+
+    std::array< ::iovec, ::max_iovecs> local;
+    std::array< ::iovec, ::max_iovecs> remote;
+    std::size_t succeeded = 0;
+
+    while(begin != end)
+    {
+        // Fill the iovecs with as many transfers as possible.
+        std::size_t count = 0;
+        for(berry::memory_transfer* it = begin;
+            it != end && count < ::max_iovecs; ++it, ++count)
+        {
+            it->succeeded = false;
+            local[count].iov_base = it->buffer;
+            local[count].iov_len = it->size;
+            remote[count].iov_base = reinterpret_cast<void*>(
+                static_cast<std::uintptr_t>(it->address));
+            remote[count].iov_len = it->size;
+        }
+
+        ::ssize_t result = ::process_vm_readv(proc.pid(), local.data(),
+            count, remote.data(), count, 0);
+        BERRY_COUNT_READ(result);
+        if(result == -1)
+        {
+            // EFAULT means the first range isn't mapped. Skip it and go on
+            // with the rest, everything else is a hard error.
+            if(errno != EFAULT)
+            {
+                std::error_code error(errno, std::system_category());
+                throw std::system_error(error,
+                    "berry::read_memory : ::process_vm_readv failed");
+            }
+            ++begin;
+            continue;
+        }
+
+        // The kernel stops at the first range it can't read. All ranges
+        // before it succeeded, it failed, and we resume after it.
+        std::size_t remaining = static_cast<std::size_t>(result);
+        std::size_t i = 0;
+        for(; i < count && remaining >= begin[i].size; ++i)
+        {
+            remaining -= begin[i].size;
+            begin[i].succeeded = true;
+            ++succeeded;
+        }
+        begin += i;
+        if(i < count)
+            ++begin;
+    }
+
+    return succeeded;
+}
@@ -0,0 +1,342 @@
+/**
+ * @file linux/shared_mappings.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Shared mapping discovery for Linux.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <berry/detail/system.hpp>
+#ifndef BERRY_LINUX
+#   error "Attempt to compile source file on a wrong system"
+#endif
+
+// C++ Standard Library:
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/procfs_context.hpp>
+#include <berry/shared_mappings.hpp>
+#include <berry/detail/parallel.hpp>
+#include <berry/detail/procfs.hpp>
+
+namespace procfs = berry::detail::procfs;
+
+/******** Free helper functions ********/
+namespace
+{
+    struct file_key
+    {
+        std::uint64_t device;
+        std::uint64_t inode;
+
+        bool operator==(file_key const& other) const
+        {
+            return device == other.device && inode == other.inode;
+        }
+    };
+
+    struct file_key_hash
+    {
+        std::size_t operator()(file_key const& key) const
+        {
+            return std::hash<std::uint64_t>()(
+                key.inode * 0x9e3779b97f4a7c15ull ^ key.device);
+        }
+    };
+
+    typedef std::unordered_map<file_key, std::uint32_t, file_key_hash>
+        file_ids;
+
+    char const deleted_marker[] = " (deleted)";
+    char const memfd_prefix[] = "/memfd:";
+    char const sysv_prefix[] = "/SYSV";
+    char const zero_path[] = "/dev/zero";
+
+    bool starts_with(char const* it, std::size_t size, char const* prefix,
+        std::size_t prefix_size)
+    {
+        return size >= prefix_size && std::memcmp(it, prefix, prefix_size) == 0;
+    }
+
+    // Classifies the file by the markers of its maps path and stores the
+    // path without them.
+    berry::mapped_file make_file(procfs::maps_line const& line)
+    {
+        berry::mapped_file file;
+        file.device = line.device;
+        file.inode = line.inode;
+        file.processes = 0;
+        file.mapped_bytes = 0;
+
+        std::size_t size = line.path_size;
+        std::size_t const marker_size = sizeof(::deleted_marker) - 1;
+        bool const deleted = size >= marker_size && std::memcmp(
+            line.path + size - marker_size, ::deleted_marker,
+            marker_size) == 0;
+        if(deleted)
+            size -= marker_size;
+        file.path.assign(line.path, size);
+
+        if(::starts_with(line.path, size, ::memfd_prefix,
+            sizeof(::memfd_prefix) - 1))
+            file.kind = berry::mapping_memfd;
+        else if(::starts_with(line.path, size, ::sysv_prefix,
+            sizeof(::sysv_prefix) - 1) || (deleted && file.path == ::zero_path))
+            file.kind = berry::mapping_shm;
+        else
+            file.kind = deleted ? berry::mapping_deleted : berry::mapping_file;
+        return file;
+    }
+
+    bool file_less(berry::mapped_file const& file, file_key const& key)
+    {
+        if(file.device != key.device)
+            return file.device < key.device;
+        return file.inode < key.inode;
+    }
+
+    bool more_mapped(berry::mapped_file const* lhs,
+        berry::mapped_file const* rhs)
+    {
+        return lhs->mapped_bytes > rhs->mapped_bytes;
+    }
+}
+
+/******** Constructors ********/
+berry::shared_mapping_index::shared_mapping_index(unsigned workers)
+    : m_files(), m_records()
+{
+    std::shared_ptr<berry::unix_like::procfs_context const> const context =
+        procfs::context("berry::shared_mapping_index::shared_mapping_index");
+    int const root = context->fd();
+    std::vector<berry::pid_type> pids;
+    if(!context->list_processes(pids))
+        throw std::runtime_error(   "berry::shared_mapping_index::"
+                                    "shared_mapping_index : procfs not "
+                                    "correctly mounted");
+
+    // Every worker interns the paths of the files it sees once, records
+    // refer to them by a worker local id until the tables are merged.
+    struct worker_state
+    {
+        std::vector<char> buffer;
+        ::file_ids ids;
+        std::vector<berry::mapped_file> files;
+        std::vector<record> records;
+    };
+
+    workers = berry::detail::worker_count(workers, pids.size());
+    std::vector<worker_state> states(workers);
+    berry::detail::parallel_for(pids.size(), workers,
+        [&](unsigned worker, std::size_t i)
+        {
+            worker_state& state = states[worker];
+            char path[64];
+            std::snprintf(path, sizeof(path), "%d/maps", pids[i]);
+            if(!procfs::read_file(root, path, state.buffer))
+                return;
+
+            char const* it = state.buffer.data();
+            char const* const end = it + state.buffer.size();
+            while(it != end)
+            {
+                char const* line_end = static_cast<char const*>(
+                    std::memchr(it, '\n', end - it));
+                if(!line_end)
+                    line_end = end;
+
+                procfs::maps_line line;
+                if(procfs::parse_maps_line(it, line_end, line) &&
+                    line.inode != 0)
+                {
+                    ::file_key const key = { line.device, line.inode };
+                    std::pair< ::file_ids::iterator, bool> const inserted =
+                        state.ids.insert(std::make_pair(key,
+                            static_cast<std::uint32_t>(state.files.size())));
+                    if(inserted.second)
+                        state.files.push_back(::make_file(line));
+
+                    record current;
+                    current.file = inserted.first->second;
+                    current.pid = pids[i];
+                    current.begin = line.begin;
+                    current.end = line.end;
+                    current.offset = line.offset;
+                    state.records.push_back(current);
+                }
+                it = line_end == end ? end : line_end + 1;
+            }
+        });
+
+    // Merge the worker tables, then renumber the files in (device, inode)
+    // order so lookups can binary search.
+    ::file_ids ids;
+    std::vector<std::vector<std::uint32_t> > remap(states.size());
+    for(std::size_t w = 0; w < states.size(); ++w)
+    {
+        worker_state& state = states[w];
+        remap[w].resize(state.files.size());
+        for(std::size_t j = 0; j < state.files.size(); ++j)
+        {
+            ::file_key const key = { state.files[j].device,
+                state.files[j].inode };
+            std::pair< ::file_ids::iterator, bool> const inserted =
+                ids.insert(std::make_pair(key,
+                    static_cast<std::uint32_t>(m_files.size())));
+            if(inserted.second)
+                m_files.push_back(std::move(state.files[j]));
+            remap[w][j] = inserted.first->second;
+        }
+        state.files.clear();
+    }
+
+    std::vector<std::uint32_t> order(m_files.size());
+    for(std::size_t j = 0; j < order.size(); ++j)
+        order[j] = static_cast<std::uint32_t>(j);
+    std::sort(order.begin(), order.end(),
+        [&](std::uint32_t lhs, std::uint32_t rhs)
+        {
+            ::file_key const key = { m_files[rhs].device,
+                m_files[rhs].inode };
+            return ::file_less(m_files[lhs], key);
+        });
+    std::vector<std::uint32_t> rank(order.size());
+    std::vector<berry::mapped_file> sorted;
+    sorted.reserve(m_files.size());
+    for(std::size_t j = 0; j < order.size(); ++j)
+    {
+        rank[order[j]] = static_cast<std::uint32_t>(j);
+        sorted.push_back(std::move(m_files[order[j]]));
+    }
+    m_files.swap(sorted);
+
+    std::size_t total = 0;
+    for(std::size_t w = 0; w < states.size(); ++w)
+        total += states[w].records.size();
+    m_records.reserve(total);
+    for(std::size_t w = 0; w < states.size(); ++w)
+    {
+        std::vector<record>& records = states[w].records;
+        for(std::size_t j = 0; j < records.size(); ++j)
+        {
+            records[j].file = rank[remap[w][records[j].file]];
+            m_records.push_back(records[j]);
+        }
+        std::vector<record>().swap(records);
+    }
+    std::sort(m_records.begin(), m_records.end(),
+        [](record const& lhs, record const& rhs)
+        {
+            if(lhs.file != rhs.file)
+                return lhs.file < rhs.file;
+            if(lhs.pid != rhs.pid)
+                return lhs.pid < rhs.pid;
+            return lhs.begin < rhs.begin;
+        });
+
+    for(std::size_t j = 0; j < m_records.size(); ++j)
+    {
+        record const& current = m_records[j];
+        berry::mapped_file& file = m_files[current.file];
+        file.mapped_bytes += current.end - current.begin;
+        if(j == 0 || m_records[j - 1].file != current.file ||
+            m_records[j - 1].pid != current.pid)
+            ++file.processes;
+    }
+}
+
+/******** Member functions ********/
+berry::mapped_file const* berry::shared_mapping_index::find(
+    std::uint64_t device, std::uint64_t inode) const
+{
+    ::file_key const key = { device, inode };
+    std::vector<berry::mapped_file>::const_iterator const it =
+        std::lower_bound(m_files.begin(), m_files.end(), key, &::file_less);
+    if(it == m_files.end() || it->device != device || it->inode != inode)
+        return 0;
+    return &*it;
+}
+
+std::vector<berry::file_mapping> berry::shared_mapping_index::mappings(
+    berry::mapped_file const& file) const
+{
+    std::uint32_t const index = static_cast<std::uint32_t>(
+        &file - m_files.data());
+    std::vector<record>::const_iterator it = std::lower_bound(
+        m_records.begin(), m_records.end(), index,
+        [](record const& current, std::uint32_t value)
+        {
+            return current.file < value;
+        });
+
+    std::vector<berry::file_mapping> result;
+    for(; it != m_records.end() && it->file == index; ++it)
+    {
+        berry::file_mapping mapping;
+        mapping.pid = it->pid;
+        mapping.begin = it->begin;
+        mapping.end = it->end;
+        mapping.offset = it->offset;
+        result.push_back(mapping);
+    }
+    return result;
+}
+
+std::vector<berry::mapped_file const*>
+    berry::shared_mapping_index::shared_files(
+    std::size_t min_processes) const
+{
+    std::vector<berry::mapped_file const*> result;
+    for(std::size_t i = 0; i < m_files.size(); ++i)
+    {
+        if(m_files[i].processes >= min_processes)
+            result.push_back(&m_files[i]);
+    }
+    std::sort(result.begin(), result.end(), &::more_mapped);
+    return result;
+}
+
+std::vector<berry::mapped_file const*>
+    berry::shared_mapping_index::files_of_kind(
+    berry::mapping_kind kind) const
+{
+    std::vector<berry::mapped_file const*> result;
+    for(std::size_t i = 0; i < m_files.size(); ++i)
+    {
+        if(m_files[i].kind == kind)
+            result.push_back(&m_files[i]);
+    }
+    return result;
+}
+
+std::vector<berry::mapped_file> const&
+    berry::shared_mapping_index::files() const
+{
+    return m_files;
+}
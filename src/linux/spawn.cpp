@@ -0,0 +1,329 @@
+/**
+ * @file linux/spawn.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Process creation for Linux.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <berry/detail/system.hpp>
+#ifndef BERRY_LINUX
+#   error "Attempt to compile source file on a wrong system"
+#endif
+
+// System:
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <errno.h>
+
+// C++ Standard Library:
+#include <algorithm>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/spawn.hpp>
+#include <berry/detail/pidfd.hpp>
+
+#ifndef P_PIDFD
+#   define P_PIDFD 3
+#endif
+
+extern char** environ;
+
+namespace pidfd = berry::detail::pidfd;
+
+/******** Free helper functions ********/
+namespace
+{
+    void throw_error(int error, char const* what)
+    {
+        throw std::system_error(std::error_code(error, std::system_category()),
+            what);
+    }
+
+    // Owns everything the parent sets up for a spawn, so error paths don't
+    // leak descriptors.
+    struct spawn_state
+    {
+        posix_spawn_file_actions_t actions;
+        posix_spawnattr_t attributes;
+        std::vector<int> child_fds;
+        int parent_fds[3];
+
+        spawn_state()
+        {
+            parent_fds[0] = parent_fds[1] = parent_fds[2] = -1;
+            int error = ::posix_spawn_file_actions_init(&actions);
+            if(error)
+                ::throw_error(error, "berry::unix_like::spawn : "
+                    "posix_spawn_file_actions_init failed");
+            error = ::posix_spawnattr_init(&attributes);
+            if(error)
+            {
+                ::posix_spawn_file_actions_destroy(&actions);
+                ::throw_error(error, "berry::unix_like::spawn : "
+                    "posix_spawnattr_init failed");
+            }
+        }
+
+        ~spawn_state()
+        {
+            for(std::size_t i = 0; i < child_fds.size(); ++i)
+                pidfd::close(child_fds[i]);
+            for(int i = 0; i < 3; ++i)
+                pidfd::close(parent_fds[i]);
+            ::posix_spawnattr_destroy(&attributes);
+            ::posix_spawn_file_actions_destroy(&actions);
+        }
+
+        // Duplicates a descriptor above all targets, so the dup2 actions
+        // can't overwrite a source before it was used.
+        int park(int fd, int floor)
+        {
+            int const result = ::fcntl(fd, F_DUPFD_CLOEXEC, floor);
+            if(result == -1)
+                ::throw_error(errno, "berry::unix_like::spawn : "
+                    "::fcntl failed");
+            child_fds.push_back(result);
+            return result;
+        }
+
+        void add_dup2(int source, int target)
+        {
+            int const error = ::posix_spawn_file_actions_adddup2(&actions,
+                source, target);
+            if(error)
+                ::throw_error(error, "berry::unix_like::spawn : "
+                    "posix_spawn_file_actions_adddup2 failed");
+        }
+    };
+
+    void setup_stdio(spawn_state& state, berry::unix_like::stdio_mode mode,
+        int target, int floor)
+    {
+        if(mode == berry::unix_like::stdio_inherit)
+            return;
+
+        if(mode == berry::unix_like::stdio_null)
+        {
+            int const flags = target == STDIN_FILENO ? O_RDONLY : O_WRONLY;
+            int const error = ::posix_spawn_file_actions_addopen(
+                &state.actions, target, "/dev/null", flags, 0);
+            if(error)
+                ::throw_error(error, "berry::unix_like::spawn : "
+                    "posix_spawn_file_actions_addopen failed");
+            return;
+        }
+
+        int ends[2];
+        if(::pipe2(ends, O_CLOEXEC) != 0)
+            ::throw_error(errno, "berry::unix_like::spawn : ::pipe2 failed");
+
+        // The child reads stdin and writes the other streams.
+        int const child_end = target == STDIN_FILENO ? 0 : 1;
+        state.parent_fds[target] = ends[1 - child_end];
+        int parked = -1;
+        try
+        {
+            parked = state.park(ends[child_end], floor);
+        }
+        catch(...)
+        {
+            ::close(ends[child_end]);
+            throw;
+        }
+        ::close(ends[child_end]);
+        state.add_dup2(parked, target);
+    }
+}
+
+/******** Constructors and Destructor ********/
+berry::unix_like::spawn_options::spawn_options()
+    : arguments(), environment(), working_directory(),
+      stdin_mode(stdio_inherit), stdout_mode(stdio_inherit),
+      stderr_mode(stdio_inherit), fd_map()
+{ }
+
+berry::unix_like::spawned_process::spawned_process()
+    : proc(), stdin_fd(-1), stdout_fd(-1), stderr_fd(-1)
+{ }
+
+berry::unix_like::spawned_process::spawned_process(spawned_process&& other)
+    : proc(std::move(other.proc)), stdin_fd(other.stdin_fd),
+      stdout_fd(other.stdout_fd), stderr_fd(other.stderr_fd)
+{
+    other.stdin_fd = other.stdout_fd = other.stderr_fd = -1;
+}
+
+berry::unix_like::spawned_process::~spawned_process()
+{
+    pidfd::close(stdin_fd);
+    pidfd::close(stdout_fd);
+    pidfd::close(stderr_fd);
+}
+
+/******** Operators ********/
+berry::unix_like::spawned_process&
+    berry::unix_like::spawned_process::operator=(spawned_process&& other)
+{
+    if(this != &other)
+    {
+        pidfd::close(stdin_fd);
+        pidfd::close(stdout_fd);
+        pidfd::close(stderr_fd);
+        proc = std::move(other.proc);
+        stdin_fd = other.stdin_fd;
+        stdout_fd = other.stdout_fd;
+        stderr_fd = other.stderr_fd;
+        other.stdin_fd = other.stdout_fd = other.stderr_fd = -1;
+    }
+    return *this;
+}
+
+/******** Free functions ********/
+berry::unix_like::spawned_process berry::unix_like::spawn(
+    boost::filesystem::path const& executable,
+    berry::unix_like::spawn_options const& options)
+{
+    ::spawn_state state;
+
+    // Every descriptor the child receives is parked above the highest
+    // target first.
+    int floor = 3;
+    for(std::map<int, int>::const_iterator it = options.fd_map.begin();
+        it != options.fd_map.end(); ++it)
+    {
+        floor = std::max(floor, it->first + 1);
+    }
+
+    std::vector<std::pair<int, int> > mapped;
+    for(std::map<int, int>::const_iterator it = options.fd_map.begin();
+        it != options.fd_map.end(); ++it)
+    {
+        mapped.push_back(std::make_pair(state.park(it->second, floor),
+            it->first));
+    }
+
+    ::setup_stdio(state, options.stdin_mode, STDIN_FILENO, floor);
+    ::setup_stdio(state, options.stdout_mode, STDOUT_FILENO, floor);
+    ::setup_stdio(state, options.stderr_mode, STDERR_FILENO, floor);
+    for(std::size_t i = 0; i < mapped.size(); ++i)
+        state.add_dup2(mapped[i].first, mapped[i].second);
+
+    if(!options.working_directory.empty())
+    {
+        int const error = ::posix_spawn_file_actions_addchdir_np(
+            &state.actions, options.working_directory.c_str());
+        if(error)
+            ::throw_error(error, "berry::unix_like::spawn : "
+                "posix_spawn_file_actions_addchdir_np failed");
+    }
+
+    // The child starts with an empty signal mask and default handlers
+    // instead of inheriting the caller's.
+    sigset_t signals;
+    ::sigemptyset(&signals);
+    ::posix_spawnattr_setsigmask(&state.attributes, &signals);
+    ::sigfillset(&signals);
+    ::posix_spawnattr_setsigdefault(&state.attributes, &signals);
+    ::posix_spawnattr_setflags(&state.attributes,
+        POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    std::string const path = executable.string();
+    std::vector<char*> argv;
+    if(options.arguments.empty())
+        argv.push_back(const_cast<char*>(path.c_str()));
+    for(std::size_t i = 0; i < options.arguments.size(); ++i)
+        argv.push_back(const_cast<char*>(options.arguments[i].c_str()));
+    argv.push_back(0);
+
+    std::vector<char*> envp;
+    if(options.environment)
+    {
+        std::vector<std::string> const& environment = *options.environment;
+        for(std::size_t i = 0; i < environment.size(); ++i)
+            envp.push_back(const_cast<char*>(environment[i].c_str()));
+        envp.push_back(0);
+    }
+
+    ::pid_t pid;
+    int const error = ::posix_spawn(&pid, path.c_str(), &state.actions,
+        &state.attributes, argv.data(),
+        options.environment ? envp.data() : ::environ);
+    if(error)
+        ::throw_error(error, "berry::unix_like::spawn : posix_spawn failed");
+
+    // The child stays a zombie until it is waited for, so the pid can't be
+    // reused before the pidfd is opened.
+    berry::unix_like::spawned_process result;
+    result.proc = berry::process(pid);
+    result.stdin_fd = state.parent_fds[STDIN_FILENO];
+    result.stdout_fd = state.parent_fds[STDOUT_FILENO];
+    result.stderr_fd = state.parent_fds[STDERR_FILENO];
+    state.parent_fds[0] = state.parent_fds[1] = state.parent_fds[2] = -1;
+    return result;
+}
+
+berry::unix_like::exit_status berry::unix_like::wait_for_exit(
+    berry::process const& proc)
+{
+    berry::unix_like::exit_status status;
+    int const fd = berry::unix_like::get_pidfd(proc);
+    if(fd != -1)
+    {
+        ::siginfo_t info;
+        int result;
+        do
+            result = ::waitid(static_cast<idtype_t>(P_PIDFD), fd, &info,
+                WEXITED);
+        while(result == -1 && errno == EINTR);
+
+        if(result == 0)
+        {
+            status.exited = info.si_code == CLD_EXITED;
+            status.code = info.si_status;
+            return status;
+        }
+
+        // Kernels before 5.4 know pidfds but can't wait on them.
+        if(errno != EINVAL)
+            ::throw_error(errno, "berry::unix_like::wait_for_exit : "
+                "::waitid failed");
+    }
+
+    int raw;
+    ::pid_t result;
+    do
+        result = ::waitpid(proc.pid(), &raw, 0);
+    while(result == -1 && errno == EINTR);
+    if(result == -1)
+        ::throw_error(errno, "berry::unix_like::wait_for_exit : "
+            "::waitpid failed");
+
+    status.exited = WIFEXITED(raw);
+    status.code = status.exited ? WEXITSTATUS(raw) : WTERMSIG(raw);
+    return status;
+}
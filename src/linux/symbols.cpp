@@ -0,0 +1,379 @@
+/**
+ * @file linux/symbols.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief ELF symbol resolution for Linux.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <berry/detail/system.hpp>
+#ifndef BERRY_LINUX
+#   error "Attempt to compile source file on a wrong system"
+#endif
+
+// System:
+#include <elf.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// C++ Standard Library:
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/module.hpp>
+#include <berry/symbols.hpp>
+#include <berry/detail/procfs.hpp>
+
+/******** Free helper functions ********/
+namespace
+{
+    bool address_less(berry::elf_symbol const& lhs,
+        berry::elf_symbol const& rhs)
+    {
+        return lhs.address < rhs.address;
+    }
+
+    bool address_equal(berry::elf_symbol const& lhs,
+        berry::elf_symbol const& rhs)
+    {
+        return lhs.address == rhs.address;
+    }
+
+    bool symbol_above(std::uint64_t address, berry::elf_symbol const& symbol)
+    {
+        return address < symbol.address;
+    }
+
+    template<typename T>
+    T const* at(char const* data, std::size_t size, std::uint64_t offset,
+        std::uint64_t count = 1)
+    {
+        if(offset > size || count > (size - offset) / sizeof(T))
+            return 0;
+        return reinterpret_cast<T const*>(data + offset);
+    }
+
+    // Parses the symbols of one ELF class. Section headers and symbols are
+    // only read in place, nothing is copied but the address index.
+    template<typename Ehdr, typename Phdr, typename Shdr, typename Sym>
+    void parse_elf(char const* data, std::size_t size,
+        std::vector<berry::elf_symbol>& symbols, std::uint64_t& load_delta)
+    {
+        Ehdr const* ehdr = ::at<Ehdr>(data, size, 0);
+        if(!ehdr)
+            return;
+
+        // The first loadable segment tells how file offsets relate to
+        // virtual addresses.
+        Phdr const* phdrs = ::at<Phdr>(data, size, ehdr->e_phoff,
+            ehdr->e_phnum);
+        for(std::size_t i = 0; phdrs && i < ehdr->e_phnum; ++i)
+        {
+            if(phdrs[i].p_type == PT_LOAD)
+            {
+                std::uint64_t const mask = ~std::uint64_t(0xfff);
+                load_delta = (phdrs[i].p_vaddr & mask) -
+                    (phdrs[i].p_offset & mask);
+                break;
+            }
+        }
+
+        Shdr const* shdrs = ::at<Shdr>(data, size, ehdr->e_shoff,
+            ehdr->e_shnum);
+        if(!shdrs)
+            return;
+
+        for(std::size_t i = 0; i < ehdr->e_shnum; ++i)
+        {
+            Shdr const& section = shdrs[i];
+            if(section.sh_type != SHT_SYMTAB && section.sh_type != SHT_DYNSYM)
+                continue;
+            if(section.sh_link >= ehdr->e_shnum)
+                continue;
+
+            Shdr const& strings = shdrs[section.sh_link];
+            char const* names = ::at<char>(data, size, strings.sh_offset,
+                strings.sh_size);
+            std::size_t const count = section.sh_size / sizeof(Sym);
+            Sym const* syms = ::at<Sym>(data, size, section.sh_offset, count);
+            if(!names || !syms)
+                continue;
+
+            for(std::size_t j = 0; j < count; ++j)
+            {
+                Sym const& sym = syms[j];
+                unsigned char const type = sym.st_info & 0xf;
+                if(type != STT_FUNC && type != STT_OBJECT &&
+                    type != STT_GNU_IFUNC)
+                {
+                    continue;
+                }
+                if(sym.st_shndx == SHN_UNDEF || sym.st_value == 0 ||
+                    sym.st_name >= strings.sh_size)
+                {
+                    continue;
+                }
+
+                // Names must be terminated inside of the string table.
+                char const* name = names + sym.st_name;
+                if(!std::memchr(name, '\0', strings.sh_size - sym.st_name))
+                    continue;
+
+                berry::elf_symbol symbol;
+                symbol.address = sym.st_value;
+                symbol.size = sym.st_size;
+                symbol.name = name;
+                symbols.push_back(symbol);
+            }
+        }
+    }
+}
+
+/******** Constructors and Destructor ********/
+berry::symbol_table::symbol_table()
+    : m_mapping(0), m_mapping_size(0), m_load_delta(0), m_symbols()
+{ }
+
+berry::symbol_table::symbol_table(boost::filesystem::path const& path,
+    std::uint64_t device, std::uint64_t inode)
+    : m_mapping(0), m_mapping_size(0), m_load_delta(0), m_symbols()
+{
+    int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd == -1)
+        return;
+
+    load(fd, device, inode);
+    ::close(fd);
+}
+
+berry::symbol_table::symbol_table(int fd, std::uint64_t device,
+    std::uint64_t inode)
+    : m_mapping(0), m_mapping_size(0), m_load_delta(0), m_symbols()
+{
+    load(fd, device, inode);
+}
+
+berry::symbol_table::~symbol_table()
+{
+    if(m_mapping)
+        ::munmap(m_mapping, m_mapping_size);
+}
+
+berry::symbol_info::symbol_info()
+    : mod(0), symbol(0), offset(0)
+{ }
+
+berry::symbolizer::symbolizer(berry::process const& proc,
+    berry::symbol_cache& cache)
+    : m_modules(berry::get_modules(proc)), m_tables(m_modules.size())
+{
+    for(std::size_t i = 0; i < m_modules.size(); ++i)
+    {
+        if(m_modules[i].executable)
+            m_tables[i] = cache.get(proc, m_modules[i]);
+    }
+}
+
+/******** Member functions ********/
+void berry::symbol_table::load(int fd, std::uint64_t device,
+    std::uint64_t inode)
+{
+    struct ::stat info;
+    bool const usable = ::fstat(fd, &info) == 0 &&
+        S_ISREG(info.st_mode) && info.st_size >= EI_NIDENT &&
+        (device == 0 || (info.st_dev == device && info.st_ino == inode));
+    if(usable)
+    {
+        void* mapping = ::mmap(0, info.st_size, PROT_READ, MAP_PRIVATE,
+            fd, 0);
+        if(mapping != MAP_FAILED)
+        {
+            m_mapping = mapping;
+            m_mapping_size = info.st_size;
+        }
+    }
+    if(!m_mapping)
+        return;
+
+    char const* data = static_cast<char const*>(m_mapping);
+    if(std::memcmp(data, ELFMAG, SELFMAG) != 0)
+        return;
+
+    if(data[EI_CLASS] == ELFCLASS64)
+    {
+        ::parse_elf<Elf64_Ehdr, Elf64_Phdr, Elf64_Shdr, Elf64_Sym>(data,
+            m_mapping_size, m_symbols, m_load_delta);
+    }
+    else if(data[EI_CLASS] == ELFCLASS32)
+    {
+        ::parse_elf<Elf32_Ehdr, Elf32_Phdr, Elf32_Shdr, Elf32_Sym>(data,
+            m_mapping_size, m_symbols, m_load_delta);
+    }
+
+    // Symbols appear in both tables, keep one per address.
+    std::stable_sort(m_symbols.begin(), m_symbols.end(), &::address_less);
+    m_symbols.erase(std::unique(m_symbols.begin(), m_symbols.end(),
+        &::address_equal), m_symbols.end());
+    m_symbols.shrink_to_fit();
+}
+
+berry::elf_symbol const* berry::symbol_table::find(
+    std::uint64_t address) const
+{
+    std::vector<berry::elf_symbol>::const_iterator it = std::upper_bound(
+        m_symbols.begin(), m_symbols.end(), address, &::symbol_above);
+    if(it == m_symbols.begin())
+        return 0;
+
+    --it;
+    if(it->size != 0 && address >= it->address + it->size)
+        return 0;
+    return &*it;
+}
+
+std::uint64_t berry::symbol_table::load_bias(berry::remote_address base) const
+{
+    return base - m_load_delta;
+}
+
+std::vector<berry::elf_symbol> const& berry::symbol_table::symbols() const
+{
+    return m_symbols;
+}
+
+std::shared_ptr<berry::symbol_table const> berry::symbol_cache::get(
+    berry::process const& proc, berry::module const& mod)
+{
+    std::shared_ptr<entry> slot;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::shared_ptr<entry>& existing =
+            m_entries[key_type(mod.device, mod.inode)];
+        if(!existing)
+            existing = std::make_shared<entry>();
+        slot = existing;
+    }
+
+    // Parse outside of the lock, concurrent requests for the same file wait
+    // for the first one instead of parsing it again.
+    std::call_once(slot->loaded, [&]()
+    {
+        // Open the file through the process' root so files inside of
+        // containers are found. The inode check rejects wrong files.
+        int fd = berry::detail::procfs::open_process_file(
+            berry::unix_like::get_procfs_dirfd(proc), proc.pid(),
+            "root" + mod.path);
+        if(fd == -1)
+            fd = ::open(mod.path.c_str(), O_RDONLY | O_CLOEXEC);
+        std::shared_ptr<berry::symbol_table const> const table =
+            std::make_shared<berry::symbol_table>(fd, mod.device,
+                mod.inode);
+        if(fd != -1)
+            ::close(fd);
+        slot->table = table;
+    });
+    return slot->table;
+}
+
+std::size_t berry::symbol_cache::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+void berry::symbol_cache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+}
+
+boost::optional<berry::symbol_info> berry::symbolizer::resolve(
+    berry::remote_address address) const
+{
+    // Find the last module starting at or before the address.
+    std::size_t lo = 0, hi = m_modules.size();
+    while(lo < hi)
+    {
+        std::size_t const mid = lo + (hi - lo) / 2;
+        if(m_modules[mid].begin <= address)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if(lo == 0 || !m_modules[lo - 1].contains(address))
+        return boost::optional<berry::symbol_info>();
+
+    std::size_t const index = lo - 1;
+    berry::symbol_info info;
+    info.mod = &m_modules[index];
+    info.offset = address - info.mod->base;
+
+    berry::symbol_table const* table = m_tables[index].get();
+    if(table)
+    {
+        std::uint64_t const file_address =
+            address - table->load_bias(info.mod->base);
+        info.symbol = table->find(file_address);
+        if(info.symbol)
+            info.offset = file_address - info.symbol->address;
+    }
+    return info;
+}
+
+std::string berry::symbolizer::symbolize(berry::remote_address address) const
+{
+    char offset[32];
+    boost::optional<berry::symbol_info> info = resolve(address);
+    if(!info)
+    {
+        std::snprintf(offset, sizeof(offset), "0x%llx",
+            static_cast<unsigned long long>(address));
+        return offset;
+    }
+
+    std::snprintf(offset, sizeof(offset), "+0x%llx",
+        static_cast<unsigned long long>(info->offset));
+    std::string result(info->mod->name());
+    if(info->symbol)
+    {
+        result += '!';
+        result += info->symbol->name;
+    }
+    result += offset;
+    return result;
+}
+
+std::vector<berry::module> const& berry::symbolizer::modules() const
+{
+    return m_modules;
+}
+
+/******** Free functions ********/
+berry::symbol_cache& berry::default_symbol_cache()
+{
+    static berry::symbol_cache cache;
+    return cache;
+}
@@ -0,0 +1,426 @@
+/**
+ * @file linux/termination.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Batch signalling and subtree termination for Linux.
+ * 
+ * This file is part of Berry.
+ * 
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <berry/detail/system.hpp>
+#ifndef BERRY_LINUX
+#   error "Attempt to compile source file on a wrong system"
+#endif
+
+// System:
+#include <sys/epoll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+
+// C++ Standard Library:
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <set>
+#include <system_error>
+#include <vector>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/process_tree.hpp>
+#include <berry/termination.hpp>
+#include <berry/procfs_context.hpp>
+#include <berry/detail/pidfd.hpp>
+#include <berry/detail/procfs.hpp>
+
+namespace pidfd = berry::detail::pidfd;
+namespace procfs = berry::detail::procfs;
+
+/******** Free helper functions ********/
+namespace
+{
+    typedef std::chrono::steady_clock clock_type;
+    
+    // How long killed processes get to disappear before they are reported
+    // as survivors.
+    std::chrono::milliseconds const kill_timeout(1000);
+    
+    // Poll interval for processes without a pidfd.
+    int const poll_interval_ms = 10;
+    
+    // What batch termination keeps of a process: its pid and, where the
+    // kernel has them, a pidfd. The pidfd is borrowed from a process object
+    // or owned by a target_list, so copying a target never opens anything.
+    struct target
+    {
+        berry::pid_type pid;
+        int pidfd;
+        berry::process const* proc;
+    };
+    
+    // Owns the pidfds of processes opened for a teardown. A process object
+    // would also hold its ProcFS directory, and a large subtree then runs
+    // out of descriptors.
+    class target_list
+    {
+    private:
+        std::vector<target> m_targets;
+        
+    public:
+        target_list()
+            : m_targets()
+        { }
+        
+        ~target_list()
+        {
+            for(std::size_t i = 0; i < m_targets.size(); ++i)
+                pidfd::close(m_targets[i].pidfd);
+        }
+        
+        target_list(target_list const&) = delete;
+        target_list& operator=(target_list const&) = delete;
+        
+        std::vector<target>& get()
+        {
+            return m_targets;
+        }
+    };
+    
+    // Whether a pid still belongs to the process of a snapshot entry.
+    // Checked after opening a pidfd, a match means the pidfd refers to the
+    // process of the snapshot and not to one which got its pid since.
+    bool same_process(berry::unix_like::procfs_context const& context,
+        berry::process_entry const& entry)
+    {
+        char path[32];
+        std::snprintf(path, sizeof(path), "%d/stat", entry.pid);
+        char buffer[1024];
+        long const size = procfs::read_small_file(context.fd(), path, buffer,
+            sizeof(buffer));
+        procfs::stat_line line;
+        return size > 0 && procfs::parse_stat(buffer, buffer + size, line) &&
+            line.parent_pid == entry.parent_pid &&
+            line.start_time == entry.start_time;
+    }
+    
+    std::vector<target> make_targets(std::vector<berry::process> const& procs)
+    {
+        std::vector<target> targets(procs.size());
+        for(std::size_t i = 0; i < procs.size(); ++i)
+        {
+            targets[i].pid = procs[i].pid();
+            targets[i].pidfd = berry::unix_like::get_pidfd(procs[i]);
+            targets[i].proc = &procs[i];
+        }
+        return targets;
+    }
+    
+    bool send_signal(target const& proc, int sig)
+    {
+        if(proc.pidfd != -1)
+        {
+            if(pidfd::send_signal(proc.pidfd, sig) == 0)
+                return true;
+            if(errno != ENOSYS)
+                return false;
+        }
+        return ::kill(proc.pid, sig) == 0;
+    }
+    
+    bool still_exists(target const& proc)
+    {
+        if(proc.proc)
+            return proc.proc->still_exists();
+        if(proc.pidfd != -1)
+        {
+            if(pidfd::send_signal(proc.pidfd, 0) == 0 || errno == EPERM)
+                return true;
+            if(errno == ESRCH)
+                return false;
+        }
+        return ::kill(proc.pid, 0) == 0 || errno == EPERM;
+    }
+    
+    std::size_t signal_targets(std::vector<target> const& targets, int sig)
+    {
+        std::size_t delivered = 0;
+        for(std::size_t i = 0; i < targets.size(); ++i)
+        {
+            if(targets[i].proc && *targets[i].proc == berry::not_a_process)
+                continue;
+            if(::send_signal(targets[i], sig))
+                ++delivered;
+        }
+        return delivered;
+    }
+    
+    class epoll_handle
+    {
+    private:
+        int m_fd;
+        
+    public:
+        epoll_handle()
+            : m_fd(::epoll_create1(EPOLL_CLOEXEC))
+        {
+            if(m_fd == -1)
+            {
+                std::error_code error(errno, std::system_category());
+                throw std::system_error(error,
+                    "berry::unix_like::wait_for_exits : "
+                    "::epoll_create1 failed");
+            }
+        }
+        
+        ~epoll_handle()
+        {
+            ::close(m_fd);
+        }
+        
+        epoll_handle(epoll_handle const&) = delete;
+        epoll_handle& operator=(epoll_handle const&) = delete;
+        
+        int get() const
+        {
+            return m_fd;
+        }
+    };
+    
+    std::vector<bool> wait_for_targets(std::vector<target> const& targets,
+        std::chrono::milliseconds timeout)
+    {
+        std::vector<bool> exited(targets.size(), false);
+        std::vector<std::size_t> polled;
+        std::size_t pending = 0;
+        
+        ::epoll_handle epoll;
+        for(std::size_t i = 0; i < targets.size(); ++i)
+        {
+            if(targets[i].pidfd == -1)
+            {
+                polled.push_back(i);
+                ++pending;
+                continue;
+            }
+            
+            // A pidfd becomes readable once its process exits.
+            ::epoll_event event = ::epoll_event();
+            event.events = EPOLLIN;
+            event.data.u64 = i;
+            if(::epoll_ctl(epoll.get(), EPOLL_CTL_ADD, targets[i].pidfd,
+                &event) == 0)
+                ++pending;
+            else
+                exited[i] = !::still_exists(targets[i]);
+        }
+        
+        clock_type::time_point const deadline = clock_type::now() + timeout;
+        std::array< ::epoll_event, 256> events;
+        while(pending)
+        {
+            // Processes without pidfd are checked by hand every few ms.
+            for(std::size_t j = 0; j < polled.size(); ++j)
+            {
+                std::size_t const i = polled[j];
+                if(!exited[i] && !::still_exists(targets[i]))
+                {
+                    exited[i] = true;
+                    --pending;
+                }
+            }
+            if(!pending)
+                break;
+            
+            clock_type::time_point const now = clock_type::now();
+            if(now >= deadline)
+                break;
+            
+            int wait_ms = static_cast<int>(std::chrono::duration_cast<
+                std::chrono::milliseconds>(deadline - now).count()) + 1;
+            if(!polled.empty())
+                wait_ms = std::min(wait_ms, ::poll_interval_ms);
+            
+            int const count = ::epoll_wait(epoll.get(), events.data(),
+                static_cast<int>(events.size()), wait_ms);
+            if(count == -1)
+            {
+                if(errno == EINTR)
+                    continue;
+                std::error_code error(errno, std::system_category());
+                throw std::system_error(error,
+                    "berry::unix_like::wait_for_exits : ::epoll_wait failed");
+            }
+            
+            // Stop watching exited processes, their pidfds stay readable.
+            for(int j = 0; j < count; ++j)
+            {
+                std::size_t const i = events[j].data.u64;
+                ::epoll_ctl(epoll.get(), EPOLL_CTL_DEL, targets[i].pidfd, 0);
+                if(!exited[i])
+                {
+                    exited[i] = true;
+                    --pending;
+                }
+            }
+        }
+        return exited;
+    }
+    
+    berry::unix_like::termination_result terminate(
+        std::vector<target> const& targets, std::chrono::milliseconds grace,
+        bool already_stopped, bool freeze)
+    {
+        berry::unix_like::termination_result result;
+        if(freeze && !already_stopped)
+            ::signal_targets(targets, SIGSTOP);
+        
+        // Stopped processes only act on SIGTERM once continued.
+        ::signal_targets(targets, SIGTERM);
+        if(freeze)
+            ::signal_targets(targets, SIGCONT);
+        
+        std::vector<bool> exited = ::wait_for_targets(targets, grace);
+        
+        std::vector<target> remaining;
+        for(std::size_t i = 0; i < targets.size(); ++i)
+        {
+            if(exited[i])
+                result.terminated.push_back(targets[i].pid);
+            else
+                remaining.push_back(targets[i]);
+        }
+        if(remaining.empty())
+            return result;
+        
+        ::signal_targets(remaining, SIGKILL);
+        exited = ::wait_for_targets(remaining, ::kill_timeout);
+        for(std::size_t i = 0; i < remaining.size(); ++i)
+        {
+            if(exited[i])
+                result.killed.push_back(remaining[i].pid);
+            else
+                result.survivors.push_back(remaining[i].pid);
+        }
+        return result;
+    }
+}
+
+/******** Free functions ********/
+std::size_t berry::unix_like::signal_processes(
+    std::vector<berry::process> const& procs, int sig)
+{
+    return ::signal_targets(::make_targets(procs), sig);
+}
+
+std::vector<bool> berry::unix_like::wait_for_exits(
+    std::vector<berry::process> const& procs,
+    std::chrono::milliseconds timeout)
+{
+    return ::wait_for_targets(::make_targets(procs), timeout);
+}
+
+berry::unix_like::termination_result berry::unix_like::terminate_processes(
+    std::vector<berry::process> const& procs,
+    std::chrono::milliseconds grace, bool freeze)
+{
+    return ::terminate(::make_targets(procs), grace, false, freeze);
+}
+
+berry::unix_like::termination_result berry::unix_like::terminate_tree(
+    berry::pid_type root, std::chrono::milliseconds grace, bool freeze)
+{
+    return berry::unix_like::terminate_tree(berry::process_tree(), root,
+        grace, freeze);
+}
+
+berry::unix_like::termination_result berry::unix_like::terminate_tree(
+    berry::process_tree const& snapshot, berry::pid_type root,
+    std::chrono::milliseconds grace, bool freeze)
+{
+    std::shared_ptr<berry::unix_like::procfs_context const> const context =
+        procfs::context("berry::unix_like::terminate_tree");
+    berry::pid_type const self = berry::get_current_process().pid();
+    std::set<berry::pid_type> known;
+    std::vector<berry::pid_type> unopened;
+    ::target_list procs;
+    
+    // Opens and optionally stops every process of a subtree which isn't
+    // known yet. Only pidfds are opened, so the teardown needs one
+    // descriptor per process. Processes which exited or whose pid got
+    // reused since the snapshot are skipped, the pid is only signalled
+    // directly if the kernel lacks pidfds. Returns whether any process was
+    // added.
+    auto collect = [&](berry::process_tree const& tree) -> bool
+    {
+        std::vector<berry::pid_type> const pids = tree.subtree(root);
+        std::size_t const first = procs.get().size();
+        for(std::size_t i = 0; i < pids.size(); ++i)
+        {
+            if(pids[i] == self || known.count(pids[i]))
+                continue;
+            int fd = pidfd::open(pids[i]);
+            if(fd == -1 && errno != ENOSYS)
+            {
+                // Gone since the snapshot, or not openable, e.g. without
+                // descriptors left. Signalling the pid could hit another
+                // process, so the latter are reported as survivors.
+                if(errno != ESRCH)
+                {
+                    known.insert(pids[i]);
+                    unopened.push_back(pids[i]);
+                }
+                continue;
+            }
+            if(!::same_process(*context, *tree.find(pids[i])))
+            {
+                pidfd::close(fd);
+                continue;
+            }
+            known.insert(pids[i]);
+            ::target const added = { pids[i], fd, 0 };
+            procs.get().push_back(added);
+        }
+        if(freeze)
+        {
+            for(std::size_t i = first; i < procs.get().size(); ++i)
+                ::send_signal(procs.get()[i], SIGSTOP);
+        }
+        return procs.get().size() != first;
+    };
+    
+    // Without freezing, one snapshot is all we can do. With it, the stopped
+    // subtree is rescanned until no new children show up; a stopped process
+    // can't fork anymore, so this converges quickly.
+    if(collect(snapshot) && freeze)
+    {
+        std::size_t const max_rescans = 16;
+        for(std::size_t i = 0; i < max_rescans; ++i)
+        {
+            if(!collect(berry::process_tree()))
+                break;
+        }
+    }
+    
+    berry::unix_like::termination_result result =
+        ::terminate(procs.get(), grace, true, freeze);
+    result.survivors.insert(result.survivors.end(), unopened.begin(),
+        unopened.end());
+    return result;
+}
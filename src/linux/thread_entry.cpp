@@ -0,0 +1,179 @@
+/**
+ * @file linux/thread_entry.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Thread entry implementation for Linux. 
+ * 
+ * This file is part of Berry.
+ * 
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <berry/detail/system.hpp>
+#ifndef BERRY_LINUX
+#   error "Attempt to compile source file on a wrong system"
+#endif
+
+// C++ Standard Library:
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Boost Library:
+#include <boost/optional.hpp>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/thread_entry.hpp>
+#include <berry/detail/parallel.hpp>
+#include <berry/detail/procfs.hpp>
+
+namespace procfs = berry::detail::procfs;
+
+/******** Helper classes ********/
+struct thread_snapshot
+{
+    explicit thread_snapshot(berry::pid_type pid)
+        : context(procfs::context("thread_snapshot::thread_snapshot")),
+          pid(pid), tids(), next(0)
+    {
+        char path[64];
+        std::snprintf(path, sizeof(path), "%d/task", pid);
+        if(!procfs::list_numeric_entries(context->fd(), path, tids))
+            throw std::runtime_error(
+                "thread_snapshot::thread_snapshot : process not found");
+    }
+
+    std::shared_ptr<berry::unix_like::procfs_context const> context;
+    berry::pid_type pid;
+    std::vector<berry::pid_type> tids;
+    std::size_t next;
+};
+
+/******** Free helper functions ********/
+static void destroy_thread_snapshot(void* snap)
+{
+    delete static_cast< ::thread_snapshot*>(snap);
+}
+
+static std::chrono::microseconds ticks_to_time(std::uint64_t ticks)
+{
+    return std::chrono::microseconds(ticks * 1000000 / procfs::clock_ticks());
+}
+
+// Reads /proc/<pid>/task/<tid>/stat with the same allocation-free parser
+// used for process entries.
+static bool make_entry(int root, berry::pid_type pid, berry::pid_type tid,
+    berry::thread_entry& entry)
+{
+    char path[64];
+    std::snprintf(path, sizeof(path), "%d/task/%d/stat", pid, tid);
+
+    char buffer[1024];
+    long const size = procfs::read_small_file(root, path, buffer,
+        sizeof(buffer));
+    procfs::stat_line line;
+    if(size <= 0 || !procfs::parse_stat(buffer, buffer + size, line))
+        return false;
+
+    entry.tid = line.pid;
+    entry.pid = pid;
+    entry.name.assign(line.name, line.name_size);
+    entry.state = line.state;
+    entry.user_time = ::ticks_to_time(line.user_time);
+    entry.system_time = ::ticks_to_time(line.system_time);
+    entry.last_cpu = line.processor;
+    return true;
+}
+
+/******** Constructors and Destructor ********/
+berry::thread_entry::thread_entry()
+    :   tid(0), pid(0), name(), state('?'), user_time(0), system_time(0),
+        last_cpu(-1)
+{ }
+
+/******** Free functions ********/
+berry::thread_snapshot berry::create_thread_snapshot(berry::pid_type pid)
+{
+    return berry::thread_snapshot(new ::thread_snapshot(pid),
+        &::destroy_thread_snapshot);
+}
+
+boost::optional<berry::thread_entry> berry::extract_next_thread(
+    berry::thread_snapshot& snap)
+{
+    ::thread_snapshot* ss = static_cast< ::thread_snapshot*>(snap.get());
+    berry::thread_entry entry;
+    while(ss->next < ss->tids.size())
+    {
+        if(::make_entry(ss->context->fd(), ss->pid, ss->tids[ss->next++],
+            entry))
+            return entry;
+    }
+
+    return boost::optional<berry::thread_entry>();
+}
+
+std::vector<berry::thread_entry> berry::get_all_threads(unsigned workers)
+{
+    std::shared_ptr<berry::unix_like::procfs_context const> const context =
+        procfs::context("berry::get_all_threads");
+    int const root = context->fd();
+    std::vector<berry::pid_type> pids;
+    if(!context->list_processes(pids))
+        throw std::runtime_error(   "berry::get_all_threads : "
+                                    "procfs not correctly mounted");
+
+    // Every worker collects into its own vector, so the only shared state
+    // is the work counter.
+    workers = berry::detail::worker_count(workers, pids.size());
+    std::vector<std::vector<berry::thread_entry> > results(workers);
+    std::vector<std::vector<berry::pid_type> > tids(workers);
+
+    berry::detail::parallel_for(pids.size(), workers,
+        [&](unsigned worker, std::size_t i)
+        {
+            char path[64];
+            std::snprintf(path, sizeof(path), "%d/task", pids[i]);
+
+            std::vector<berry::pid_type>& task = tids[worker];
+            task.clear();
+            if(!procfs::list_numeric_entries(root, path, task))
+                return;
+
+            berry::thread_entry entry;
+            for(std::size_t j = 0; j < task.size(); ++j)
+            {
+                if(::make_entry(root, pids[i], task[j], entry))
+                    results[worker].push_back(entry);
+            }
+        });
+
+    std::size_t total = 0;
+    for(std::size_t i = 0; i < results.size(); ++i)
+        total += results[i].size();
+
+    std::vector<berry::thread_entry> result;
+    result.reserve(total);
+    for(std::size_t i = 0; i < results.size(); ++i)
+    {
+        result.insert(result.end(),
+            std::make_move_iterator(results[i].begin()),
+            std::make_move_iterator(results[i].end()));
+    }
+    return result;
+}
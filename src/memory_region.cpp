@@ -0,0 +1,42 @@
+/**
+ * @file memory_region.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Platform-independent part of the memory region API.
+ * 
+ * This file is part of Berry.
+ * 
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Berry:
+#include <berry/memory_region.hpp>
+
+/******** Constructors ********/
+berry::memory_region::memory_region()
+    :   begin(0), end(0), protection(), offset(0), device(0), inode(0),
+        path()
+{ }
+
+/******** Member functions ********/
+bool berry::memory_region::contains(berry::remote_address address) const
+{
+    return begin <= address && address < end;
+}
+
+std::uint64_t berry::memory_region::size() const
+{
+    return end - begin;
+}
@@ -0,0 +1,119 @@
+/**
+ * @file module.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Platform-independent part of the module API.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// C++ Standard Library:
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
+// Berry:
+#include <berry/memory_region.hpp>
+#include <berry/module.hpp>
+
+/******** Free helper functions ********/
+namespace
+{
+    bool begins_before(berry::module const& lhs, berry::module const& rhs)
+    {
+        return lhs.begin < rhs.begin;
+    }
+
+    bool is_file_backed(berry::memory_region const& region)
+    {
+        return region.inode != 0 && !region.path.empty() &&
+            region.path[0] != '[';
+    }
+}
+
+/******** Constructors ********/
+berry::module::module()
+    :   base(0), begin(0), end(0), executable(false), device(0), inode(0),
+        path()
+{ }
+
+/******** Member functions ********/
+bool berry::module::contains(berry::remote_address address) const
+{
+    return begin <= address && address < end;
+}
+
+std::string berry::module::name() const
+{
+    std::string::size_type const slash = path.rfind('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+/******** Free functions ********/
+std::vector<berry::module> berry::get_modules(
+    std::vector<berry::memory_region> const& regions)
+{
+    typedef std::pair<std::uint64_t, std::uint64_t> file_key;
+    std::map<file_key, std::size_t> by_file;
+    std::vector<berry::module> result;
+    std::vector<std::uint64_t> lowest_offsets;
+
+    for(std::size_t i = 0; i < regions.size(); ++i)
+    {
+        berry::memory_region const& region = regions[i];
+        if(!::is_file_backed(region))
+            continue;
+
+        std::pair<std::map<file_key, std::size_t>::iterator, bool> slot =
+            by_file.insert(std::make_pair(
+                file_key(region.device, region.inode), result.size()));
+        if(slot.second)
+        {
+            berry::module mod;
+            mod.base = region.begin - region.offset;
+            mod.begin = region.begin;
+            mod.end = region.end;
+            mod.device = region.device;
+            mod.inode = region.inode;
+            mod.path = region.path;
+            result.push_back(std::move(mod));
+            lowest_offsets.push_back(region.offset);
+        }
+
+        berry::module& mod = result[slot.first->second];
+        mod.begin = std::min(mod.begin, region.begin);
+        mod.end = std::max(mod.end, region.end);
+        mod.executable = mod.executable || region.protection.executable();
+
+        // The load base follows from the mapping of the lowest file offset.
+        std::uint64_t& lowest = lowest_offsets[slot.first->second];
+        if(region.offset < lowest)
+        {
+            lowest = region.offset;
+            mod.base = region.begin - region.offset;
+        }
+    }
+
+    std::sort(result.begin(), result.end(), &::begins_before);
+    return result;
+}
+
+std::vector<berry::module> berry::get_modules(berry::process const& proc)
+{
+    return berry::get_modules(berry::get_memory_regions(proc));
+}
@@ -32,6 +32,7 @@
 // Berry:
 #include <berry/process.hpp>
 #include <berry/process_entry.hpp>
+#include <berry/process_query.hpp>
 
 boost::optional<berry::process_entry> berry::get_entry_by_pid(
     berry::detail::process::pid_type pid)
@@ -55,6 +56,11 @@ boost::optional<berry::process_entry> berry::get_entry_by_pid(
 boost::optional<berry::process_entry> berry::get_entry_by_name(
     std::string const& name, bool case_sensitive)
 {
+#ifdef BERRY_HAS_PROCFS
+    // Only comm is read for processes which don't match.
+    return berry::process_query().with_name(name, case_sensitive)
+        .find_first();
+#else
     std::string::const_iterator name_begin = name.begin();
     std::string::const_iterator name_end = name.end();
     
@@ -90,4 +96,5 @@ boost::optional<berry::process_entry> berry::get_entry_by_name(
    
     // We have no match.
     return boost::optional<berry::process_entry>();
-}
\ No newline at end of file
+#endif
+}
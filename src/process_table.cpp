@@ -0,0 +1,80 @@
+/**
+ * @file process_table.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Immutable tables of process entries.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// C++ Standard Library:
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// Berry:
+#include <berry/process_entry.hpp>
+#include <berry/process_table.hpp>
+#include <berry/detail/snapshot_util.hpp>
+
+namespace snapshot_util = berry::detail::snapshot_util;
+
+/******** Constructors ********/
+berry::process_table::process_table()
+    : process_table(snapshot_util::drain_new())
+{ }
+
+berry::process_table::process_table(berry::process_snapshot& snap)
+    : process_table(snapshot_util::drain(snap))
+{ }
+
+berry::process_table::process_table(
+    std::vector<berry::process_entry> entries)
+    : m_entries(std::move(entries)),
+      m_created(std::chrono::steady_clock::now())
+{
+    std::sort(m_entries.begin(), m_entries.end(),
+        &snapshot_util::pid_less);
+}
+
+/******** Member functions ********/
+berry::process_entry const* berry::process_table::find(
+    berry::pid_type pid) const
+{
+    std::vector<berry::process_entry>::const_iterator it = std::lower_bound(
+        m_entries.begin(), m_entries.end(), pid,
+        &snapshot_util::entry_before);
+    if(it == m_entries.end() || it->pid != pid)
+        return 0;
+    return &*it;
+}
+
+std::vector<berry::process_entry> const&
+    berry::process_table::entries() const
+{
+    return m_entries;
+}
+
+std::size_t berry::process_table::size() const
+{
+    return m_entries.size();
+}
+
+std::chrono::steady_clock::time_point berry::process_table::created() const
+{
+    return m_created;
+}
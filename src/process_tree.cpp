@@ -0,0 +1,138 @@
+/**
+ * @file process_tree.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Parent/child relations of a process snapshot.
+ * 
+ * This file is part of Berry.
+ * 
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// C++ Standard Library:
+#include <algorithm>
+#include <vector>
+
+// Berry:
+#include <berry/process_entry.hpp>
+#include <berry/process_tree.hpp>
+#include <berry/detail/snapshot_util.hpp>
+
+namespace snapshot_util = berry::detail::snapshot_util;
+
+/******** Constructors ********/
+berry::process_tree::process_tree()
+    : m_entries(), m_child_offsets(), m_children()
+{
+    *this = berry::process_tree(snapshot_util::drain_new());
+}
+
+berry::process_tree::process_tree(berry::process_snapshot& snap)
+    : m_entries(), m_child_offsets(), m_children()
+{
+    *this = berry::process_tree(snapshot_util::drain(snap));
+}
+
+berry::process_tree::process_tree(std::vector<berry::process_entry> entries)
+    : m_entries(std::move(entries)), m_child_offsets(), m_children()
+{
+    std::sort(m_entries.begin(), m_entries.end(),
+        &snapshot_util::pid_less);
+    
+    // Count the children of every process, turn the counts into offsets
+    // and scatter the children into their parent's range.
+    std::size_t const n = m_entries.size();
+    std::vector<std::size_t> parents(n, n);
+    m_child_offsets.assign(n + 1, 0);
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        parents[i] = index_of(m_entries[i].parent_pid);
+        if(parents[i] != n && parents[i] != i)
+            ++m_child_offsets[parents[i] + 1];
+    }
+    for(std::size_t i = 0; i < n; ++i)
+        m_child_offsets[i + 1] += m_child_offsets[i];
+    
+    std::vector<std::size_t> fill(m_child_offsets.begin(),
+        m_child_offsets.end() - 1);
+    m_children.resize(m_child_offsets[n]);
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        if(parents[i] != n && parents[i] != i)
+            m_children[fill[parents[i]]++] = i;
+    }
+}
+
+/******** Member functions ********/
+std::size_t berry::process_tree::index_of(berry::pid_type pid) const
+{
+    std::vector<berry::process_entry>::const_iterator it = std::lower_bound(
+        m_entries.begin(), m_entries.end(), pid,
+        &snapshot_util::entry_before);
+    if(it == m_entries.end() || it->pid != pid)
+        return m_entries.size();
+    return it - m_entries.begin();
+}
+
+berry::process_entry const* berry::process_tree::find(
+    berry::pid_type pid) const
+{
+    std::size_t const index = index_of(pid);
+    return index == m_entries.size() ? 0 : &m_entries[index];
+}
+
+std::vector<berry::pid_type> berry::process_tree::children(
+    berry::pid_type pid) const
+{
+    std::vector<berry::pid_type> result;
+    std::size_t const index = index_of(pid);
+    if(index == m_entries.size())
+        return result;
+    
+    for(std::size_t i = m_child_offsets[index];
+        i < m_child_offsets[index + 1]; ++i)
+    {
+        result.push_back(m_entries[m_children[i]].pid);
+    }
+    return result;
+}
+
+std::vector<berry::pid_type> berry::process_tree::subtree(
+    berry::pid_type root) const
+{
+    std::vector<berry::pid_type> result;
+    std::size_t const index = index_of(root);
+    if(index == m_entries.size())
+        return result;
+    
+    // Breadth-first walk over entry indices.
+    std::vector<std::size_t> queue(1, index);
+    for(std::size_t q = 0; q < queue.size(); ++q)
+    {
+        std::size_t const current = queue[q];
+        result.push_back(m_entries[current].pid);
+        for(std::size_t i = m_child_offsets[current];
+            i < m_child_offsets[current + 1]; ++i)
+        {
+            queue.push_back(m_children[i]);
+        }
+    }
+    return result;
+}
+
+std::vector<berry::process_entry> const& berry::process_tree::entries() const
+{
+    return m_entries;
+}
@@ -0,0 +1,160 @@
+/**
+ * @file region_index.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Fast address to memory region lookups.
+ * 
+ * This file is part of Berry.
+ * 
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// C++ Standard Library:
+#include <cassert>
+#include <algorithm>
+#include <vector>
+
+// Berry:
+#include <berry/memory_region.hpp>
+#include <berry/region_index.hpp>
+
+/******** Free helper functions ********/
+namespace
+{
+    bool begins_before(berry::memory_region const& lhs,
+        berry::memory_region const& rhs)
+    {
+        return lhs.begin < rhs.begin;
+    }
+
+    // Lays out the sorted keys in Eytzinger order by an in-order walk of
+    // the implicit tree. Node k has its children at 2k and 2k + 1, slot 0 is
+    // unused.
+    std::size_t fill_eytzinger(std::vector<berry::memory_region> const& sorted,
+        std::vector<berry::remote_address>& keys,
+        std::vector<std::uint32_t>& ranks, std::size_t i, std::size_t k)
+    {
+        if(k < keys.size())
+        {
+            i = fill_eytzinger(sorted, keys, ranks, i, 2 * k);
+            keys[k] = sorted[i].begin;
+            ranks[k] = static_cast<std::uint32_t>(i);
+            ++i;
+            i = fill_eytzinger(sorted, keys, ranks, i, 2 * k + 1);
+        }
+        return i;
+    }
+}
+
+/******** Constructors ********/
+berry::region_index::region_index()
+    : m_regions(), m_keys(1), m_ranks(1)
+{ }
+
+berry::region_index::region_index(std::vector<berry::memory_region> regions)
+    : m_regions(std::move(regions)), m_keys(), m_ranks()
+{
+    std::sort(m_regions.begin(), m_regions.end(), &::begins_before);
+    m_keys.resize(m_regions.size() + 1);
+    m_ranks.resize(m_regions.size() + 1);
+    ::fill_eytzinger(m_regions, m_keys, m_ranks, 0, 1);
+}
+
+berry::region_index::region_index(berry::process const& proc)
+    : m_regions(), m_keys(), m_ranks()
+{
+    *this = berry::region_index(berry::get_memory_regions(proc));
+}
+
+/******** Member functions ********/
+berry::memory_region const* berry::region_index::lookup(
+    berry::remote_address address) const
+{
+    // Descend to a leaf, going right whenever the key is <= address. The
+    // path taken is encoded in the bits of k; dropping the trailing right
+    // turns and the last left turn yields the first key > address.
+    std::size_t const n = m_regions.size();
+    std::size_t k = 1;
+    while(k <= n)
+        k = 2 * k + (m_keys[k] <= address);
+    while(k & 1)
+        k >>= 1;
+    k >>= 1;
+
+    // The candidate is the last region starting at or before the address.
+    std::size_t const rank = k ? m_ranks[k] : n;
+    if(rank == 0)
+        return 0;
+
+    memory_region const& candidate = m_regions[rank - 1];
+    return candidate.contains(address) ? &candidate : 0;
+}
+
+void berry::region_index::lookup_sorted(berry::remote_address const* begin,
+    berry::remote_address const* end, berry::memory_region const** out) const
+{
+    std::size_t const n = m_regions.size();
+    std::size_t r = 0;
+    for(; begin != end; ++begin, ++out)
+    {
+        berry::remote_address const address = *begin;
+        assert(begin == end - 1 || address <= begin[1]);
+
+        // Gallop forward to the first region ending after the address, so
+        // sparse addresses over many regions don't degrade to a linear walk.
+        if(r < n && m_regions[r].end <= address)
+        {
+            std::size_t step = 1;
+            while(r + step < n && m_regions[r + step].end <= address)
+                step *= 2;
+
+            std::size_t lo = r + step / 2 + 1;
+            std::size_t hi = std::min(r + step, n);
+            while(lo < hi)
+            {
+                std::size_t const mid = lo + (hi - lo) / 2;
+                if(m_regions[mid].end <= address)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            r = lo;
+        }
+
+        *out = (r < n && m_regions[r].contains(address)) ? &m_regions[r] : 0;
+    }
+}
+
+std::vector<berry::memory_region const*> berry::region_index::lookup_sorted(
+    std::vector<berry::remote_address> const& addresses) const
+{
+    std::vector<berry::memory_region const*> result(addresses.size());
+    if(!addresses.empty())
+    {
+        lookup_sorted(addresses.data(), addresses.data() + addresses.size(),
+            result.data());
+    }
+    return result;
+}
+
+std::vector<berry::memory_region> const& berry::region_index::regions() const
+{
+    return m_regions;
+}
+
+std::size_t berry::region_index::size() const
+{
+    return m_regions.size();
+}
@@ -0,0 +1,137 @@
+/**
+ * @file remote_memory.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Platform-independent part of the remote memory API.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// C++ Standard Library:
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+// Boost Library:
+#include <boost/optional.hpp>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/remote_memory.hpp>
+
+/******** Constructors ********/
+berry::memory_transfer::memory_transfer()
+    : address(0), buffer(0), size(0), succeeded(false)
+{ }
+
+berry::memory_transfer::memory_transfer(remote_address address,
+    void* buffer, std::size_t size)
+    : address(address), buffer(buffer), size(size), succeeded(false)
+{ }
+
+berry::pointer_chain::pointer_chain()
+    : base(0), offsets()
+{ }
+
+berry::pointer_chain::pointer_chain(remote_address base,
+    std::vector<std::int64_t> offsets)
+    : base(base), offsets(std::move(offsets))
+{ }
+
+/******** Free functions ********/
+std::size_t berry::read_memory(berry::process const& proc,
+    std::vector<berry::memory_transfer>& transfers)
+{
+    if(transfers.empty())
+        return 0;
+    return berry::read_memory(proc, transfers.data(),
+        transfers.data() + transfers.size());
+}
+
+boost::optional<berry::remote_address> berry::resolve_pointer_chain(
+    berry::process const& proc, berry::pointer_chain const& chain,
+    std::size_t pointer_size)
+{
+    std::vector<berry::pointer_chain> chains(1, chain);
+    return berry::resolve_pointer_chains(proc, chains, pointer_size)[0];
+}
+
+std::vector<boost::optional<berry::remote_address> >
+    berry::resolve_pointer_chains(berry::process const& proc,
+        std::vector<berry::pointer_chain> const& chains,
+        std::size_t pointer_size)
+{
+    assert(pointer_size == 4 || pointer_size == 8);
+
+    std::vector<boost::optional<berry::remote_address> > result(
+        chains.size());
+    std::vector<berry::remote_address> current(chains.size());
+    std::size_t max_levels = 0;
+    for(std::size_t i = 0; i < chains.size(); ++i)
+    {
+        current[i] = chains[i].base;
+        if(chains[i].offsets.size() > max_levels)
+            max_levels = chains[i].offsets.size();
+    }
+
+    // Walk all chains in lockstep. Each level dereferences every chain which
+    // still has a pointer to follow, using one gathered read. The values are
+    // read into zeroed 64 bit slots, so 32 bit pointers are zero extended.
+    std::vector<std::uint64_t> values(chains.size());
+    std::vector<std::size_t> owners;
+    std::vector<berry::memory_transfer> transfers;
+    std::vector<bool> failed(chains.size(), false);
+    for(std::size_t level = 0; level + 1 < max_levels; ++level)
+    {
+        owners.clear();
+        transfers.clear();
+        for(std::size_t i = 0; i < chains.size(); ++i)
+        {
+            if(failed[i] || level + 1 >= chains[i].offsets.size())
+                continue;
+
+            values[i] = 0;
+            owners.push_back(i);
+            transfers.push_back(berry::memory_transfer(
+                current[i] + chains[i].offsets[level], &values[i],
+                pointer_size));
+        }
+
+        berry::read_memory(proc, transfers);
+        for(std::size_t j = 0; j < transfers.size(); ++j)
+        {
+            std::size_t const i = owners[j];
+            if(transfers[j].succeeded)
+                current[i] = values[i];
+            else
+                failed[i] = true;
+        }
+    }
+
+    // Apply the final offsets.
+    for(std::size_t i = 0; i < chains.size(); ++i)
+    {
+        if(failed[i])
+            continue;
+
+        berry::remote_address address = current[i];
+        if(!chains[i].offsets.empty())
+            address += chains[i].offsets.back();
+        result[i] = address;
+    }
+    return result;
+}
@@ -0,0 +1,109 @@
+/**
+ * @file snapshot_cache.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Sharing process tables between threads.
+ *
+ * This file is part of Berry.
+ *
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// C++ Standard Library:
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+// Berry:
+#include <berry/process_table.hpp>
+#include <berry/snapshot_cache.hpp>
+
+/******** Free helper functions ********/
+namespace
+{
+    berry::process_table snapshot_all()
+    {
+        return berry::process_table();
+    }
+}
+
+/******** Constructors ********/
+berry::snapshot_cache::snapshot_cache(
+    std::chrono::steady_clock::duration max_age, source_type source)
+    : m_current(), m_max_age(max_age),
+      m_source(source ? std::move(source) : source_type(&::snapshot_all)),
+      m_refresh_mutex(), m_refreshes(0)
+{ }
+
+/******** Member functions ********/
+std::shared_ptr<berry::process_table const> berry::snapshot_cache::rebuild()
+{
+    // Called with m_refresh_mutex held. Readers keep using the old table
+    // until the new one is published.
+    std::shared_ptr<berry::process_table const> table =
+        std::make_shared<berry::process_table const>(m_source());
+    std::atomic_store(&m_current, table);
+    ++m_refreshes;
+    return table;
+}
+
+std::shared_ptr<berry::process_table const> berry::snapshot_cache::get()
+{
+    std::shared_ptr<berry::process_table const> table =
+        std::atomic_load(&m_current);
+    if(table && std::chrono::steady_clock::now() - table->created() <
+        m_max_age)
+    {
+        return table;
+    }
+
+    // A stale table is still good enough for everyone but the caller that
+    // rebuilds it. Without any table there is nothing to hand out.
+    std::unique_lock<std::mutex> lock(m_refresh_mutex, std::defer_lock);
+    if(!table)
+        lock.lock();
+    else if(!lock.try_lock())
+        return table;
+
+    // Another caller might have rebuilt the table while we waited.
+    table = std::atomic_load(&m_current);
+    if(table && std::chrono::steady_clock::now() - table->created() <
+        m_max_age)
+    {
+        return table;
+    }
+    return rebuild();
+}
+
+std::shared_ptr<berry::process_table const>
+    berry::snapshot_cache::refresh()
+{
+    std::shared_ptr<berry::process_table const> const seen =
+        std::atomic_load(&m_current);
+    std::lock_guard<std::mutex> lock(m_refresh_mutex);
+
+    // A rebuild that finished while we waited is as new as ours would be.
+    std::shared_ptr<berry::process_table const> table =
+        std::atomic_load(&m_current);
+    if(table != seen)
+        return table;
+    return rebuild();
+}
+
+std::size_t berry::snapshot_cache::refreshes() const
+{
+    return m_refreshes;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file snapshot_util.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Helpers shared by the snapshot based process views.
+ * 
+ * This file is part of Berry.
+ * 
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// C++ Standard Library:
+#include <utility>
+#include <vector>
+
+// Boost Library:
+#include <boost/optional.hpp>
+
+// Berry:
+#include <berry/process_entry.hpp>
+#include <berry/detail/snapshot_util.hpp>
+
+/******** Free functions ********/
+bool berry::detail::snapshot_util::pid_less(
+    berry::process_entry const& lhs, berry::process_entry const& rhs)
+{
+    return lhs.pid < rhs.pid;
+}
+
+bool berry::detail::snapshot_util::entry_before(
+    berry::process_entry const& entry, berry::detail::process::pid_type pid)
+{
+    return entry.pid < pid;
+}
+
+std::vector<berry::process_entry> berry::detail::snapshot_util::drain(
+    berry::process_snapshot& snap)
+{
+    std::vector<berry::process_entry> result;
+    while(boost::optional<berry::process_entry> entry =
+        berry::extract_next_process(snap))
+    {
+        result.push_back(std::move(*entry));
+    }
+    return result;
+}
+
+#ifdef BERRY_LINUX
+std::vector<berry::process_entry> berry::detail::snapshot_util::drain_new(
+    unsigned fields)
+{
+    // A new snapshot starts at its first process, an empty one yields an
+    // empty vector instead of throwing like extract_first_process.
+    berry::process_snapshot snap = berry::create_process_snapshot(fields);
+    return berry::detail::snapshot_util::drain(snap);
+}
+#endif
+
+std::vector<berry::process_entry> berry::detail::snapshot_util::drain_new()
+{
+#ifdef BERRY_LINUX
+    return berry::detail::snapshot_util::drain_new(0);
+#else
+    berry::process_snapshot snap = berry::create_process_snapshot();
+    std::vector<berry::process_entry> result(
+        1, berry::extract_first_process(snap));
+    std::vector<berry::process_entry> rest(
+        berry::detail::snapshot_util::drain(snap));
+    result.insert(result.end(), rest.begin(), rest.end());
+    return result;
+#endif
+}
@@ -0,0 +1,76 @@
+/**
+ * @file thread_iterator.cpp
+ * @author Ethon aka Florian Erler (ethon [a-t] ethon.cc)
+ * @date 2012
+ * @version 1.0a
+ * @brief Thread Iterator implementation.
+ * 
+ * This file is part of Berry.
+ * 
+ * Berry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * Berry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with Berry. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// C++ Standard Library:
+#include <cassert>
+
+// Berry:
+#include <berry/thread_entry.hpp>
+#include <berry/thread_iterator.hpp>
+
+#ifdef BERRY_HAS_PROCFS
+
+/*** thread_iterator implementation ***/
+
+void berry::thread_iterator::increment()
+{
+   assert(m_snap && m_entry);
+   m_entry = berry::extract_next_thread(m_snap);
+}
+
+bool berry::thread_iterator::equal(berry::thread_iterator const& other) const
+{
+   return static_cast<bool>(m_entry) == static_cast<bool>(other.m_entry);
+}
+
+berry::thread_entry const& berry::thread_iterator::dereference() const
+{
+   return *m_entry;
+}
+      
+berry::thread_iterator::thread_iterator()
+   : m_snap(nullptr), m_entry()
+{ }    
+
+berry::thread_iterator::thread_iterator(berry::detail::process::pid_type pid)
+   :  m_snap(berry::create_thread_snapshot(pid)),
+      m_entry(berry::extract_next_thread(m_snap))
+{ }
+
+/*** thread_list implementation ***/
+
+berry::thread_list::thread_list(berry::detail::process::pid_type pid)
+   : m_pid(pid)
+{ }
+
+berry::thread_iterator berry::thread_list::begin() const
+{
+   return berry::thread_iterator(m_pid);
+}
+      
+berry::thread_iterator berry::thread_list::end() const
+{
+   return berry::thread_iterator();
+}
+
+#endif // BERRY_HAS_PROCFS
@@ -0,0 +1,420 @@
+#include <berry/detail/system.hpp>
+#ifdef BERRY_LINUX
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <sys/wait.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+// C++ Standard Library:
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Boost Library:
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE memory test
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/remote_memory.hpp>
+#include <berry/remote_ptr.hpp>
+#include <berry/memory_region.hpp>
+#include <berry/region_index.hpp>
+#include <berry/memory_usage.hpp>
+#include <berry/procfs_context.hpp>
+#include <berry/shared_mappings.hpp>
+
+using berry::process;
+
+namespace
+{
+   struct remote_node
+   {
+      char padding[12];
+      int value;
+      remote_node* next;
+   };
+
+   struct local_node
+   {
+      local_node() : value(0), next(0) { }
+
+      int value;
+      std::uint64_t next;
+   };
+
+   typedef berry::remote_layout<local_node,
+      BERRY_REMOTE_FIELD(local_node, value, offsetof(remote_node, value)),
+      BERRY_REMOTE_FIELD(local_node, next, offsetof(remote_node, next))>
+      node_layout;
+
+   berry::remote_address address_of(void const* ptr)
+   {
+      return reinterpret_cast<std::uintptr_t>(ptr);
+   }
+
+#ifdef BERRY_LINUX
+   // Makes a ProcFS tree the default until destroyed, a failing test
+   // doesn't leave the following ones reading a deleted tree.
+   class default_procfs_guard
+   {
+   private:
+      std::shared_ptr<berry::unix_like::procfs_context const> m_original;
+
+   public:
+      explicit default_procfs_guard(boost::filesystem::path const& root)
+         : m_original(berry::unix_like::get_default_procfs_context())
+      {
+         berry::unix_like::set_procfs_base(root);
+      }
+
+      ~default_procfs_guard()
+      {
+         berry::unix_like::set_default_procfs_context(m_original);
+      }
+
+      default_procfs_guard(default_procfs_guard const&) = delete;
+      default_procfs_guard& operator=(default_procfs_guard const&) = delete;
+   };
+#endif
+}
+
+BOOST_AUTO_TEST_SUITE(BerryMemoryAPI)
+
+// Test berry::read_memory
+BOOST_AUTO_TEST_CASE(BerryReadMemory)
+{
+   process const& self = berry::get_current_process();
+   int const source[3] = { 1, 2, 3 };
+   int target[3] = { 0, 0, 0 };
+
+   berry::read_memory(self, address_of(source), target, sizeof(target));
+   BOOST_CHECK_EQUAL(target[0], 1);
+   BOOST_CHECK_EQUAL(target[2], 3);
+   BOOST_CHECK_THROW(berry::read_memory(self, 0, target, sizeof(int)),
+      std::runtime_error);
+}
+
+// Test berry::read_memory with unreadable ranges in the batch
+BOOST_AUTO_TEST_CASE(BerryReadMemoryGathered)
+{
+   process const& self = berry::get_current_process();
+   int const a = 17, b = 42;
+   int x = 0, y = 0, z = 0;
+
+   std::vector<berry::memory_transfer> transfers;
+   transfers.push_back(berry::memory_transfer(address_of(&a), &x, sizeof(x)));
+   transfers.push_back(berry::memory_transfer(0, &y, sizeof(y)));
+   transfers.push_back(berry::memory_transfer(address_of(&b), &z, sizeof(z)));
+
+   BOOST_CHECK_EQUAL(berry::read_memory(self, transfers), 2u);
+   BOOST_CHECK(transfers[0].succeeded);
+   BOOST_CHECK(!transfers[1].succeeded);
+   BOOST_CHECK(transfers[2].succeeded);
+   BOOST_CHECK_EQUAL(x, 17);
+   BOOST_CHECK_EQUAL(z, 42);
+}
+
+// Test berry::remote_ptr and berry::read_layout
+BOOST_AUTO_TEST_CASE(BerryRemotePtr)
+{
+   process const& self = berry::get_current_process();
+   remote_node second = { {}, 2, 0 };
+   remote_node first = { {}, 1, &second };
+
+   berry::remote_ptr<remote_node> ptr(address_of(&first));
+   BOOST_CHECK_EQUAL(ptr.read(self).value, 1);
+   BOOST_CHECK_EQUAL(ptr.member<int>(offsetof(remote_node, value))
+      .read(self), 1);
+
+   local_node node;
+   berry::read_layout<node_layout>(self, ptr.address(), node);
+   BOOST_CHECK_EQUAL(node.value, 1);
+   BOOST_CHECK_EQUAL(node.next, address_of(&second));
+
+   std::vector<berry::remote_address> addresses;
+   addresses.push_back(address_of(&first));
+   addresses.push_back(0);
+   addresses.push_back(address_of(&second));
+   std::vector<bool> succeeded;
+   std::vector<local_node> nodes =
+      berry::read_layouts<node_layout>(self, addresses, &succeeded);
+   BOOST_REQUIRE_EQUAL(nodes.size(), 3u);
+   BOOST_CHECK(succeeded[0] && !succeeded[1] && succeeded[2]);
+   BOOST_CHECK_EQUAL(nodes[2].value, 2);
+}
+
+// Test berry::resolve_pointer_chains
+BOOST_AUTO_TEST_CASE(BerryResolvePointerChains)
+{
+   process const& self = berry::get_current_process();
+   remote_node third = { {}, 3, 0 };
+   remote_node second = { {}, 2, &third };
+   remote_node first = { {}, 1, &second };
+   remote_node* root = &first;
+
+   std::int64_t const next = offsetof(remote_node, next);
+   std::int64_t const value = offsetof(remote_node, value);
+
+   std::vector<berry::pointer_chain> chains;
+   chains.push_back(berry::pointer_chain(address_of(&root)));
+   chains.push_back(berry::pointer_chain(address_of(&root), { 0, value }));
+   chains.push_back(berry::pointer_chain(address_of(&root),
+      { 0, next, next, value }));
+   chains.push_back(berry::pointer_chain(address_of(&root),
+      { 0, next, next, next, next, value }));
+
+   std::vector<boost::optional<berry::remote_address> > resolved =
+      berry::resolve_pointer_chains(self, chains);
+   BOOST_REQUIRE_EQUAL(resolved.size(), 4u);
+   BOOST_CHECK(resolved[0] && *resolved[0] == address_of(&root));
+   BOOST_CHECK(resolved[1] && *resolved[1] == address_of(&first.value));
+   BOOST_CHECK(resolved[2] && *resolved[2] == address_of(&third.value));
+   BOOST_CHECK(!resolved[3]);
+}
+
+// Test berry::get_memory_regions
+BOOST_AUTO_TEST_CASE(BerryGetMemoryRegions)
+{
+   std::vector<berry::memory_region> regions(
+      berry::get_memory_regions(berry::get_current_process()));
+   BOOST_REQUIRE(!regions.empty());
+
+   bool found_stack = false;
+   for(std::size_t i = 0; i < regions.size(); ++i)
+   {
+      BOOST_CHECK(regions[i].begin < regions[i].end);
+      if(regions[i].path == "[stack]")
+      {
+         found_stack = true;
+         BOOST_CHECK(regions[i].protection.readable());
+         BOOST_CHECK(regions[i].protection.writable());
+      }
+   }
+   BOOST_CHECK(found_stack);
+}
+
+// Test berry::region_index
+BOOST_AUTO_TEST_CASE(BerryRegionIndex)
+{
+   std::vector<berry::memory_region> regions;
+   for(int i = 9; i >= 0; --i)
+   {
+      berry::memory_region region;
+      region.begin = 0x1000 * (2 * i + 1);
+      region.end = region.begin + 0x1000;
+      regions.push_back(region);
+   }
+
+   berry::region_index index(regions);
+   BOOST_CHECK_EQUAL(index.size(), 10u);
+   BOOST_CHECK(!index.lookup(0));
+   BOOST_CHECK(!index.lookup(0x2000));
+   BOOST_CHECK(!index.lookup(0x100000));
+   for(std::size_t i = 0; i < 10; ++i)
+   {
+      berry::remote_address const begin = 0x1000 * (2 * i + 1);
+      BOOST_REQUIRE(index.lookup(begin));
+      BOOST_CHECK_EQUAL(index.lookup(begin)->begin, begin);
+      BOOST_CHECK_EQUAL(index.lookup(begin + 0xfff)->begin, begin);
+   }
+
+   std::vector<berry::remote_address> addresses;
+   for(berry::remote_address a = 0; a < 0x16000; a += 0x800)
+      addresses.push_back(a);
+   std::vector<berry::memory_region const*> found(
+      index.lookup_sorted(addresses));
+   for(std::size_t i = 0; i < addresses.size(); ++i)
+      BOOST_CHECK_EQUAL(found[i], index.lookup(addresses[i]));
+
+   int local = 0;
+   berry::region_index self_index(berry::get_current_process());
+   berry::memory_region const* stack = self_index.lookup(
+      reinterpret_cast<std::uintptr_t>(&local));
+   BOOST_REQUIRE(stack);
+   BOOST_CHECK(stack->protection.writable());
+}
+
+#ifdef BERRY_LINUX
+// Test berry::get_memory_usage and berry::get_all_memory_usage
+BOOST_AUTO_TEST_CASE(BerryMemoryUsage)
+{
+   process self(berry::get_current_process());
+   boost::optional<berry::memory_usage> usage(
+      berry::get_memory_usage(self.pid()));
+   BOOST_REQUIRE(usage);
+   BOOST_CHECK_EQUAL(usage->pid, self.pid());
+   BOOST_CHECK(usage->rss > 0);
+   BOOST_CHECK(usage->pss > 0 && usage->pss <= usage->rss);
+   BOOST_CHECK(usage->uss <= usage->rss);
+
+   std::vector<berry::memory_usage> all(berry::get_all_memory_usage());
+   BOOST_CHECK(std::is_sorted(all.begin(), all.end(),
+      [](berry::memory_usage const& a, berry::memory_usage const& b)
+      {
+         return a.pid < b.pid;
+      }));
+   std::vector<berry::pid_type> pids(1, self.pid());
+   BOOST_CHECK(berry::sum_memory_usage(all, pids).pss > 0);
+
+   // A fake ProcFS: 4242 with smaps_rollup, 4243 with smaps only and
+   // 4244 without memory like a kernel thread.
+   boost::filesystem::path const root =
+      boost::filesystem::temp_directory_path() /
+      boost::filesystem::unique_path("berry-usage-%%%%-%%%%");
+   for(int pid = 4242; pid <= 4244; ++pid)
+      boost::filesystem::create_directories(root / std::to_string(pid));
+   std::ofstream((root / "4242" / "smaps_rollup").c_str())
+      << "00400000-7fff0000 ---p 00000000 00:00 0    [rollup]\n"
+      << "Rss:                 400 kB\nPss:                 300 kB\n"
+      << "Pss_Anon:            200 kB\nPss_File:            100 kB\n"
+      << "Pss_Shmem:             0 kB\nShared_Clean:        150 kB\n"
+      << "Shared_Dirty:         50 kB\nPrivate_Clean:        80 kB\n"
+      << "Private_Dirty:       120 kB\nAnonymous:           200 kB\n"
+      << "Swap:                 16 kB\nSwapPss:               8 kB\n";
+   std::ofstream((root / "4243" / "smaps").c_str())
+      << "00400000-00401000 r-xp 00000000 08:01 42   /bin/fake\n"
+      << "Rss:                   4 kB\nPss:                   2 kB\n"
+      << "Private_Clean:         1 kB\nVmFlags: rd ex mr mw me\n"
+      << "7ffd0000-7ffd1000 rw-p 00000000 00:00 0    [stack]\n"
+      << "Rss:                   8 kB\nPss:                   8 kB\n"
+      << "Private_Dirty:         8 kB\nAnonymous:             8 kB\n";
+   std::ofstream((root / "4244" / "smaps_rollup").c_str());
+
+   std::vector<berry::memory_usage> fake;
+   {
+      ::default_procfs_guard const guard(root);
+      fake = berry::get_all_memory_usage();
+   }
+   boost::filesystem::remove_all(root);
+
+   BOOST_REQUIRE_EQUAL(fake.size(), 2u);
+   BOOST_CHECK_EQUAL(fake[0].pid, 4242);
+   BOOST_CHECK_EQUAL(fake[0].rss, 400u * 1024);
+   BOOST_CHECK_EQUAL(fake[0].pss, 300u * 1024);
+   BOOST_CHECK_EQUAL(fake[0].pss_anon, 200u * 1024);
+   BOOST_CHECK_EQUAL(fake[0].pss_file, 100u * 1024);
+   BOOST_CHECK_EQUAL(fake[0].shared, 200u * 1024);
+   BOOST_CHECK_EQUAL(fake[0].uss, 200u * 1024);
+   BOOST_CHECK_EQUAL(fake[0].swap, 16u * 1024);
+   BOOST_CHECK_EQUAL(fake[0].swap_pss, 8u * 1024);
+   BOOST_CHECK_EQUAL(fake[1].pid, 4243);
+   BOOST_CHECK_EQUAL(fake[1].rss, 12u * 1024);
+   BOOST_CHECK_EQUAL(fake[1].pss, 10u * 1024);
+   BOOST_CHECK_EQUAL(fake[1].uss, 9u * 1024);
+   BOOST_CHECK_EQUAL(fake[1].anonymous, 8u * 1024);
+
+   pids.assign(1, 4242);
+   pids.push_back(4243);
+   pids.push_back(4244);
+   berry::memory_usage const sum(berry::sum_memory_usage(fake, pids));
+   BOOST_CHECK_EQUAL(sum.pid, 0);
+   BOOST_CHECK_EQUAL(sum.pss, 310u * 1024);
+   BOOST_CHECK_EQUAL(sum.uss, 209u * 1024);
+}
+
+// Test berry::shared_mapping_index
+BOOST_AUTO_TEST_CASE(BerrySharedMappingIndex)
+{
+   // A file mapped by this process and a forked child, a deleted file and
+   // a memfd mapped by this process only.
+   boost::filesystem::path const path =
+      boost::filesystem::temp_directory_path() /
+      boost::filesystem::unique_path("berry-shared-%%%%-%%%%");
+   std::size_t const size = 4 * 4096;
+   int const shared_fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0600);
+   BOOST_REQUIRE(shared_fd != -1);
+   BOOST_REQUIRE_EQUAL(::ftruncate(shared_fd, size), 0);
+   void* const shared = ::mmap(0, size, PROT_READ, MAP_SHARED, shared_fd, 0);
+   BOOST_REQUIRE(shared != MAP_FAILED);
+
+   boost::filesystem::path const deleted_path(path.string() + "-deleted");
+   int const deleted_fd = ::open(deleted_path.c_str(), O_RDWR | O_CREAT,
+      0600);
+   BOOST_REQUIRE(deleted_fd != -1);
+   BOOST_REQUIRE_EQUAL(::ftruncate(deleted_fd, 4096), 0);
+   void* const deleted = ::mmap(0, 4096, PROT_READ, MAP_SHARED, deleted_fd,
+      0);
+   BOOST_REQUIRE(deleted != MAP_FAILED);
+   boost::filesystem::remove(deleted_path);
+
+   int const memfd = ::memfd_create("berry-test", 0);
+   BOOST_REQUIRE(memfd != -1);
+   BOOST_REQUIRE_EQUAL(::ftruncate(memfd, 4096), 0);
+   void* const anonymous = ::mmap(0, 4096, PROT_READ, MAP_SHARED, memfd, 0);
+   BOOST_REQUIRE(anonymous != MAP_FAILED);
+
+   int sync[2];
+   BOOST_REQUIRE_EQUAL(::pipe(sync), 0);
+   pid_t const child = ::fork();
+   BOOST_REQUIRE(child != -1);
+   if(child == 0)
+   {
+      char byte;
+      ::close(sync[1]);
+      ::_exit(::read(sync[0], &byte, 1) == -1);
+   }
+   ::close(sync[0]);
+
+   berry::shared_mapping_index const index;
+   ::close(sync[1]);
+   int status = 0;
+   ::waitpid(child, &status, 0);
+
+   struct ::stat info;
+   BOOST_REQUIRE_EQUAL(::fstat(shared_fd, &info), 0);
+   berry::mapped_file const* file = index.find(info.st_dev, info.st_ino);
+   BOOST_REQUIRE(file);
+   BOOST_CHECK_EQUAL(file->path, path.string());
+   BOOST_CHECK_EQUAL(file->kind, berry::mapping_file);
+   BOOST_CHECK_EQUAL(file->processes, 2u);
+   BOOST_CHECK_EQUAL(file->mapped_bytes, 2 * size);
+   std::vector<berry::file_mapping> const mappings(index.mappings(*file));
+   BOOST_REQUIRE_EQUAL(mappings.size(), 2u);
+   for(std::size_t i = 0; i < mappings.size(); ++i)
+   {
+      BOOST_CHECK(mappings[i].pid == berry::get_current_process().pid() ||
+         mappings[i].pid == child);
+      BOOST_CHECK_EQUAL(mappings[i].begin, address_of(shared));
+      BOOST_CHECK_EQUAL(mappings[i].end - mappings[i].begin, size);
+   }
+   std::vector<berry::mapped_file const*> const shared_files(
+      index.shared_files());
+   BOOST_CHECK(std::find(shared_files.begin(), shared_files.end(), file) !=
+      shared_files.end());
+
+   BOOST_REQUIRE_EQUAL(::fstat(deleted_fd, &info), 0);
+   file = index.find(info.st_dev, info.st_ino);
+   BOOST_REQUIRE(file);
+   BOOST_CHECK_EQUAL(file->kind, berry::mapping_deleted);
+   BOOST_CHECK_EQUAL(file->path, deleted_path.string());
+   std::vector<berry::mapped_file const*> const deleted_files(
+      index.files_of_kind(berry::mapping_deleted));
+   BOOST_CHECK(std::find(deleted_files.begin(), deleted_files.end(), file)
+      != deleted_files.end());
+
+   BOOST_REQUIRE_EQUAL(::fstat(memfd, &info), 0);
+   file = index.find(info.st_dev, info.st_ino);
+   BOOST_REQUIRE(file);
+   BOOST_CHECK_EQUAL(file->kind, berry::mapping_memfd);
+   BOOST_CHECK_EQUAL(file->path, "/memfd:berry-test");
+   BOOST_CHECK(!index.find(info.st_dev, 0));
+
+   ::munmap(shared, size);
+   ::munmap(deleted, 4096);
+   ::munmap(anonymous, 4096);
+   ::close(shared_fd);
+   ::close(deleted_fd);
+   ::close(memfd);
+   boost::filesystem::remove(path);
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
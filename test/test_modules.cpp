@@ -0,0 +1,146 @@
+// C++ Standard Library:
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Boost Library:
+#include <boost/filesystem/operations.hpp>
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE modules test
+#include <boost/test/unit_test.hpp>
+
+// Berry:
+#include <berry/process.hpp>
+#include <berry/module.hpp>
+#include <berry/symbols.hpp>
+#include <berry/build_id.hpp>
+#include <berry/procfs_context.hpp>
+
+using berry::process;
+
+namespace
+{
+   template<typename F>
+   berry::remote_address address_of_function(F* function)
+   {
+      return reinterpret_cast<std::uintptr_t>(function);
+   }
+}
+
+BOOST_AUTO_TEST_SUITE(BerryModuleAPI)
+
+// Test berry::get_modules
+BOOST_AUTO_TEST_CASE(BerryGetModules)
+{
+   std::vector<berry::module> modules(
+      berry::get_modules(berry::get_current_process()));
+
+   bool found_berry = false;
+   for(std::size_t i = 0; i < modules.size(); ++i)
+   {
+      BOOST_CHECK(modules[i].begin < modules[i].end);
+      BOOST_CHECK(modules[i].base <= modules[i].begin);
+      if(modules[i].name() == "libberry.so")
+      {
+         found_berry = true;
+         BOOST_CHECK(modules[i].executable);
+      }
+   }
+   BOOST_CHECK(found_berry);
+}
+
+// Test berry::symbolizer
+BOOST_AUTO_TEST_CASE(BerrySymbolizer)
+{
+   process const& self = berry::get_current_process();
+   berry::symbol_cache cache;
+   berry::symbolizer symbols(self, cache);
+
+   berry::remote_address const address =
+      ::address_of_function(&berry::get_current_process);
+   std::string const name = symbols.symbolize(address);
+   std::cout << "Symbolized address: " << name << '\n';
+   BOOST_CHECK_EQUAL(name.find("libberry.so!"), 0u);
+   BOOST_CHECK(name.find("get_current_process") != std::string::npos);
+   BOOST_CHECK(name.find("+0x0") != std::string::npos);
+
+   boost::optional<berry::symbol_info> info =
+      symbols.resolve(::address_of_function(&std::malloc) + 1);
+   BOOST_REQUIRE(info && info->symbol);
+   BOOST_CHECK_EQUAL(info->offset, 1u);
+
+   BOOST_CHECK_EQUAL(symbols.symbolize(0), "0x0");
+
+   // A second process view shares the parsed tables.
+   std::size_t const cached = cache.size();
+   berry::symbolizer again(self, cache);
+   BOOST_CHECK_EQUAL(cache.size(), cached);
+}
+
+// Test berry::get_executable_build_id
+BOOST_AUTO_TEST_CASE(BerryGetExecutableBuildId)
+{
+   process const& self = berry::get_current_process();
+   berry::build_id_cache cache;
+
+   boost::optional<berry::build_id> id(
+      berry::get_executable_build_id(self, cache));
+   BOOST_REQUIRE(id);
+   std::cout << "Current process build-id: " << berry::to_hex(*id) << '\n';
+   BOOST_CHECK(!id->empty());
+   BOOST_CHECK_EQUAL(cache.size(), 1u);
+
+   boost::optional<berry::build_id> uncached(
+      berry::read_build_id(self.executable_path()));
+   BOOST_REQUIRE(uncached);
+   BOOST_CHECK(*id == *uncached);
+
+   berry::get_executable_build_id(self, cache);
+   BOOST_CHECK_EQUAL(cache.size(), 1u);
+}
+
+// Test berry::get_module_build_ids
+BOOST_AUTO_TEST_CASE(BerryGetModuleBuildIds)
+{
+   std::vector<std::pair<berry::module, boost::optional<berry::build_id> > >
+      ids(berry::get_module_build_ids(berry::get_current_process()));
+
+   bool found_berry = false;
+   for(std::size_t i = 0; i < ids.size(); ++i)
+   {
+      if(ids[i].first.name() == "libberry.so")
+         found_berry = static_cast<bool>(ids[i].second);
+   }
+   BOOST_CHECK(found_berry);
+}
+
+// Test that build-ids are read through the process' own ProcFS directory
+BOOST_AUTO_TEST_CASE(BerryBuildIdsThroughProcessDirectory)
+{
+   process const& self = berry::get_current_process();
+   berry::build_id_cache cache;
+   boost::optional<berry::build_id> const expected(
+      berry::get_executable_build_id(self, cache));
+   BOOST_REQUIRE(expected);
+
+   // The default context no longer knows the process.
+   boost::filesystem::path const root =
+      boost::filesystem::temp_directory_path() /
+      boost::filesystem::unique_path("berry-buildid-%%%%%%%%");
+   boost::filesystem::create_directories(root);
+   std::shared_ptr<berry::unix_like::procfs_context const> const original =
+      berry::unix_like::get_default_procfs_context();
+   berry::unix_like::set_procfs_base(root);
+   berry::build_id_cache fresh;
+   boost::optional<berry::build_id> const id(
+      berry::get_executable_build_id(self, fresh));
+   berry::unix_like::set_default_procfs_context(original);
+   boost::filesystem::remove_all(root);
+
+   BOOST_REQUIRE(id);
+   BOOST_CHECK(*id == *expected);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,7 +1,25 @@
+#include <berry/detail/system.hpp>
+#ifdef BERRY_LINUX
+#   include <sys/resource.h>
+#   include <sys/socket.h>
+#   include <sys/stat.h>
+#   include <fcntl.h>
+#   include <sys/wait.h>
+#   include <signal.h>
+#   include <unistd.h>
+#endif
+
 // C++ Standard Library:
+#include <algorithm>
+#include <chrono>
 #include <limits>
+#include <memory>
+#include <thread>
+#include <utility>
 #include <string>
+#include <system_error>
 #include <iostream>
+#include <fstream>
 
 // Boost Library:
 #define BOOST_TEST_DYN_LINK
@@ -13,9 +31,80 @@
 #include <berry/process.hpp>
 #include <berry/process_entry.hpp>
 #include <berry/process_iterator.hpp>
+#include <berry/thread_entry.hpp>
+#include <berry/thread_iterator.hpp>
+#include <berry/process_tree.hpp>
+#include <berry/termination.hpp>
+#include <berry/spawn.hpp>
+#include <berry/cgroup.hpp>
+#include <berry/pid_namespace.hpp>
+#include <berry/process_strings.hpp>
+#include <berry/process_query.hpp>
+#include <berry/cmdline_search.hpp>
+#include <berry/process_table.hpp>
+#include <berry/snapshot_cache.hpp>
+#include <berry/procfs_context.hpp>
+#include <berry/instrumentation.hpp>
+#include <berry/process_activity.hpp>
+#include <berry/open_files.hpp>
+#include <berry/memory_region.hpp>
 
 using berry::process;
 
+#ifdef BERRY_LINUX
+namespace
+{
+   // Creates an empty ProcFS tree in the temporary directory.
+   boost::filesystem::path make_fake_procfs(std::string const& name)
+   {
+      boost::filesystem::path const root =
+         boost::filesystem::temp_directory_path() /
+         boost::filesystem::unique_path("berry-" + name + "-%%%%-%%%%");
+      boost::filesystem::create_directories(root);
+      return root;
+   }
+
+   // Writes the stat file of a fake process, fields past the parent are
+   // zero except for the start time. Returns the process' directory.
+   boost::filesystem::path write_fake_stat(
+      boost::filesystem::path const& root, int pid, std::string const& name,
+      int parent_pid = 1, int start_time = 0)
+   {
+      boost::filesystem::path const dir = root / std::to_string(pid);
+      boost::filesystem::create_directories(dir);
+      std::ofstream stat((dir / "stat").c_str());
+      stat << pid << " (" << name << ") S " << parent_pid;
+      for(int field = 5; field <= 39; ++field)
+         stat << ' ' << (field == 22 ? start_time : 0);
+      stat << '\n';
+      return dir;
+   }
+
+   // Makes a ProcFS tree the default until destroyed, a failing test
+   // doesn't leave the following ones reading a deleted tree.
+   class default_procfs_guard
+   {
+   private:
+      std::shared_ptr<berry::unix_like::procfs_context const> m_original;
+
+   public:
+      explicit default_procfs_guard(boost::filesystem::path const& root)
+         : m_original(berry::unix_like::get_default_procfs_context())
+      {
+         berry::unix_like::set_procfs_base(root);
+      }
+
+      ~default_procfs_guard()
+      {
+         berry::unix_like::set_default_procfs_context(m_original);
+      }
+
+      default_procfs_guard(default_procfs_guard const&) = delete;
+      default_procfs_guard& operator=(default_procfs_guard const&) = delete;
+   };
+}
+#endif
+
 BOOST_AUTO_TEST_SUITE(BerryProcessAPI)
 
 // Test berry::get_name
@@ -115,5 +204,1193 @@ BOOST_AUTO_TEST_CASE(BerryGetEntryByName2)
    BOOST_CHECK_EQUAL(by_name1->pid, by_name2->pid);
 }
 
+#ifdef BERRY_LINUX
+// Test pidfd-backed process objects
+BOOST_AUTO_TEST_CASE(BerryProcessHandles)
+{
+   ::pid_t const child = ::fork();
+   BOOST_REQUIRE(child != -1);
+   if(child == 0)
+   {
+      ::pause();
+      ::_exit(0);
+   }
+   
+   process original(child);
+   BOOST_CHECK(original.still_exists());
+   BOOST_CHECK(berry::unix_like::get_procfs_dirfd(original) != -1);
+   
+   process copy(original);
+   BOOST_CHECK(copy == original);
+   BOOST_CHECK(berry::unix_like::get_pidfd(copy) !=
+      berry::unix_like::get_pidfd(original));
+   BOOST_CHECK_EQUAL(copy.name(), berry::get_current_process().name());
+   
+   process moved(std::move(original));
+   BOOST_CHECK(original == berry::not_a_process);
+   BOOST_CHECK(!original.still_exists());
+   BOOST_CHECK_EQUAL(moved.pid(), child);
+   
+   moved.terminate(true);
+   int status = 0;
+   BOOST_REQUIRE_EQUAL(::waitpid(child, &status, 0), child);
+   BOOST_CHECK(WIFSIGNALED(status));
+   BOOST_CHECK(!moved.still_exists());
+   BOOST_CHECK(!copy.still_exists());
+}
+#endif
+
+// Test berry::process_tree
+BOOST_AUTO_TEST_CASE(BerryProcessTree)
+{
+   process self(berry::get_current_process());
+   berry::process_tree tree;
+   
+   berry::process_entry const* entry = tree.find(self.pid());
+   BOOST_REQUIRE(entry);
+   BOOST_CHECK_EQUAL(entry->name, self.name());
+   
+   std::vector<berry::pid_type> siblings(tree.children(entry->parent_pid));
+   BOOST_CHECK(std::find(siblings.begin(), siblings.end(), self.pid()) !=
+      siblings.end());
+   
+   std::vector<berry::pid_type> subtree(tree.subtree(self.pid()));
+   BOOST_REQUIRE(!subtree.empty());
+   BOOST_CHECK_EQUAL(subtree[0], self.pid());
+}
+
+#ifdef BERRY_LINUX
+// Test berry::process_tree and berry::process_table on a ProcFS without
+// processes
+BOOST_AUTO_TEST_CASE(BerryProcessTreeEmpty)
+{
+   boost::filesystem::path const root = ::make_fake_procfs("empty");
+   {
+      ::default_procfs_guard const guard(root);
+      BOOST_CHECK(berry::process_tree().entries().empty());
+      BOOST_CHECK_EQUAL(berry::process_table().size(), 0u);
+      ::write_fake_stat(root, 4262, "second", 4261);
+      ::write_fake_stat(root, 4261, "first");
+      berry::process_table const table;
+      BOOST_REQUIRE_EQUAL(table.size(), 2u);
+      BOOST_CHECK_EQUAL(table.entries()[0].pid, 4261);
+      BOOST_CHECK_EQUAL(berry::process_tree().subtree(4261).size(), 2u);
+   }
+   boost::filesystem::remove_all(root);
+}
+#endif
+
+// Test berry::snapshot_cache
+BOOST_AUTO_TEST_CASE(BerrySnapshotCache)
+{
+   berry::process_table const table;
+   BOOST_CHECK(table.find(berry::get_current_process().pid()));
+   BOOST_CHECK(!table.find(std::numeric_limits<berry::pid_type>::max()));
+
+   berry::snapshot_cache cache(std::chrono::hours(1));
+   std::shared_ptr<berry::process_table const> first = cache.get();
+   BOOST_CHECK(first->find(berry::get_current_process().pid()));
+   BOOST_CHECK(cache.get() == first);
+   BOOST_CHECK(cache.refresh() != first);
+   BOOST_CHECK_EQUAL(cache.refreshes(), 2u);
+
+   // Concurrent requests for a missing table build it only once.
+   berry::snapshot_cache slow(std::chrono::hours(1), []()
+   {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      return berry::process_table(std::vector<berry::process_entry>());
+   });
+   std::vector<std::thread> readers;
+   std::vector<std::shared_ptr<berry::process_table const> > seen(8);
+   for(std::size_t i = 0; i < seen.size(); ++i)
+      readers.push_back(std::thread([&slow, &seen, i]()
+      {
+         seen[i] = slow.get();
+      }));
+   for(std::size_t i = 0; i < readers.size(); ++i)
+      readers[i].join();
+   BOOST_CHECK_EQUAL(slow.refreshes(), 1u);
+   for(std::size_t i = 0; i < seen.size(); ++i)
+      BOOST_CHECK(seen[i] == seen[0]);
+
+   // A stale table is handed out while it is being rebuilt.
+   berry::snapshot_cache stale(std::chrono::milliseconds(0));
+   std::shared_ptr<berry::process_table const> old = stale.get();
+   BOOST_CHECK(stale.get() != old);
+   BOOST_CHECK_EQUAL(stale.refreshes(), 2u);
+}
+
+// Test berry::get_instrumentation_stats
+BOOST_AUTO_TEST_CASE(BerryInstrumentation)
+{
+   berry::instrumentation_stats const before =
+      berry::get_instrumentation_stats();
+   process self(berry::get_current_process());
+   BOOST_CHECK(!self.name().empty());
+
+   // Counters of exited threads are kept.
+   std::thread([]()
+   {
+      berry::process_snapshot snap = berry::create_process_snapshot();
+      while(berry::extract_next_process(snap))
+         ;
+   }).join();
+
+   berry::instrumentation_stats const delta =
+      berry::get_instrumentation_stats() - before;
+   berry::api_stats const& name = delta.apis[berry::api_process_name];
+   berry::api_stats const& extract = delta.apis[berry::api_extract_process];
+   BOOST_CHECK_EQUAL(std::string(berry::get_api_name(
+      berry::api_process_name)), "process::name");
+   if(berry::instrumentation_enabled())
+   {
+      BOOST_CHECK_EQUAL(name.calls, 1u);
+      BOOST_CHECK_EQUAL(name.opens, 1u);
+      BOOST_CHECK(name.syscalls >= 3u);
+      BOOST_CHECK(name.bytes_read > 0u);
+      BOOST_CHECK_EQUAL(delta.apis[berry::api_create_snapshot].calls, 1u);
+      BOOST_CHECK(extract.calls > 1u);
+      BOOST_CHECK(extract.opens >= extract.calls - 1);
+      BOOST_CHECK(extract.nanoseconds > 0u);
+   }
+   else
+   {
+      BOOST_CHECK_EQUAL(name.calls, 0u);
+      BOOST_CHECK_EQUAL(extract.syscalls, 0u);
+   }
+}
+
+// Test berry::get_procfs_latency and berry::get_slow_operations
+BOOST_AUTO_TEST_CASE(BerryProcfsLatency)
+{
+   berry::latency_histogram const before =
+      berry::get_procfs_latency(berry::procfs_read_stat);
+   berry::set_slow_operation_threshold(std::chrono::nanoseconds(0));
+   berry::process_tree tree;
+   berry::set_slow_operation_threshold(std::chrono::milliseconds(10));
+   berry::latency_histogram const after =
+      berry::get_procfs_latency(berry::procfs_read_stat);
+   std::vector<berry::slow_operation> const slow =
+      berry::get_slow_operations();
+
+   // Every bucket's bounds are within 1/16 of each other.
+   for(std::size_t i = 1; i < berry::latency_histogram::bucket_count; ++i)
+   {
+      BOOST_REQUIRE(berry::latency_histogram::lower_bound(i) ==
+         berry::latency_histogram::upper_bound(i - 1) +
+         std::chrono::nanoseconds(1));
+   }
+   BOOST_CHECK(berry::latency_histogram().value_at_percentile(99) ==
+      std::chrono::nanoseconds(0));
+
+   if(berry::instrumentation_enabled())
+   {
+      BOOST_CHECK(after.count() >= before.count() + tree.entries().size());
+      BOOST_CHECK(after.value_at_percentile(50) > std::chrono::nanoseconds(0));
+      BOOST_CHECK(after.value_at_percentile(50) <=
+         after.value_at_percentile(99.9));
+      BOOST_REQUIRE(!slow.empty());
+      BOOST_CHECK(slow.size() <= 128u);
+      BOOST_CHECK_EQUAL(slow.back().operation, berry::procfs_read_stat);
+      BOOST_CHECK(slow.back().pid > 0);
+      BOOST_CHECK(std::string(slow.back().file).find("/stat") !=
+         std::string::npos);
+   }
+   else
+   {
+      BOOST_CHECK_EQUAL(after.count(), 0u);
+      BOOST_CHECK(slow.empty());
+   }
+}
+
+#ifdef BERRY_LINUX
+// Test berry::unix_like::terminate_tree
+BOOST_AUTO_TEST_CASE(BerryTerminateTree)
+{
+   ::pid_t const child = ::fork();
+   BOOST_REQUIRE(child != -1);
+   if(child == 0)
+   {
+      for(int i = 0; i < 3; ++i)
+      {
+         if(::fork() == 0)
+         {
+            // One grandchild ignores SIGTERM and has to be killed.
+            if(i == 0)
+               ::signal(SIGTERM, SIG_IGN);
+            for(;;)
+               ::pause();
+         }
+      }
+      for(;;)
+         ::pause();
+   }
+   
+   // Wait until all grandchildren show up.
+   std::size_t size = 0;
+   for(int i = 0; i < 500 && size != 4; ++i)
+   {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      size = berry::process_tree().subtree(child).size();
+   }
+   BOOST_REQUIRE_EQUAL(size, 4u);
+   
+   berry::unix_like::termination_result result =
+      berry::unix_like::terminate_tree(child,
+         std::chrono::milliseconds(200));
+   BOOST_CHECK_EQUAL(result.terminated.size(), 3u);
+   BOOST_CHECK_EQUAL(result.killed.size(), 1u);
+   BOOST_CHECK(result.survivors.empty());
+   
+   int status = 0;
+   BOOST_REQUIRE_EQUAL(::waitpid(child, &status, 0), child);
+   BOOST_CHECK(WIFSIGNALED(status));
+}
+#endif
+
+#ifdef BERRY_LINUX
+// Test berry::unix_like::terminate_tree with a member which exits after the
+// snapshot was taken
+BOOST_AUTO_TEST_CASE(BerryTerminateTreeStaleSnapshot)
+{
+   int fds[2];
+   BOOST_REQUIRE_EQUAL(::pipe(fds), 0);
+   ::pid_t const child = ::fork();
+   BOOST_REQUIRE(child != -1);
+   if(child == 0)
+   {
+      // Exited children get reaped by the kernel, the pid disappears.
+      ::signal(SIGCHLD, SIG_IGN);
+      ::pid_t const grandchild = ::fork();
+      if(grandchild == 0)
+      {
+         for(;;)
+            ::pause();
+      }
+      ::ssize_t const written = ::write(fds[1], &grandchild,
+         sizeof(grandchild));
+      (void)written;
+      for(;;)
+         ::pause();
+   }
+   ::close(fds[1]);
+   ::pid_t grandchild = 0;
+   BOOST_REQUIRE_EQUAL(::read(fds[0], &grandchild, sizeof(grandchild)),
+      ::ssize_t(sizeof(grandchild)));
+   ::close(fds[0]);
+   
+   berry::process_tree const snapshot;
+   BOOST_REQUIRE_EQUAL(snapshot.subtree(child).size(), 2u);
+   
+   BOOST_REQUIRE_EQUAL(::kill(grandchild, SIGKILL), 0);
+   for(int i = 0; i < 500 && ::kill(grandchild, 0) == 0; ++i)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+   BOOST_REQUIRE(::kill(grandchild, 0) == -1);
+   
+   berry::unix_like::termination_result result =
+      berry::unix_like::terminate_tree(snapshot, child,
+         std::chrono::milliseconds(200));
+   BOOST_REQUIRE_EQUAL(result.terminated.size(), 1u);
+   BOOST_CHECK_EQUAL(result.terminated[0], child);
+   BOOST_CHECK(result.killed.empty());
+   BOOST_CHECK(result.survivors.empty());
+   
+   int status = 0;
+   BOOST_REQUIRE_EQUAL(::waitpid(child, &status, 0), child);
+   BOOST_CHECK(WIFSIGNALED(status));
+}
+#endif
+
+#ifdef BERRY_LINUX
+// Test berry::unix_like::terminate_tree with a low descriptor limit
+BOOST_AUTO_TEST_CASE(BerryTerminateTreeFdLimit)
+{
+   // More processes than half the limit, two descriptors per process
+   // would run out.
+   int const count = 48;
+   ::rlim_t const limit = 64;
+   
+   ::pid_t const child = ::fork();
+   BOOST_REQUIRE(child != -1);
+   if(child == 0)
+   {
+      for(int i = 1; i < count; ++i)
+      {
+         if(::fork() == 0)
+         {
+            if(i % 2)
+               ::signal(SIGTERM, SIG_IGN);
+            for(;;)
+               ::pause();
+         }
+      }
+      for(;;)
+         ::pause();
+   }
+   
+   std::size_t size = 0;
+   for(int i = 0; i < 500 && size != std::size_t(count); ++i)
+   {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      size = berry::process_tree().subtree(child).size();
+   }
+   BOOST_REQUIRE_EQUAL(size, std::size_t(count));
+   
+   std::size_t const open_before = std::distance(
+      boost::filesystem::directory_iterator("/proc/self/fd"),
+      boost::filesystem::directory_iterator());
+   
+   ::rlimit original;
+   BOOST_REQUIRE_EQUAL(::getrlimit(RLIMIT_NOFILE, &original), 0);
+   BOOST_REQUIRE(open_before + count / 2 < limit);
+   ::rlimit lowered = original;
+   lowered.rlim_cur = limit;
+   BOOST_REQUIRE_EQUAL(::setrlimit(RLIMIT_NOFILE, &lowered), 0);
+   
+   berry::unix_like::termination_result result;
+   try
+   {
+      result = berry::unix_like::terminate_tree(child,
+         std::chrono::milliseconds(200));
+   }
+   catch(...)
+   {
+      ::setrlimit(RLIMIT_NOFILE, &original);
+      throw;
+   }
+   ::setrlimit(RLIMIT_NOFILE, &original);
+   
+   BOOST_CHECK_EQUAL(result.terminated.size() + result.killed.size(),
+      std::size_t(count));
+   BOOST_CHECK_EQUAL(result.killed.size(), std::size_t(count / 2));
+   BOOST_CHECK(result.survivors.empty());
+   
+   // The pidfds opened for the teardown are all closed again.
+   std::size_t const open_after = std::distance(
+      boost::filesystem::directory_iterator("/proc/self/fd"),
+      boost::filesystem::directory_iterator());
+   BOOST_CHECK_EQUAL(open_after, open_before);
+   
+   int status = 0;
+   BOOST_REQUIRE_EQUAL(::waitpid(child, &status, 0), child);
+   BOOST_CHECK(WIFSIGNALED(status));
+}
+#endif
+
+#ifdef BERRY_LINUX
+// Test berry::unix_like::spawn
+BOOST_AUTO_TEST_CASE(BerrySpawn)
+{
+   berry::unix_like::spawn_options options;
+   options.arguments.push_back("sh");
+   options.arguments.push_back("-c");
+   options.arguments.push_back("read line; echo \"$line $BERRY_TEST\"; "
+      "echo mapped >&5; exit 3");
+   options.environment = std::vector<std::string>(1, "BERRY_TEST=env");
+   options.stdin_mode = berry::unix_like::stdio_pipe;
+   options.stdout_mode = berry::unix_like::stdio_pipe;
+   options.stderr_mode = berry::unix_like::stdio_null;
+   
+   int mapped[2];
+   BOOST_REQUIRE_EQUAL(::pipe(mapped), 0);
+   options.fd_map[5] = mapped[1];
+   
+   berry::unix_like::spawned_process child =
+      berry::unix_like::spawn("/bin/sh", options);
+   ::close(mapped[1]);
+   BOOST_REQUIRE(child.proc.still_exists());
+   BOOST_REQUIRE(child.stdin_fd != -1);
+   BOOST_REQUIRE(child.stdout_fd != -1);
+   BOOST_CHECK_EQUAL(child.stderr_fd, -1);
+   
+   BOOST_REQUIRE_EQUAL(::write(child.stdin_fd, "hello\n", 6), 6);
+   
+   auto read_all = [](int fd)
+   {
+      std::string result;
+      char buffer[64];
+      ::ssize_t size;
+      while((size = ::read(fd, buffer, sizeof(buffer))) > 0)
+         result.append(buffer, size);
+      return result;
+   };
+   BOOST_CHECK_EQUAL(read_all(child.stdout_fd), "hello env\n");
+   BOOST_CHECK_EQUAL(read_all(mapped[0]), "mapped\n");
+   ::close(mapped[0]);
+   
+   berry::unix_like::exit_status status =
+      berry::unix_like::wait_for_exit(child.proc);
+   BOOST_CHECK(status.exited);
+   BOOST_CHECK_EQUAL(status.code, 3);
+   
+   BOOST_CHECK_THROW(berry::unix_like::spawn("/nonexistent/berry"),
+      std::system_error);
+}
+#endif
+
+#ifdef BERRY_LINUX
+// Test berry::create_cgroup_snapshot and berry::cgroup_index
+BOOST_AUTO_TEST_CASE(BerryCgroups)
+{
+   // A fake hierarchy: /app holds this process, /app/worker its parent.
+   process self(berry::get_current_process());
+   berry::pid_type const parent = ::getppid();
+   boost::filesystem::path const root =
+      boost::filesystem::temp_directory_path() /
+      boost::filesystem::unique_path("berry-cgroup-%%%%-%%%%");
+   boost::filesystem::create_directories(root / "app" / "worker");
+   boost::filesystem::create_directories(root / "other");
+   std::ofstream((root / "cgroup.procs").c_str()) << "";
+   std::ofstream((root / "app" / "cgroup.procs").c_str()) << self.pid() << '\n';
+   std::ofstream((root / "app" / "cgroup.threads").c_str())
+      << self.pid() << '\n' << self.pid() + 1 << '\n';
+   std::ofstream((root / "app" / "worker" / "cgroup.procs").c_str())
+      << parent << '\n';
+   std::ofstream((root / "other" / "cgroup.procs").c_str()) << "1\n";
+   berry::set_cgroup_root(root);
+   BOOST_CHECK(berry::get_cgroup_root() == root);
+   
+   std::vector<berry::pid_type> pids(berry::get_cgroup_processes("/app"));
+   BOOST_REQUIRE_EQUAL(pids.size(), 1u);
+   BOOST_CHECK_EQUAL(pids[0], self.pid());
+   BOOST_CHECK_EQUAL(berry::get_cgroup_processes("app/", true).size(), 2u);
+   BOOST_CHECK_EQUAL(berry::get_cgroup_threads("/app").size(), 2u);
+   BOOST_CHECK_THROW(berry::get_cgroup_processes("/missing"),
+      std::runtime_error);
+   
+   berry::process_snapshot snap(berry::create_cgroup_snapshot("/app", true));
+   berry::process_tree tree(snap);
+   BOOST_CHECK_EQUAL(tree.entries().size(), 2u);
+   BOOST_REQUIRE(tree.find(self.pid()));
+   BOOST_CHECK_EQUAL(tree.find(self.pid())->name, self.name());
+   BOOST_CHECK_EQUAL(tree.children(parent).size(), 1u);
+   
+   berry::cgroup_index index;
+   BOOST_CHECK_EQUAL(index.cgroups().size(), 4u);
+   BOOST_CHECK_EQUAL(index.size(), 3u);
+   BOOST_REQUIRE(index.find(self.pid()));
+   BOOST_CHECK_EQUAL(*index.find(self.pid()), "/app");
+   BOOST_REQUIRE(index.find(parent));
+   BOOST_CHECK_EQUAL(*index.find(parent), "/app/worker");
+   BOOST_CHECK(!index.find(2));
+   
+   berry::set_cgroup_root(boost::filesystem::path());
+   BOOST_CHECK(berry::get_cgroup_root() != root);
+   boost::filesystem::remove_all(root);
+}
+#endif
+
+#ifdef BERRY_LINUX
+// Test berry::pid_namespace_index
+BOOST_AUTO_TEST_CASE(BerryPidNamespaces)
+{
+   process self(berry::get_current_process());
+   struct ::stat info;
+   BOOST_REQUIRE_EQUAL(::stat("/proc/self/ns/pid", &info), 0);
+   
+   berry::process_snapshot snap(
+      berry::create_process_snapshot(berry::snapshot_namespaces));
+   std::vector<berry::process_entry> entries;
+   while(boost::optional<berry::process_entry> entry =
+      berry::extract_next_process(snap))
+   {
+      if(entry->pid == self.pid())
+      {
+         BOOST_CHECK_EQUAL(entry->pid_namespace, info.st_ino);
+         BOOST_REQUIRE(!entry->namespace_pids.empty());
+         BOOST_CHECK_EQUAL(entry->namespace_pids.front(), self.pid());
+      }
+      entries.push_back(*entry);
+   }
+   
+   berry::pid_namespace_index index(entries);
+   berry::namespaced_pid const* record = index.find(self.pid());
+   BOOST_REQUIRE(record);
+   BOOST_CHECK_EQUAL(record->pid_namespace, info.st_ino);
+   BOOST_CHECK(index.translate(info.st_ino, record->local_pid) ==
+      self.pid());
+   BOOST_CHECK(!index.translate(info.st_ino + 1, record->local_pid));
+   
+   std::vector<std::uint64_t> namespaces(index.namespaces());
+   BOOST_CHECK(std::find(namespaces.begin(), namespaces.end(), info.st_ino) !=
+      namespaces.end());
+   std::vector<berry::namespaced_pid> members(index.members(info.st_ino));
+   BOOST_CHECK(!members.empty());
+   for(std::size_t i = 0; i < members.size(); ++i)
+      BOOST_CHECK_EQUAL(members[i].pid_namespace, info.st_ino);
+   
+   // Plain snapshots don't pay for namespace information.
+   BOOST_CHECK_EQUAL(berry::get_entry_by_pid(self.pid())->pid_namespace, 0u);
+}
+#endif
+
+#if BERRY_HAS_PROCFS
+// Test berry::process_strings and berry::cmdline_column
+BOOST_AUTO_TEST_CASE(BerryProcessStrings)
+{
+   berry::unix_like::spawn_options options;
+   options.arguments.push_back("sh");
+   options.arguments.push_back("-c");
+   options.arguments.push_back("read line");
+   options.arguments.push_back("berry argument");
+   options.environment = std::vector<std::string>();
+   options.environment->push_back("BERRY_A=1");
+   options.environment->push_back("BERRY_KEY=some=value");
+   options.stdin_mode = berry::unix_like::stdio_pipe;
+   berry::unix_like::spawned_process child =
+      berry::unix_like::spawn("/bin/sh", options);
+   
+   // posix_spawn returns once the child dropped the parent's memory, which
+   // can be before exec set up the new command line.
+   berry::process_strings strings;
+   for(int i = 0; i < 500; ++i)
+   {
+      BOOST_REQUIRE(strings.read_cmdline(child.proc));
+      if(strings.size() == 4)
+         break;
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+   }
+   BOOST_REQUIRE_EQUAL(strings.size(), 4u);
+   BOOST_CHECK_EQUAL(boost::copy_range<std::string>(strings[3]),
+      "berry argument");
+   
+   BOOST_REQUIRE(strings.read_environ(child.proc.pid()));
+   BOOST_CHECK_EQUAL(strings.size(), 2u);
+   boost::optional<berry::string_range> value =
+      strings.find_variable("BERRY_KEY");
+   BOOST_REQUIRE(value);
+   BOOST_CHECK_EQUAL(boost::copy_range<std::string>(*value), "some=value");
+   BOOST_CHECK(!strings.find_variable("BERRY"));
+   BOOST_CHECK(!strings.find_variable("PATH"));
+   
+   std::vector<berry::pid_type> pids;
+   pids.push_back(child.proc.pid());
+   pids.push_back(std::numeric_limits<berry::pid_type>::max());
+   berry::cmdline_column column(pids);
+   BOOST_REQUIRE_EQUAL(column.size(), 2u);
+   BOOST_CHECK_EQUAL(column.pid(0), child.proc.pid());
+   std::vector<berry::string_range> arguments;
+   berry::split_strings(column.cmdline(0), arguments);
+   BOOST_REQUIRE_EQUAL(arguments.size(), 4u);
+   BOOST_CHECK_EQUAL(boost::copy_range<std::string>(arguments[2]),
+      "read line");
+   BOOST_CHECK(column.cmdline(1).empty());
+   
+   ::close(child.stdin_fd);
+   child.stdin_fd = -1;
+   BOOST_CHECK(berry::unix_like::wait_for_exit(child.proc).exited);
+}
+
+// Test berry::process_query
+BOOST_AUTO_TEST_CASE(BerryProcessQuery)
+{
+   process self(berry::get_current_process());
+   
+   // A name query reads comm of every process and stat of the matches only.
+   berry::query_statistics statistics;
+   std::vector<berry::process_entry> matches(berry::process_query()
+      .with_name(self.name()).find_all(&statistics));
+   BOOST_REQUIRE(!matches.empty());
+   BOOST_CHECK_EQUAL(statistics.files_read,
+      statistics.processes + matches.size());
+   BOOST_CHECK_EQUAL(statistics.stats, 0u);
+   
+   boost::optional<berry::process_entry> entry(berry::process_query()
+      .with_uid(::geteuid()).with_parent(::getppid())
+      .with_name(self.name()).find_first());
+   BOOST_REQUIRE(entry);
+   BOOST_CHECK_EQUAL(entry->pid, self.pid());
+   BOOST_CHECK(!berry::process_query().with_uid(::geteuid() + 1)
+      .with_parent(::getppid()).with_name(self.name()).find_first());
+   
+   // Directories owned by root, like those of non-dumpable processes, are
+   // matched by the effective uid in status.
+   boost::filesystem::path const root = ::make_fake_procfs("query");
+   std::ofstream((::write_fake_stat(root, 4242, "setuid") / "status")
+      .c_str()) << "Name:\tsetuid\nUid:\t0\t1000\t1000\t1000\n";
+   std::ofstream((::write_fake_stat(root, 4243, "daemon") / "status")
+      .c_str()) << "Name:\tdaemon\nUid:\t1000\t0\t0\t0\n";
+   berry::unix_like::procfs_context const fake(root);
+   if(::geteuid() == 0)
+   {
+      matches = berry::process_query().with_procfs(fake).with_uid(1000)
+         .find_all();
+      BOOST_REQUIRE_EQUAL(matches.size(), 1u);
+      BOOST_CHECK_EQUAL(matches[0].pid, 4242);
+      matches = berry::process_query().with_procfs(fake).with_uid(0)
+         .find_all();
+      BOOST_REQUIRE_EQUAL(matches.size(), 1u);
+      BOOST_CHECK_EQUAL(matches[0].pid, 4243);
+   }
+   boost::filesystem::remove_all(root);
+   
+   berry::unix_like::spawn_options options;
+   options.arguments.push_back("sh");
+   options.arguments.push_back("-c");
+   options.arguments.push_back("read line");
+   options.arguments.push_back("--berry-marker=42");
+   options.stdin_mode = berry::unix_like::stdio_pipe;
+   berry::unix_like::spawned_process child =
+      berry::unix_like::spawn("/bin/sh", options);
+   
+   berry::process_query query;
+   query.with_parent(self.pid()).with_cmdline("line --berry-marker=[0-9]+$");
+   for(int i = 0; i < 500 && query.find_all().empty(); ++i)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+   matches = query.find_all(&statistics);
+   BOOST_REQUIRE_EQUAL(matches.size(), 1u);
+   BOOST_CHECK_EQUAL(matches[0].pid, child.proc.pid());
+   BOOST_CHECK(statistics.files_read < 2 * statistics.processes);
+   BOOST_CHECK_THROW(query.with_cmdline("("), std::regex_error);
+   
+   ::close(child.stdin_fd);
+   child.stdin_fd = -1;
+   berry::unix_like::wait_for_exit(child.proc);
+}
+
+// Test berry::cmdline_pattern
+BOOST_AUTO_TEST_CASE(BerryCmdlinePattern)
+{
+   berry::cmdline_pattern regex("java .*-Dservice=fo+\\.bar?");
+   BOOST_CHECK_EQUAL(regex.literal(), "-Dservice=fo");
+   std::string line("/usr/bin/java -Xmx1g -Dservice=foo.ba -jar x.jar");
+   BOOST_CHECK(regex.matches(line.data(), line.data() + line.size()));
+   line = "/usr/bin/java -Dservice=bar";
+   BOOST_CHECK(!regex.matches(line.data(), line.data() + line.size()));
+   
+   BOOST_CHECK(berry::cmdline_pattern("a|bcd").literal().empty());
+   BOOST_CHECK_EQUAL(berry::cmdline_pattern("(x|y)zz[a-z]+w").literal(),
+      "zz");
+   
+   berry::cmdline_pattern glob("*java*-Dservice=[a-f]oo *",
+      berry::pattern_glob);
+   BOOST_CHECK_EQUAL(glob.literal(), "-Dservice=");
+   line = "java -Dservice=foo -jar x.jar";
+   BOOST_CHECK(glob.matches(line.data(), line.data() + line.size()));
+   line = "java -Dservice=zoo -jar x.jar";
+   BOOST_CHECK(!glob.matches(line.data(), line.data() + line.size()));
+   line = "java -Dservice=foo";
+   BOOST_CHECK(!glob.matches(line.data(), line.data() + line.size()));
+}
+
+// Test berry::search_cmdlines
+BOOST_AUTO_TEST_CASE(BerrySearchCmdlines)
+{
+   berry::unix_like::spawn_options options;
+   options.arguments.push_back("sh");
+   options.arguments.push_back("-c");
+   options.arguments.push_back("read line");
+   options.arguments.push_back("-Dberry.search=1");
+   options.stdin_mode = berry::unix_like::stdio_pipe;
+   berry::unix_like::spawned_process child =
+      berry::unix_like::spawn("/bin/sh", options);
+   
+   berry::cmdline_pattern pattern("^sh -c read line -Dberry\\.search=\\d$");
+   berry::cmdline_column matches(berry::search_cmdlines(pattern, 2));
+   for(int i = 0; i < 500 && matches.size() == 0; ++i)
+   {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      matches = berry::search_cmdlines(pattern, 2);
+   }
+   BOOST_REQUIRE_EQUAL(matches.size(), 1u);
+   BOOST_CHECK_EQUAL(matches.pid(0), child.proc.pid());
+   std::vector<berry::string_range> arguments;
+   berry::split_strings(matches.cmdline(0), arguments);
+   BOOST_CHECK_EQUAL(arguments.size(), 4u);
+   
+   ::close(child.stdin_fd);
+   child.stdin_fd = -1;
+   berry::unix_like::wait_for_exit(child.proc);
+}
+
+// Test berry::unix_like::procfs_context
+BOOST_AUTO_TEST_CASE(BerryProcfsContext)
+{
+   // A fake ProcFS tree with two processes, used next to the real one.
+   boost::filesystem::path const root = ::make_fake_procfs("procfs");
+   char const* const names[] = { "fake init", "fake (worker)" };
+   for(int i = 0; i < 2; ++i)
+   {
+      boost::filesystem::path const dir = ::write_fake_stat(root, 4242 + i,
+         names[i], i ? 4242 : 0);
+      std::ofstream((dir / "comm").c_str()) << names[i] << '\n';
+   }
+   boost::filesystem::create_directories(root / "self");
+
+   berry::unix_like::procfs_context const fake(root);
+   BOOST_CHECK_EQUAL(fake.root(), root);
+   std::vector<berry::pid_type> pids;
+   BOOST_REQUIRE(fake.list_processes(pids));
+   BOOST_CHECK_EQUAL(pids.size(), 2u);
+
+   berry::process_snapshot snap(berry::create_process_snapshot(0, fake));
+   berry::process_tree tree(snap);
+   BOOST_REQUIRE_EQUAL(tree.entries().size(), 2u);
+   BOOST_REQUIRE(tree.find(4243));
+   BOOST_CHECK_EQUAL(tree.find(4243)->name, "fake (worker)");
+   BOOST_CHECK_EQUAL(tree.children(4242).size(), 1u);
+
+   boost::optional<berry::process_entry> found(berry::process_query()
+      .with_procfs(fake).with_name("fake init").find_first());
+   BOOST_REQUIRE(found);
+   BOOST_CHECK_EQUAL(found->pid, 4242);
+
+   // The default context still reads the real ProcFS.
+   berry::process_tree real;
+   BOOST_CHECK(real.find(berry::get_current_process().pid()));
+   BOOST_CHECK_THROW(berry::unix_like::procfs_context(root / "missing"),
+      std::system_error);
+
+   {
+      ::default_procfs_guard const guard(root);
+      BOOST_CHECK(berry::process_query().with_name("fake init")
+         .find_first());
+   }
+   BOOST_CHECK(!berry::process_query().with_name("fake init").find_first());
+
+   boost::filesystem::remove_all(root);
+}
+
+// Test berry::create_process_snapshot with a read timeout
+BOOST_AUTO_TEST_CASE(BerryBoundedSnapshot)
+{
+   // The cmdline of 4242 is a FIFO without writer, opening it blocks like
+   // reading the cmdline of a process stuck with its mm lock held.
+   boost::filesystem::path const root = ::make_fake_procfs("bounded");
+   for(int pid = 4242; pid <= 4243; ++pid)
+      ::write_fake_stat(root, pid, "fake");
+   std::string const fifo = (root / "4242" / "cmdline").string();
+   BOOST_REQUIRE_EQUAL(::mkfifo(fifo.c_str(), 0600), 0);
+   std::ofstream((root / "4243" / "cmdline").c_str(), std::ios::binary)
+      << "fake" << '\0' << "--flag" << '\0';
+
+   std::vector<berry::process_entry> entries;
+   {
+      ::default_procfs_guard const guard(root);
+      auto const start = std::chrono::steady_clock::now();
+      berry::process_snapshot snap(berry::create_process_snapshot(
+         berry::snapshot_cmdline, std::chrono::milliseconds(100)));
+      while(boost::optional<berry::process_entry> entry =
+         berry::extract_next_process(snap))
+      {
+         entries.push_back(*entry);
+      }
+      BOOST_CHECK(std::chrono::steady_clock::now() - start <
+         std::chrono::seconds(5));
+   }
+
+   BOOST_REQUIRE_EQUAL(entries.size(), 2u);
+   if(entries[0].pid > entries[1].pid)
+      std::swap(entries[0], entries[1]);
+   BOOST_CHECK_EQUAL(entries[0].pid, 4242);
+   BOOST_CHECK(!entries[0].available);
+   BOOST_CHECK(entries[0].cmdline.empty());
+   BOOST_CHECK_EQUAL(entries[1].pid, 4243);
+   BOOST_CHECK(entries[1].available);
+   BOOST_CHECK_EQUAL(entries[1].cmdline, std::string("fake\0--flag\0", 12));
+
+   // Release the helper still blocked on the FIFO.
+   for(int i = 0; i < 100; ++i)
+   {
+      int const writer = ::open(fifo.c_str(), O_WRONLY | O_NONBLOCK);
+      if(writer != -1)
+      {
+         ::close(writer);
+         break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+   }
+   boost::filesystem::remove_all(root);
+
+   // Without timeout the real ProcFS is read synchronously.
+   berry::process_snapshot real(berry::create_process_snapshot(
+      berry::snapshot_cmdline));
+   bool found = false;
+   while(boost::optional<berry::process_entry> entry =
+      berry::extract_next_process(real))
+   {
+      if(entry->pid == berry::get_current_process().pid())
+      {
+         found = true;
+         BOOST_CHECK(entry->available);
+         BOOST_CHECK(!entry->cmdline.empty());
+      }
+   }
+   BOOST_CHECK(found);
+}
+
+// Test berry::process_strings::read_environ and
+// berry::get_memory_regions with a read timeout
+BOOST_AUTO_TEST_CASE(BerryBoundedReads)
+{
+   // 4242 has a maps FIFO, 4243 normal files and the others environ
+   // FIFOs, more than the pool has helpers.
+   boost::filesystem::path const root = ::make_fake_procfs("reads");
+   int const stuck = 20;
+   std::vector<std::string> fifos;
+   for(int pid = 4242; pid <= 4243 + stuck; ++pid)
+   {
+      boost::filesystem::path const dir = ::write_fake_stat(root, pid,
+         "fake");
+      if(pid == 4243)
+         continue;
+      fifos.push_back((dir / (pid == 4242 ? "maps" : "environ")).string());
+      BOOST_REQUIRE_EQUAL(::mkfifo(fifos.back().c_str(), 0600), 0);
+   }
+   std::ofstream((root / "4243" / "environ").c_str(), std::ios::binary)
+      << "A=1" << '\0' << "B=2" << '\0';
+   std::ofstream((root / "4243" / "maps").c_str())
+      << "00400000-00401000 r-xp 00000000 08:01 42   /bin/fake\n";
+
+   std::chrono::milliseconds const timeout(50);
+   ::default_procfs_guard const guard(root);
+   berry::process_strings strings;
+   BOOST_REQUIRE(strings.read_environ(4243, timeout));
+   BOOST_REQUIRE(strings.find_variable("B"));
+   BOOST_CHECK_EQUAL(boost::copy_range<std::string>(
+      *strings.find_variable("B")), "2");
+   BOOST_CHECK(!strings.read_environ(4242 + stuck + 10, timeout));
+   std::vector<berry::memory_region> const regions(
+      berry::get_memory_regions(process(4243), timeout));
+   BOOST_REQUIRE_EQUAL(regions.size(), 1u);
+   BOOST_CHECK_EQUAL(regions[0].path, "/bin/fake");
+
+   try
+   {
+      berry::get_memory_regions(process(4242), timeout);
+      BOOST_ERROR("reading the maps FIFO didn't time out");
+   }
+   catch(std::system_error const& error)
+   {
+      BOOST_CHECK(error.code() == std::errc::timed_out);
+   }
+
+   // Once every helper hangs, reads time out without waiting.
+   std::chrono::steady_clock::duration last(0);
+   for(int pid = 4244; pid <= 4243 + stuck; ++pid)
+   {
+      auto const start = std::chrono::steady_clock::now();
+      BOOST_CHECK_THROW(strings.read_environ(pid, timeout),
+         std::system_error);
+      last = std::chrono::steady_clock::now() - start;
+   }
+   BOOST_CHECK(last < timeout);
+
+   // Release the helpers, the pool serves reads again. FIFOs refused
+   // before reaching a helper never get a reader.
+   for(std::size_t i = 0; i < fifos.size(); ++i)
+   {
+      for(int j = 0; j < 10; ++j)
+      {
+         int const writer = ::open(fifos[i].c_str(), O_WRONLY | O_NONBLOCK);
+         if(writer != -1)
+         {
+            ::close(writer);
+            break;
+         }
+         std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+   }
+   bool recovered = false;
+   for(int i = 0; i < 100 && !recovered; ++i)
+   {
+      try
+      {
+         recovered = strings.read_environ(4243, timeout);
+      }
+      catch(std::system_error const&)
+      {
+         std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+   }
+   BOOST_CHECK(recovered);
+   boost::filesystem::remove_all(root);
+}
+
+// Test berry::create_process_snapshot with snapshot_batched
+BOOST_AUTO_TEST_CASE(BerryBatchedSnapshot)
+{
+   // More processes than one batch, every 7th without stat file.
+   boost::filesystem::path const root = ::make_fake_procfs("batched");
+   int const count = 300;
+   for(int i = 0; i < count; ++i)
+   {
+      if(i % 7 == 0)
+         boost::filesystem::create_directories(root / std::to_string(1000 + i));
+      else
+         ::write_fake_stat(root, 1000 + i, "batch " + std::to_string(i));
+   }
+
+   berry::latency_histogram const latency_before =
+      berry::get_procfs_latency(berry::procfs_read_stat);
+   berry::instrumentation_stats const stats_before =
+      berry::get_instrumentation_stats();
+   berry::unix_like::procfs_context const fake(root);
+   berry::process_snapshot snap(berry::create_process_snapshot(
+      berry::snapshot_batched, fake));
+   std::size_t found = 0;
+   while(boost::optional<berry::process_entry> entry =
+      berry::extract_next_process(snap))
+   {
+      int const i = entry->pid - 1000;
+      BOOST_CHECK(i % 7 != 0);
+      BOOST_CHECK_EQUAL(entry->name, "batch " + std::to_string(i));
+      BOOST_CHECK_EQUAL(entry->parent_pid, 1);
+      ++found;
+   }
+   BOOST_CHECK_EQUAL(found, static_cast<std::size_t>(count - count / 7 - 1));
+
+   // Batched reads show up in the statistics like synchronous ones.
+   if(berry::instrumentation_enabled())
+   {
+      berry::instrumentation_stats const delta =
+         berry::get_instrumentation_stats() - stats_before;
+      BOOST_CHECK(berry::get_procfs_latency(berry::procfs_read_stat).count()
+         >= latency_before.count() + count);
+      BOOST_CHECK(delta.apis[berry::api_extract_process].bytes_read >=
+         found * 50u);
+   }
+
+   // Restarting reads the first batch again.
+   BOOST_CHECK(berry::extract_first_process(snap).pid >= 1000);
+   boost::filesystem::remove_all(root);
+
+   berry::process_snapshot real(berry::create_process_snapshot(
+      berry::snapshot_batched));
+   bool found_self = false;
+   while(boost::optional<berry::process_entry> entry =
+      berry::extract_next_process(real))
+   {
+      if(entry->pid == berry::get_current_process().pid())
+      {
+         found_self = true;
+         BOOST_CHECK_EQUAL(entry->name,
+            berry::get_current_process().name());
+      }
+   }
+   BOOST_CHECK(found_self);
+}
+
+// Test berry::compute_activity and berry::activity_sampler
+BOOST_AUTO_TEST_CASE(BerryProcessActivity)
+{
+   boost::filesystem::path const root = ::make_fake_procfs("activity");
+   auto const write_sample = [&](int pid, int scale, int start_time)
+   {
+      boost::filesystem::path const dir = ::write_fake_stat(root, pid,
+         "fake", 1, start_time);
+      std::ofstream((dir / "io").c_str()) << "rchar: 1\nwchar: 2\n"
+         << "syscr: " << 10 * scale << "\nsyscw: " << 10 * scale << '\n'
+         << "read_bytes: " << 4096 * scale * (pid - 4240) << '\n'
+         << "write_bytes: " << 1024 * scale << '\n'
+         << "cancelled_write_bytes: 0\n";
+      std::ofstream((dir / "schedstat").c_str()) << 1000000000ll * scale
+         << ' ' << 1000000ll * scale * (4245 - pid) << ' ' << scale << '\n';
+   };
+   for(int pid = 4241; pid <= 4244; ++pid)
+      write_sample(pid, 1, 100);
+   berry::unix_like::procfs_context const fake(root);
+   unsigned const fields = berry::snapshot_io | berry::snapshot_schedstat;
+   berry::process_snapshot first(berry::create_process_snapshot(fields,
+      fake));
+   berry::process_table const before(first);
+
+   BOOST_REQUIRE(before.find(4242));
+   BOOST_CHECK_EQUAL(before.find(4242)->io.read_bytes, 8192u);
+   BOOST_CHECK_EQUAL(before.find(4242)->io.write_syscalls, 10u);
+   BOOST_CHECK_EQUAL(before.find(4242)->scheduler.wait_time, 3000000u);
+   BOOST_CHECK_EQUAL(before.find(4242)->scheduler.timeslices, 1u);
+   BOOST_CHECK_EQUAL(before.find(4242)->start_time, 100u);
+
+   // 4244 exits, 4241 is reused by a process which already has larger
+   // counters, 4245 is new.
+   for(int pid = 4242; pid <= 4243; ++pid)
+      write_sample(pid, 3, 100);
+   write_sample(4241, 5, 200);
+   boost::filesystem::remove_all(root / "4244");
+   write_sample(4245, 3, 200);
+   berry::process_snapshot second(berry::create_process_snapshot(fields,
+      fake));
+   berry::process_table after(second);
+   std::vector<berry::process_activity> const activity(
+      berry::compute_activity(before, after, std::chrono::seconds(2)));
+   boost::filesystem::remove_all(root);
+
+   BOOST_REQUIRE_EQUAL(activity.size(), 2u);
+   BOOST_CHECK_EQUAL(activity[0].pid, 4242);
+   BOOST_CHECK_EQUAL(activity[0].name, "fake");
+   BOOST_CHECK_EQUAL(activity[0].read_rate, 8192.0);
+   BOOST_CHECK_EQUAL(activity[0].write_rate, 1024.0);
+   BOOST_CHECK_EQUAL(activity[0].syscall_rate, 20.0);
+   BOOST_CHECK_CLOSE(activity[0].run_delay, 0.003, 1e-6);
+   BOOST_CHECK_CLOSE(activity[0].cpu_usage, 1.0, 1e-6);
+   BOOST_CHECK_EQUAL(activity[1].pid, 4243);
+
+   std::vector<berry::process_activity> const by_io(
+      berry::top_activity(activity, 2, berry::order_by_io_rate));
+   BOOST_REQUIRE_EQUAL(by_io.size(), 2u);
+   BOOST_CHECK_EQUAL(by_io[0].pid, 4243);
+   BOOST_CHECK_EQUAL(by_io[1].pid, 4242);
+   BOOST_CHECK_EQUAL(berry::top_activity(activity, 1,
+      berry::order_by_run_delay).front().pid, 4242);
+   BOOST_CHECK_EQUAL(berry::top_activity(activity, 10,
+      berry::order_by_cpu_usage).size(), 2u);
+
+   berry::activity_sampler sampler;
+   BOOST_CHECK(sampler.activity().empty());
+   std::this_thread::sleep_for(std::chrono::milliseconds(20));
+   sampler.sample();
+   bool found = false;
+   for(std::size_t i = 0; i < sampler.activity().size(); ++i)
+   {
+      berry::process_activity const& current = sampler.activity()[i];
+      BOOST_CHECK(current.cpu_usage >= 0);
+      found = found || current.pid == berry::get_current_process().pid();
+   }
+   BOOST_CHECK(found);
+   BOOST_CHECK(sampler.top(3, berry::order_by_cpu_usage).size() <= 3u);
+}
+
+// Test berry::compute_activity with counters which can't be compared
+BOOST_AUTO_TEST_CASE(BerryProcessActivityUnreadCounters)
+{
+   boost::filesystem::path const root = ::make_fake_procfs("counters");
+   auto const write_sample = [&](int pid, int scale)
+   {
+      boost::filesystem::path const dir = ::write_fake_stat(root, pid,
+         "fake", 1, 100);
+      std::ofstream((dir / "io").c_str()) << "rchar: 1\nwchar: 2\n"
+         << "syscr: " << 10 * scale << "\nsyscw: " << 10 * scale << '\n'
+         << "read_bytes: " << 4096 * scale << '\n'
+         << "write_bytes: " << 1024 * scale << '\n'
+         << "cancelled_write_bytes: 0\n";
+      std::ofstream((dir / "schedstat").c_str()) << 1000000000ll * scale
+         << ' ' << 1000000ll * scale << ' ' << scale << '\n';
+   };
+   write_sample(4251, 3);
+   write_sample(4252, 3);
+   berry::unix_like::procfs_context const fake(root);
+   unsigned const fields = berry::snapshot_io | berry::snapshot_schedstat;
+   berry::process_snapshot first(berry::create_process_snapshot(fields,
+      fake));
+   berry::process_table const before(first);
+   BOOST_REQUIRE(before.find(4251));
+   BOOST_CHECK_EQUAL(before.find(4251)->counters_read, fields);
+
+   // The counters of 4251 go down, the io file of 4252 can't be read any
+   // longer, as after the process became non-dumpable.
+   write_sample(4251, 1);
+   boost::filesystem::remove(root / "4252" / "io");
+   berry::process_snapshot second(berry::create_process_snapshot(fields,
+      fake));
+   berry::process_table const after(second);
+   std::vector<berry::process_activity> const activity(
+      berry::compute_activity(before, after, std::chrono::seconds(1)));
+   boost::filesystem::remove_all(root);
+
+   BOOST_REQUIRE(after.find(4252));
+   BOOST_CHECK_EQUAL(after.find(4252)->counters_read,
+      unsigned(berry::snapshot_schedstat));
+   BOOST_REQUIRE_EQUAL(activity.size(), 2u);
+   for(std::size_t i = 0; i < activity.size(); ++i)
+   {
+      BOOST_CHECK_EQUAL(activity[i].read_rate, 0.0);
+      BOOST_CHECK_EQUAL(activity[i].write_rate, 0.0);
+      BOOST_CHECK_EQUAL(activity[i].syscall_rate, 0.0);
+   }
+   BOOST_CHECK_EQUAL(activity[0].cpu_usage, 0.0);
+   BOOST_CHECK_EQUAL(activity[0].run_delay, 0.0);
+   BOOST_CHECK_EQUAL(activity[1].cpu_usage, 0.0);
+}
+
+// Test berry::get_open_files and berry::open_file_index
+BOOST_AUTO_TEST_CASE(BerryOpenFiles)
+{
+   int pipe_fds[2];
+   int socket_fds[2];
+   BOOST_REQUIRE_EQUAL(::pipe(pipe_fds), 0);
+   BOOST_REQUIRE_EQUAL(::socketpair(AF_UNIX, SOCK_STREAM, 0, socket_fds),
+      0);
+   struct ::stat pipe_info;
+   struct ::stat socket_info;
+   BOOST_REQUIRE_EQUAL(::fstat(pipe_fds[0], &pipe_info), 0);
+   BOOST_REQUIRE_EQUAL(::fstat(socket_fds[1], &socket_info), 0);
+   berry::pid_type const self = berry::get_current_process().pid();
+
+   std::vector<berry::open_file> const files(berry::get_open_files(self));
+   BOOST_CHECK(!files.empty());
+   bool found_pipe = false;
+   for(std::size_t i = 0; i < files.size(); ++i)
+   {
+      BOOST_CHECK(i == 0 || files[i - 1].fd < files[i].fd);
+      if(files[i].fd == pipe_fds[0])
+      {
+         found_pipe = true;
+         BOOST_CHECK_EQUAL(files[i].inode, pipe_info.st_ino);
+         BOOST_CHECK_EQUAL(files[i].target,
+            "pipe:[" + std::to_string(pipe_info.st_ino) + "]");
+      }
+   }
+   BOOST_CHECK(found_pipe);
+
+   berry::open_file_index const index;
+   BOOST_CHECK(index.size() >= files.size());
+   std::vector<berry::file_holder> holders(index.find(pipe_info.st_dev,
+      pipe_info.st_ino));
+   BOOST_REQUIRE_EQUAL(holders.size(), 2u);
+   BOOST_CHECK_EQUAL(holders[0].pid, self);
+   BOOST_CHECK_EQUAL(holders[0].fd, pipe_fds[0]);
+   BOOST_CHECK_EQUAL(holders[1].fd, pipe_fds[1]);
+
+   holders = index.find_socket(socket_info.st_ino);
+   BOOST_REQUIRE_EQUAL(holders.size(), 1u);
+   BOOST_CHECK_EQUAL(holders[0].pid, self);
+   BOOST_CHECK_EQUAL(holders[0].fd, socket_fds[1]);
+   BOOST_CHECK(index.find(pipe_info.st_dev, 0).empty());
+
+   ::close(pipe_fds[0]);
+   ::close(pipe_fds[1]);
+   ::close(socket_fds[0]);
+   ::close(socket_fds[1]);
+}
+
+// Test berry::thread_list
+BOOST_AUTO_TEST_CASE(BerryThreadList)
+{
+   process self(berry::get_current_process());
+   berry::thread_list threads(self.pid());
+   
+   std::size_t count = 0;
+   bool found_main = false;
+   for(berry::thread_iterator it = threads.begin(); it != threads.end(); ++it)
+   {
+      ++count;
+      BOOST_CHECK_EQUAL(it->pid, self.pid());
+      if(it->tid == self.pid())
+      {
+         found_main = true;
+         BOOST_CHECK_EQUAL(it->name, self.name());
+         BOOST_CHECK_EQUAL(it->state, 'R');
+         BOOST_CHECK(it->last_cpu >= 0);
+      }
+   }
+   BOOST_CHECK(found_main);
+   BOOST_CHECK(count >= 1);
+}
+
+// Test berry::get_all_threads
+BOOST_AUTO_TEST_CASE(BerryGetAllThreads)
+{
+   process self(berry::get_current_process());
+   std::vector<berry::thread_entry> threads(berry::get_all_threads());
+   
+   std::cout << "Threads on the system: " << threads.size() << '\n';
+   bool found_main = false;
+   for(std::size_t i = 0; i < threads.size(); ++i)
+      found_main = found_main || threads[i].tid == self.pid();
+   BOOST_CHECK(found_main);
+}
+#endif
+
 BOOST_AUTO_TEST_SUITE_END()
 